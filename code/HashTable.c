@@ -74,67 +74,393 @@ static U64 JenkinsHashFunction( const U8* key, U64 length, U64 seed ) {
 
 // --------------------------------------------------------------- //
 
+static U64 HashTableH1( U64 HashId ) {
+    return HashId >> 7;
+}
+
+static i8 HashTableH2( U64 HashId ) {
+    return (i8)(HashId & 0x7F);
+}
+
+static u32 HashTableCtz( u32 Mask ) {
+#if defined(_MSC_VER)
+    unsigned long Idx;
+    _BitScanForward( &Idx, Mask );
+    return (u32)Idx;
+#else
+    return (u32)__builtin_ctz( Mask );
+#endif
+}
+
+// Leading zeros of a HASH_TABLE_GROUP_WIDTH bit mask
+//
+static u32 HashTableClzGroup( u32 Mask ) {
+#if defined(_MSC_VER)
+    unsigned long Idx;
+    _BitScanReverse( &Idx, Mask );
+    return HASH_TABLE_GROUP_WIDTH - 1 - (u32)Idx;
+#else
+    return (u32)__builtin_clz( Mask ) - (32 - HASH_TABLE_GROUP_WIDTH);
+#endif
+}
+
+// Bit i set when control byte i of the group equals H2
+//
+static u32 HashTableGroupMatch( const i8* Group, i8 H2 ) {
+#if HASH_TABLE_GROUP_WIDTH == 32
+    __m256i Ctrl = _mm256_loadu_si256( (const __m256i*)Group );
+    return (u32)_mm256_movemask_epi8( _mm256_cmpeq_epi8( Ctrl, _mm256_set1_epi8( H2 ) ) );
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    __m128i Ctrl = _mm_loadu_si128( (const __m128i*)Group );
+    return (u32)_mm_movemask_epi8( _mm_cmpeq_epi8( Ctrl, _mm_set1_epi8( H2 ) ) );
+#else
+    u32 Mask = 0;
+    for( u32 i = 0; i < HASH_TABLE_GROUP_WIDTH; i += 1 ) {
+        Mask |= (u32)(Group[i] == H2) << i;
+    }
+    return Mask;
+#endif
+}
+
+// Bit i set when control byte i of the group is empty
+//
+static u32 HashTableGroupMatchEmpty( const i8* Group ) {
+    return HashTableGroupMatch( Group, HASH_TABLE_CTRL_EMPTY );
+}
+
+// Bit i set when control byte i is empty or deleted, both have the top bit set
+//
+static u32 HashTableGroupMatchFree( const i8* Group ) {
+#if HASH_TABLE_GROUP_WIDTH == 32
+    return (u32)_mm256_movemask_epi8( _mm256_loadu_si256( (const __m256i*)Group ) );
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    return (u32)_mm_movemask_epi8( _mm_loadu_si128( (const __m128i*)Group ) );
+#else
+    u32 Mask = 0;
+    for( u32 i = 0; i < HASH_TABLE_GROUP_WIDTH; i += 1 ) {
+        Mask |= (u32)(Group[i] < 0) << i;
+    }
+    return Mask;
+#endif
+}
+
+static void HashTableSetControl( i8* Control, U64 Allocated, U64 Idx, i8 Value ) {
+    Control[Idx] = Value;
+    if( Idx < HASH_TABLE_GROUP_WIDTH ) {
+        Control[Allocated + Idx] = Value;
+    }
+}
+
+// A stack only frees its last allocation, true when Ptr is it
+//
+static bool HashTableIsStackTop( Stack_Allocator* Stack, void* Ptr ) {
+    Stack_Allocation_Header* Header = (Stack_Allocation_Header*)((u8*)Ptr - sizeof(Stack_Allocation_Header));
+    return (u8*)Ptr - Header->padding == Stack->data + Stack->prev_offset;
+}
+
+// New arrays reuse the ones the last migration drained when they are the same
+// size, so tombstone rehashes cycle between two arrays. Otherwise those are
+// popped off the stack when nothing was pushed after them, and only if that
+// is not possible they stay behind until the allocator is reset.
+//
+static void HashTableAllocSlots( hash_table *Table, U64 Slots ) {
+    i8*    Control = NULL;
+    entry* Entries = NULL;
+
+    if( Table->SpareControl != NULL ) {
+        if( Table->SpareAllocated == Slots ) {
+            Control = Table->SpareControl;
+            Entries = Table->SpareEntries;
+        } else if( HashTableIsStackTop( Table->Allocator, Table->SpareEntries ) ) {
+            stack_free( Table->Allocator, Table->SpareEntries );
+            if( HashTableIsStackTop( Table->Allocator, Table->SpareControl ) ) {
+                stack_free( Table->Allocator, Table->SpareControl );
+            }
+        }
+        Table->SpareControl   = NULL;
+        Table->SpareEntries   = NULL;
+        Table->SpareAllocated = 0;
+    }
+
+    if( Control == NULL ) {
+        Control = stack_push( Table->Allocator, i8, Slots + HASH_TABLE_GROUP_WIDTH );
+        Entries = stack_push( Table->Allocator, entry, Slots );
+    }
+
+    Table->Allocated   = Slots;
+    Table->SlotsFilled = 0;
+    Table->Control     = Control;
+    Table->Entries     = Entries;
+    assert( Table->Control != NULL && Table->Entries != NULL && "Hash table does not fit in its allocator" );
+
+    memset( Table->Control, HASH_TABLE_CTRL_EMPTY, Slots + HASH_TABLE_GROUP_WIDTH );
+}
+
+// Groups are visited with triangular steps, with a power of two number of
+// slots that reaches every group before coming back to the first one.
+// Returns the slot index or Allocated when HashId is not there.
+//
+static U64 HashTableFindSlot( const i8* Control, const entry* Entries, U64 Allocated, U64 HashId ) {
+    U64 Mask = Allocated - 1;
+    U64 Pos  = HashTableH1( HashId ) & Mask;
+    i8  H2   = HashTableH2( HashId );
+
+    for( U64 Step = 0; Step < Allocated; ) {
+        const i8* Group = Control + Pos;
+
+        u32 Match = HashTableGroupMatch( Group, H2 );
+        while( Match != 0 ) {
+            U64 Idx = (Pos + HashTableCtz( Match )) & Mask;
+            if( Entries[Idx].HashId == HashId ) {
+                return Idx;
+            }
+            Match &= Match - 1;
+        }
+
+        if( HashTableGroupMatchEmpty( Group ) != 0 ) {
+            return Allocated;
+        }
+
+        Step += HASH_TABLE_GROUP_WIDTH;
+        Pos   = (Pos + Step) & Mask;
+    }
+
+    return Allocated;
+}
+
+static entry* HashTableFindHash( hash_table *Table, U64 HashId ) {
+    U64 Idx = HashTableFindSlot( Table->Control, Table->Entries, Table->Allocated, HashId );
+    if( Idx != Table->Allocated ) {
+        return &Table->Entries[Idx];
+    }
+
+    if( Table->OldControl != NULL ) {
+        Idx = HashTableFindSlot( Table->OldControl, Table->OldEntries, Table->OldAllocated, HashId );
+        if( Idx != Table->OldAllocated ) {
+            return &Table->OldEntries[Idx];
+        }
+    }
+
+    return NULL;
+}
+
+// A slot can go straight back to empty when no probe ever went past it: that is
+// when the window of HASH_TABLE_GROUP_WIDTH slots around it was never full.
+// Otherwise it becomes a tombstone so longer probe chains keep working.
+// Returns true when the slot is empty again.
+//
+static bool HashTableEraseSlot( i8* Control, U64 Allocated, U64 Idx ) {
+    U64 Mask        = Allocated - 1;
+    u32 EmptyBefore = HashTableGroupMatchEmpty( Control + ((Idx - HASH_TABLE_GROUP_WIDTH) & Mask) );
+    u32 EmptyAfter  = HashTableGroupMatchEmpty( Control + Idx );
+
+    bool NeverFull = EmptyBefore != 0 && EmptyAfter != 0 &&
+                     HashTableCtz( EmptyAfter ) + HashTableClzGroup( EmptyBefore ) < HASH_TABLE_GROUP_WIDTH;
+
+    HashTableSetControl( Control, Allocated, Idx, NeverFull ? HASH_TABLE_CTRL_EMPTY : HASH_TABLE_CTRL_DELETED );
+    return NeverFull;
+}
+
+// Caller made sure HashId is not in the table and there is room
+//
+static entry* HashTableInsertHash( hash_table *Table, U64 HashId, const char* Id, void* Value ) {
+    U64 Mask = Table->Allocated - 1;
+    U64 Pos  = HashTableH1( HashId ) & Mask;
+
+    for( U64 Step = 0; ; ) {
+        u32 Free = HashTableGroupMatchFree( Table->Control + Pos );
+        if( Free != 0 ) {
+            U64 Idx = (Pos + HashTableCtz( Free )) & Mask;
+            if( Table->Control[Idx] == HASH_TABLE_CTRL_EMPTY ) {
+                Table->SlotsFilled += 1;
+            }
+            HashTableSetControl( Table->Control, Table->Allocated, Idx, HashTableH2( HashId ) );
+
+            entry* Entry  = &Table->Entries[Idx];
+            Entry->HashId = HashId;
+            Entry->Id     = Id;
+            Entry->Value  = Value;
+
+            Table->Count += 1;
+            return Entry;
+        }
+
+        Step += HASH_TABLE_GROUP_WIDTH;
+        Pos   = (Pos + Step) & Mask;
+    }
+}
+
+// Moves up to Budget slots of the old arrays into the current ones. Moved
+// slots are left as tombstones so lookups still in the old arrays keep probing.
+//
+static void HashTableRehashStep( hash_table *Table, U64 Budget ) {
+    if( Table->OldControl == NULL ) {
+        return;
+    }
+
+    U64 End = Table->RehashPos + Budget;
+    if( End > Table->OldAllocated || End < Table->RehashPos ) {
+        End = Table->OldAllocated;
+    }
+
+    for( U64 i = Table->RehashPos; i < End; i += 1 ) {
+        if( Table->OldControl[i] >= 0 ) {
+            entry* Old = &Table->OldEntries[i];
+            HashTableSetControl( Table->OldControl, Table->OldAllocated, i, HASH_TABLE_CTRL_DELETED );
+            Table->Count -= 1;
+            HashTableInsertHash( Table, Old->HashId, Old->Id, Old->Value );
+        }
+    }
+    Table->RehashPos = End;
+
+    if( Table->RehashPos == Table->OldAllocated ) {
+        Table->SpareControl   = Table->OldControl;
+        Table->SpareEntries   = Table->OldEntries;
+        Table->SpareAllocated = Table->OldAllocated;
+
+        Table->OldControl   = NULL;
+        Table->OldEntries   = NULL;
+        Table->OldAllocated = 0;
+        Table->RehashPos    = 0;
+    }
+}
+
+// Starts moving everything to new arrays. Twice the size when the table is
+// really full, the same size when it is mostly tombstones.
+//
+static void HashTableBeginRehash( hash_table *Table ) {
+    // Only one migration at a time. It moves HASH_TABLE_REHASH_STEP slots per
+    // add, so it is long done before the new arrays fill up.
+    //
+    HashTableRehashStep( Table, (U64)-1 );
+
+    U64 Slots = Table->Allocated;
+    if( Table->Count * 100 * 2 > Table->Allocated * Table->LoadFactorPercent ) {
+        Slots *= 2;
+    }
+
+    Table->OldControl   = Table->Control;
+    Table->OldEntries   = Table->Entries;
+    Table->OldAllocated = Table->Allocated;
+    Table->RehashPos    = 0;
+
+    HashTableAllocSlots( Table, Slots );
+}
+
+// --------------------------------------------------------------- //
+
 void HashTableInit( hash_table *Table, Stack_Allocator* Allocator, u64 Size, U64 (*HashFunction)(const U8* key, U64 length, U64 seed) ) {
     memset( Table, 0, sizeof(hash_table) );
-    Table->Allocator = Allocator;
-    Table->Entries = stack_push(Allocator, entry, Size);
-    Table->Allocated = Size;
+    Table->Allocator         = Allocator;
+    Table->LoadFactorPercent = HASH_TABLE_LOAD_FACTOR;
+
+    U64 Slots = HASH_TABLE_GROUP_WIDTH;
+    while( Slots < Size ) {
+        Slots <<= 1;
+    }
+    Table->MinSize = Slots;
+    HashTableAllocSlots( Table, Slots );
+
     if( HashFunction == NULL ) {
         Table->HashFunction  = JenkinsHashFunction;
     } else {
-        Table->HashFunction = HashFunction;
+        Table->HashFunction   = HashFunction;
+        Table->CustomFunction = true;
     }
+}
 
-    memset( Table->Entries, 0, Table->Allocated );
+// --------------------------------------------------------------- //
+
+hash_key HashTableKey( hash_table *Table, const char* Id, U64 Len, U64 parent ) {
+    hash_key Key;
+    Key.Ptr  = Id;
+    Key.Len  = Len;
+    Key.Hash = Table->HashFunction( (const U8*)Id, Len, parent );
+    return Key;
 }
 
 // --------------------------------------------------------------- //
 
-entry* HashTableAdd( hash_table *Table, const char* Id, void* Value, U64 parent ) {
-    U64 HashId = Table->HashFunction( (const U8*)Id, UCF_Strlen( Id ), parent );
+U64 HashTableCombine( U64 Seed, U64 Value ) {
+    // Boost style combine followed by the murmur3 finalizer, so neighbouring
+    // values (pointers, indices) still spread over H1 and H2
+    //
+    U64 Hash = Seed ^ (Value + 0x9E3779B97F4A7C15ull + (Seed << 6) + (Seed >> 2));
+    Hash ^= Hash >> 33;
+    Hash *= 0xFF51AFD7ED558CCDull;
+    Hash ^= Hash >> 33;
+    Hash *= 0xC4CEB9FE1A85EC53ull;
+    Hash ^= Hash >> 33;
+    return Hash;
+}
 
-    U64 EntryIdx = HashId % Table->Allocated;
+// --------------------------------------------------------------- //
 
-    entry* Entry = stack_push(Table->Allocator, entry, 1);
-    *Entry = {};
-    Entry->HashId = HashId;
-    Entry->Id     = Id;
-    Entry->Value  = Value;
-    DLIST_INIT(Entry);
+entry* HashTableFindHashed( hash_table *Table, U64 HashId ) {
+    return HashTableFindHash( Table, HashId );
+}
 
-    if( Table->Entries[EntryIdx].HashId == 0 ) {
-        DLIST_INIT(&Table->Entries[EntryIdx]);
-        Table->Entries[EntryIdx].HashId = HashId;
-        Table->Entries[EntryIdx].Id     = Id;
+// --------------------------------------------------------------- //
+
+entry* HashTableAddHashed( hash_table *Table, hash_key Key, void* Value ) {
+    entry* Entry = HashTableFindHash( Table, Key.Hash );
+    if( Entry != NULL ) {
+        return Entry;
     }
 
-    DLIST_INSERT_AS_LAST(&Table->Entries[EntryIdx], Entry);
+    HashTableRehashStep( Table, HASH_TABLE_REHASH_STEP );
+
+    if( (Table->SlotsFilled + 1) * 100 > Table->Allocated * Table->LoadFactorPercent ) {
+        HashTableBeginRehash( Table );
+    }
 
-    return Entry;
+    return HashTableInsertHash( Table, Key.Hash, Key.Ptr, Value );
 }
 
 // --------------------------------------------------------------- //
 
-void* HashTableSet( hash_table *Table, const char* Id, void* Value, U64 parent ) {
-    U64 HashId = Table->HashFunction( (const U8*)Id, UCF_Strlen( Id ), parent );
+void* HashTableRemoveHashed( hash_table *Table, U64 HashId ) {
+    void* Value = NULL;
+    U64   Idx   = HashTableFindSlot( Table->Control, Table->Entries, Table->Allocated, HashId );
+    if( Idx != Table->Allocated ) {
+        Value = Table->Entries[Idx].Value;
+        if( HashTableEraseSlot( Table->Control, Table->Allocated, Idx ) ) {
+            Table->SlotsFilled -= 1;
+        }
+        Table->Count -= 1;
+    } else if( Table->OldControl != NULL ) {
+        Idx = HashTableFindSlot( Table->OldControl, Table->OldEntries, Table->OldAllocated, HashId );
+        if( Idx != Table->OldAllocated ) {
+            Value = Table->OldEntries[Idx].Value;
+            HashTableSetControl( Table->OldControl, Table->OldAllocated, Idx, HASH_TABLE_CTRL_DELETED );
+            Table->Count -= 1;
+        }
+    }
+
+    HashTableRehashStep( Table, HASH_TABLE_REHASH_STEP );
 
-    U64 EntryIdx = HashId % Table->Allocated;
+    return Value;
+}
 
-    void* value = Table->Entries[EntryIdx].Value;
+// --------------------------------------------------------------- //
 
-    if( Table->Entries[EntryIdx].HashId == 0 ) {
+entry* HashTableAdd( hash_table *Table, const char* Id, void* Value, U64 parent ) {
+    return HashTableAddHashed( Table, HashTableKey( Table, Id, UCF_Strlen( Id ), parent ), Value );
+}
+
+// --------------------------------------------------------------- //
+
+void* HashTableSet( hash_table *Table, const char* Id, void* Value, U64 parent ) {
+    U64 HashId = Table->HashFunction( (const U8*)Id, UCF_Strlen( Id ), parent );
+
+    entry* Entry = HashTableFindHash( Table, HashId );
+    if( Entry == NULL ) {
         return NULL;
-    } else {
-        entry* it = Table->Entries[EntryIdx].Next;
-        for( ; it != NULL; it = it->Next ) {
-            if( it->Next == &Table->Entries[EntryIdx] ) {
-                entry* Entry = HashTableAdd(Table, Id, Value, parent);
-                value = Entry->Value;
-            }
-        }
     }
 
-    return value;
+    void* Old    = Entry->Value;
+    Entry->Value = Value;
+    return Old;
 }
 
 // --------------------------------------------------------------- //
@@ -142,56 +468,287 @@ void* HashTableSet( hash_table *Table, const char* Id, void* Value, U64 parent )
 bool HashTableContains( hash_table *Table, const char* Id, U64 parent ) {
     U64 HashId = Table->HashFunction( (const U8*)Id, UCF_Strlen( Id ), parent );
 
-    U64 EntryIdx = HashId % Table->Allocated;
+    return HashTableFindHash( Table, HashId ) != NULL;
+}
 
-    if( Table->Entries[EntryIdx].HashId == 0 ) {
-        return false;
-    } else {
-        entry* it = Table->Entries[EntryIdx].Next;
-        for( ; it != &Table->Entries[EntryIdx]; it = it->Next ) {
-            if( it->HashId == HashId ) {
-                return true;
-            }
+// --------------------------------------------------------------- //
+
+entry* HashTableFindPointer( hash_table *Table, const char* Id, U64 parent ) {
+    U64 HashId = Table->HashFunction( (const U8*)Id, UCF_Strlen( Id ), parent );
+
+    return HashTableFindHash( Table, HashId );
+}
+
+// --------------------------------------------------------------- //
+
+void* HashTableGet( hash_table *Table, u64 Id, U64 parent ) {
+    entry* Entry = HashTableFindHash( Table, Id );
+
+    return Entry != NULL ? Entry->Value : NULL;
+}
+
+// --------------------------------------------------------------- //
+
+void* HashTableRemove( hash_table *Table, const char* Id, U64 parent ) {
+    U64 HashId = Table->HashFunction( (const U8*)Id, UCF_Strlen( Id ), parent );
+
+    return HashTableRemoveHashed( Table, HashId );
+}
+
+// --------------------------------------------------------------- //
+// Concurrent hash table
+
+static U64 ConcurrentHashTableLoad( volatile U64* Value ) {
+#if defined(_MSC_VER)
+    return (U64)_InterlockedOr64( (volatile long long*)Value, 0 );
+#else
+    return __atomic_load_n( Value, __ATOMIC_ACQUIRE );
+#endif
+}
+
+static void ConcurrentHashTableStore( volatile U64* Value, U64 New ) {
+#if defined(_MSC_VER)
+    _InterlockedExchange64( (volatile long long*)Value, (long long)New );
+#else
+    __atomic_store_n( Value, New, __ATOMIC_RELEASE );
+#endif
+}
+
+// Sequentially consistent: a reader announcing itself and a writer swapping the
+// arrays out have to agree on who went first
+//
+static concurrent_slots* ConcurrentHashTableLoadSlots( concurrent_hash_table *Table ) {
+#if defined(_MSC_VER)
+    return (concurrent_slots*)_InterlockedCompareExchangePointer( (void* volatile*)&Table->Slots, NULL, NULL );
+#else
+    return __atomic_load_n( &Table->Slots, __ATOMIC_SEQ_CST );
+#endif
+}
+
+static void ConcurrentHashTableReaderEnter( concurrent_slots* Slots ) {
+#if defined(_MSC_VER)
+    _InterlockedIncrement64( (volatile long long*)&Slots->Readers );
+#else
+    __atomic_add_fetch( &Slots->Readers, 1, __ATOMIC_SEQ_CST );
+#endif
+}
+
+static void ConcurrentHashTableReaderLeave( concurrent_slots* Slots ) {
+#if defined(_MSC_VER)
+    _InterlockedDecrement64( (volatile long long*)&Slots->Readers );
+#else
+    __atomic_sub_fetch( &Slots->Readers, 1, __ATOMIC_RELEASE );
+#endif
+}
+
+static void ConcurrentHashTableLock( concurrent_hash_table *Table ) {
+#if defined(_MSC_VER)
+    while( _InterlockedExchange( &Table->Lock, 1 ) != 0 ) {}
+#else
+    while( __atomic_exchange_n( &Table->Lock, 1, __ATOMIC_ACQUIRE ) != 0 ) {}
+#endif
+}
+
+static void ConcurrentHashTableUnlock( concurrent_hash_table *Table ) {
+#if defined(_MSC_VER)
+    _InterlockedExchange( &Table->Lock, 0 );
+#else
+    __atomic_store_n( &Table->Lock, 0, __ATOMIC_RELEASE );
+#endif
+}
+
+static concurrent_slots* ConcurrentHashTableAllocSlots( concurrent_hash_table *Table, U64 Slots ) {
+    concurrent_slots* New = PushArray( Table->Backing, concurrent_slots, 1 );
+    New->Allocated   = Slots;
+    New->Readers     = 0;
+    New->NextRetired = NULL;
+    New->Keys        = PushArray( Table->Backing, U64, Slots );
+    New->Values      = PushArray( Table->Backing, U64, Slots );
+    assert( New->Keys != NULL && New->Values != NULL && "Concurrent hash table does not fit in its arena" );
+
+    memset( (void*)New->Keys,   0, Slots * sizeof( U64 ) );
+    memset( (void*)New->Values, 0, Slots * sizeof( U64 ) );
+    return New;
+}
+
+// Slot holding HashId, or the empty slot where it would go
+//
+static U64 ConcurrentHashTableProbe( concurrent_slots* Slots, U64 HashId ) {
+    U64 Mask = Slots->Allocated - 1;
+    U64 Idx  = HashId & Mask;
+    for( U64 n = 0; n < Slots->Allocated; n += 1 ) {
+        U64 Key = ConcurrentHashTableLoad( &Slots->Keys[Idx] );
+        if( Key == HashId || Key == 0 ) {
+            return Idx;
+        }
+        Idx = (Idx + 1) & Mask;
+    }
+    return Slots->Allocated;
+}
+
+// Lock held. A retired array of Slots nobody reads, NULL if there is none.
+// Smaller ones can't be used again, they are dropped from the list
+//
+static concurrent_slots* ConcurrentHashTableReuseSlots( concurrent_hash_table *Table, U64 Slots ) {
+    concurrent_slots** Link = &Table->Retired;
+    while( *Link != NULL ) {
+        concurrent_slots* It = *Link;
+        if( It->Allocated < Slots ) {
+            *Link = It->NextRetired;
+            continue;
+        }
+        if( It->Allocated == Slots && ConcurrentHashTableLoad( &It->Readers ) == 0 ) {
+            *Link = It->NextRetired;
+            memset( (void*)It->Keys,   0, Slots * sizeof( U64 ) );
+            memset( (void*)It->Values, 0, Slots * sizeof( U64 ) );
+            return It;
         }
+        Link = &It->NextRetired;
     }
+    return NULL;
+}
+
+// Lock held. Builds fresh arrays without tombstones and swaps them in
+//
+static void ConcurrentHashTableRebuild( concurrent_hash_table *Table ) {
+    concurrent_slots* Old = Table->Slots;
+
+    U64 Slots = Old->Allocated;
+    if( Table->Count * 100 * 2 > Old->Allocated * CONCURRENT_HASH_TABLE_LOAD_FACTOR ) {
+        Slots *= 2;
+    }
+
+    concurrent_slots* New = ConcurrentHashTableReuseSlots( Table, Slots );
+    if( New == NULL ) {
+        New = ConcurrentHashTableAllocSlots( Table, Slots );
+    }
+    Table->SlotsFilled = 0;
+    for( U64 i = 0; i < Old->Allocated; i += 1 ) {
+        U64 Value = Old->Values[i];
+        if( Value != 0 ) {
+            U64 Idx = ConcurrentHashTableProbe( New, Old->Keys[i] );
+            New->Keys[Idx]   = Old->Keys[i];
+            New->Values[Idx] = Value;
+            Table->SlotsFilled += 1;
+        }
+    }
+
+#if defined(_MSC_VER)
+    _InterlockedExchangePointer( (void* volatile*)&Table->Slots, New );
+#else
+    __atomic_store_n( &Table->Slots, New, __ATOMIC_SEQ_CST );
+#endif
 
-    return false;
+    Old->NextRetired = Table->Retired;
+    Table->Retired   = Old;
 }
 
 // --------------------------------------------------------------- //
 
-entry* HashTableFindPointer( hash_table *Table, const char* Id, U64 parent ) {
-    U64 HashId = Table->HashFunction( (const U8*)Id, UCF_Strlen( Id ), parent );
+void ConcurrentHashTableInit( concurrent_hash_table *Table, U64 Size, U64 (*HashFunction)(const U8* key, U64 length, U64 seed) ) {
+    memset( Table, 0, sizeof( concurrent_hash_table ) );
+    Table->Backing      = ArenaAllocEx( mebibyte( 1 ), ARENA_FLAG_CHAINED );
+    Table->HashFunction = HashFunction != NULL ? HashFunction : JenkinsHashFunction;
 
-    U64 EntryIdx = HashId % Table->Allocated;
+    U64 Slots = 16;
+    while( Slots < Size ) {
+        Slots <<= 1;
+    }
+    Table->Slots = ConcurrentHashTableAllocSlots( Table, Slots );
+}
 
-	if( Table->Entries[EntryIdx].HashId == 0 ) {
-        return NULL;
-    } else {
-        entry* it = Table->Entries[EntryIdx].Next;
-        for( ; it != &Table->Entries[EntryIdx]; it = it->Next ) {
-            if( it->HashId == HashId ) {
-                return it;
-            }
+// --------------------------------------------------------------- //
+
+void ConcurrentHashTableRelease( concurrent_hash_table *Table ) {
+    ArenaRelease( Table->Backing );
+    memset( Table, 0, sizeof( concurrent_hash_table ) );
+}
+
+// --------------------------------------------------------------- //
+
+hash_key ConcurrentHashTableKey( concurrent_hash_table *Table, const char* Id, U64 Len, U64 parent ) {
+    hash_key Key;
+    Key.Ptr  = Id;
+    Key.Len  = Len;
+    Key.Hash = Table->HashFunction( (const U8*)Id, Len, parent );
+    return Key;
+}
+
+// --------------------------------------------------------------- //
+
+void* ConcurrentHashTableGet( concurrent_hash_table *Table, U64 HashId ) {
+    // Once counted in, arrays that are still current after that can't be
+    // reused under us
+    //
+    concurrent_slots* Slots = ConcurrentHashTableLoadSlots( Table );
+    for( ;; ) {
+        ConcurrentHashTableReaderEnter( Slots );
+        concurrent_slots* Current = ConcurrentHashTableLoadSlots( Table );
+        if( Current == Slots ) {
+            break;
         }
-		return NULL;
+        ConcurrentHashTableReaderLeave( Slots );
+        Slots = Current;
     }
+
+    void* Value = NULL;
+    U64   Idx   = ConcurrentHashTableProbe( Slots, HashId );
+    if( Idx != Slots->Allocated && ConcurrentHashTableLoad( &Slots->Keys[Idx] ) == HashId ) {
+        Value = (void*)(uintptr_t)ConcurrentHashTableLoad( &Slots->Values[Idx] );
+    }
+
+    ConcurrentHashTableReaderLeave( Slots );
+    return Value;
 }
 
 // --------------------------------------------------------------- //
 
-void* HashTableGet( hash_table *Table, u64 Id, U64 parent ) {
-    U64 EntryIdx = Id % Table->Allocated;
+void* ConcurrentHashTableAdd( concurrent_hash_table *Table, hash_key Key, void* Value ) {
+    assert( Key.Hash != 0 && "0 marks empty slots" );
+    ConcurrentHashTableLock( Table );
 
-    if( Table->Entries[EntryIdx].HashId == 0 ) {
-        return NULL;
-    } else {
-        entry* it = Table->Entries[EntryIdx].Next;
-        for( ; it != &Table->Entries[EntryIdx]; it = it->Next ) {
-            if( it->HashId == Id ) {
-                return it->Value;
-            }
+    concurrent_slots* Slots = Table->Slots;
+    U64 Idx = ConcurrentHashTableProbe( Slots, Key.Hash );
+
+    if( Idx == Slots->Allocated || Slots->Keys[Idx] != Key.Hash ) {
+        if( (Table->SlotsFilled + 1) * 100 > Slots->Allocated * CONCURRENT_HASH_TABLE_LOAD_FACTOR ) {
+            ConcurrentHashTableRebuild( Table );
+            Slots = Table->Slots;
+            Idx   = ConcurrentHashTableProbe( Slots, Key.Hash );
+        }
+    }
+
+    void* Stored = (void*)(uintptr_t)Slots->Values[Idx];
+    if( Stored == NULL ) {
+        ConcurrentHashTableStore( &Slots->Values[Idx], (U64)(uintptr_t)Value );
+        if( Slots->Keys[Idx] != Key.Hash ) {
+            ConcurrentHashTableStore( &Slots->Keys[Idx], Key.Hash );
+            Table->SlotsFilled += 1;
+        }
+        Table->Count += 1;
+        Stored = Value;
+    }
+
+    ConcurrentHashTableUnlock( Table );
+    return Stored;
+}
+
+// --------------------------------------------------------------- //
+
+void* ConcurrentHashTableRemove( concurrent_hash_table *Table, U64 HashId ) {
+    ConcurrentHashTableLock( Table );
+
+    concurrent_slots* Slots = Table->Slots;
+    U64   Idx   = ConcurrentHashTableProbe( Slots, HashId );
+    void* Value = NULL;
+    if( Idx != Slots->Allocated && Slots->Keys[Idx] == HashId ) {
+        Value = (void*)(uintptr_t)Slots->Values[Idx];
+        if( Value != NULL ) {
+            ConcurrentHashTableStore( &Slots->Values[Idx], 0 );
+            Table->Count -= 1;
         }
-		return NULL;
     }
+
+    ConcurrentHashTableUnlock( Table );
+    return Value;
 }
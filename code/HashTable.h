@@ -1,32 +1,93 @@
 #ifndef _HASH_TABLE_H_
 #define _HASH_TABLE_H_
 
+// Open addressing table in the Swiss table style. Every slot has a control
+// byte: the top bit set means empty, otherwise the low 7 bits hold the low 7
+// bits of the hash. A lookup loads a group of HASH_TABLE_GROUP_WIDTH control
+// bytes and compares all of them against the hash in one SIMD compare, so only
+// slots whose 7 bits match are ever read. Capacity is a power of two.
+//
+// Removed slots become tombstones (HASH_TABLE_CTRL_DELETED) unless no probe can
+// have gone past them. Once empty plus tombstone slots drop under
+// 100 - LoadFactorPercent the table moves to new arrays, twice as big unless it
+// is mostly tombstones. The move is incremental: every add and remove carries
+// HASH_TABLE_REHASH_STEP old slots over, and lookups look in both meanwhile, so
+// growing never costs a whole rehash in one frame.
+//
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define HASH_TABLE_GROUP_WIDTH 32
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HASH_TABLE_GROUP_WIDTH 16
+#else
+#define HASH_TABLE_GROUP_WIDTH 16
+#endif
+
+#define HASH_TABLE_CTRL_EMPTY   ((i8)-128) // 0x80
+#define HASH_TABLE_CTRL_DELETED ((i8)-2)   // 0xFE
+#define HASH_TABLE_LOAD_FACTOR  87
+
+#ifndef HASH_TABLE_REHASH_STEP
+#define HASH_TABLE_REHASH_STEP  64
+#endif
+
+// Entries live inline in the slot array, a pointer to one is only valid until
+// the next add or remove
+//
 typedef struct entry entry;
 struct entry {
-    entry* Root;
-    entry* Prev;
-    entry* Next;
-
     U64 HashId;
     const char* Id;
     void* Value;
 };
 
+// A key with its hash already computed. Build it once with HashTableKey (or
+// from HashTableCombine for keys that are not strings) and the hashed entry
+// points below only probe. Ptr is kept as the entry Id, it may be NULL.
+//
+typedef struct hash_key hash_key;
+struct hash_key {
+    const char* Ptr;
+    U64         Len;
+    U64         Hash;
+};
+
 typedef struct hash_table hash_table;
 struct hash_table {
     U64 Count;
-    U64 Allocated;
-    U64 SlotsFilled;
+    U64 Allocated;          // slots, always a power of two
+    U64 SlotsFilled;        // live plus tombstones in Control
     U64 MinSize;
 
     U64 LoadFactorPercent;
 
+    // Slot arrays come from here. Drained arrays are reused or popped when
+    // the stack allows it, see HashTableAllocSlots. A table that doubles up to
+    // N slots with other pushes on top of it can still leave up to N behind
+    // until the stack is reset.
+    //
     Stack_Allocator* Allocator;
 
-    // TODO(s.p): Maybe do it dynamic
+    // Allocated + HASH_TABLE_GROUP_WIDTH bytes, the tail mirrors the first
+    // group so a group load starting near the end never wraps
     //
+    i8*    Control;
     entry* Entries;
 
+    // Arrays being drained by the incremental rehash, NULL when there is none
+    //
+    i8*    OldControl;
+    entry* OldEntries;
+    U64    OldAllocated;
+    U64    RehashPos;
+
+    // Arrays the last migration drained, kept for the next one
+    //
+    i8*    SpareControl;
+    entry* SpareEntries;
+    U64    SpareAllocated;
+
     bool CustomFunction;
 
     U64 (*HashFunction)(const U8* key, U64 length, U64 seed);
@@ -36,6 +97,7 @@ struct hash_table {
  * @brief Inits the hash table values
  * @param Table         hash_table pointer to the struct
  * @param BackingBuffer pointer to a buffer used for backing memory
+ * @param BufSize       initial slot count, rounded up to a power of two
  * @param HashFunction  pointer to a custom hash function
  */
 void  HashTableInit( hash_table *Table, Stack_Allocator* BackingBuffer, u64 BufSize, U64 (*HashFunction)(const U8* key, U64 length, U64 seed) );
@@ -52,6 +114,7 @@ entry* HashTableAdd( hash_table *Table, const char* Id, void* Value, U64 parent
  * @param Table hash_table pointer to the struct
  * @param Id    char* with the Id
  * @param Value void* pointer to the value
+ * @return void* the value it had, NULL if there was no entry
  */
 void* HashTableSet( hash_table *Table, const char* Id, void* Value, U64 parent );
 
@@ -79,8 +142,117 @@ entry* HashTableFindPointer( hash_table *Table, const char* Id, U64 parent );
 */
 void* HashTableGet(hash_table *Table, u64 Id, U64 parent);
 
+/**
+* @brief Removes an entry
+* @param Table     hash_table pointer to the struct
+* @param Id        char* with the Id
+* @return void*    The value it held, NULL if there was no entry
+*/
+void* HashTableRemove(hash_table *Table, const char* Id, U64 parent);
+
+/**
+* @brief Hashes a key once with the table hash function
+* @param Table     hash_table pointer to the struct
+* @param Id        char* with the Id, does not need to be null terminated
+* @param Len       bytes of Id
+* @param parent    seed, same as in the other calls
+* @return hash_key usable with the hashed calls
+*/
+hash_key HashTableKey(hash_table *Table, const char* Id, U64 Len, U64 parent);
+
+/**
+* @brief Derives a child hash from a parent hash and a value without touching
+*        any string, e.g. a parent id and an index or a constant tag
+*/
+U64 HashTableCombine(U64 Seed, U64 Value);
+
+/**
+* @brief Same as HashTableFindPointer with a hash from HashTableKey or HashTableCombine
+*/
+entry* HashTableFindHashed(hash_table *Table, U64 HashId);
+
+/**
+* @brief Same as HashTableAdd with an already hashed key
+*/
+entry* HashTableAddHashed(hash_table *Table, hash_key Key, void* Value);
+
+/**
+* @brief Same as HashTableRemove with an already hashed key
+*/
+void* HashTableRemoveHashed(hash_table *Table, U64 HashId);
+
 // --------------------------------------------------------------- //
 
+// Table for data many threads read and few threads write, keyed by hashes
+// that are already computed (hash_key, R_ID). Readers never lock nor write
+// shared memory: they load the current slot arrays and probe them. Writers are
+// serialized by a spin lock. A key is published by writing its value and then
+// the key with release order, so a reader that sees the key sees the value.
+//
+// Growing, or clearing the tombstones removes leave, builds new arrays and
+// swaps the pointer. A Get counts itself in the arrays it probes and checks
+// they are still the current ones before reading them, so swapped out arrays
+// go to a retired list and a rebuild of the same size reuses one nobody is
+// reading anymore. Add/remove churn cycles between two arrays instead of
+// filling the arena. Arrays left behind by growing stay in the arena until
+// ConcurrentHashTableRelease. A reader on an old array can still get a value
+// removed after it started, so whatever the value points at has to outlive
+// the frames that may have read it.
+//
+#define CONCURRENT_HASH_TABLE_LOAD_FACTOR 70
+
+typedef struct concurrent_slots concurrent_slots;
+struct concurrent_slots {
+    U64           Allocated; // power of two
+    volatile U64* Keys;      // hash, 0 is empty
+    volatile U64* Values;    // void*, 0 once removed. The key stays as a tombstone
+    volatile U64  Readers;   // Gets probing these arrays right now
+    concurrent_slots* NextRetired;
+};
+
+typedef struct concurrent_hash_table concurrent_hash_table;
+struct concurrent_hash_table {
+    concurrent_slots* volatile Slots;
+
+    // Writer side, only touched with Lock held
+    //
+    U64    Count;
+    U64    SlotsFilled;
+    Arena* Backing;
+    concurrent_slots* Retired; // swapped out, reused once their Readers is 0
+    volatile long Lock;
+
+    U64 (*HashFunction)(const U8* key, U64 length, U64 seed);
+};
+
+/**
+ * @brief Inits a concurrent table, it reserves its own arena
+ * @param Size          initial slot count, rounded up to a power of two
+ * @param HashFunction  hash used by ConcurrentHashTableKey, Jenkins if NULL
+ */
+void ConcurrentHashTableInit( concurrent_hash_table *Table, U64 Size, U64 (*HashFunction)(const U8* key, U64 length, U64 seed) );
+void ConcurrentHashTableRelease( concurrent_hash_table *Table );
+
+hash_key ConcurrentHashTableKey( concurrent_hash_table *Table, const char* Id, U64 Len, U64 parent );
+
+/**
+ * @brief Lock free lookup, any thread
+ * @return void* the value, NULL if there is none
+ */
+void* ConcurrentHashTableGet( concurrent_hash_table *Table, U64 HashId );
+
+/**
+ * @brief Publishes Value under Key unless the key already has a value
+ * @return void* the value stored under the key after the call
+ */
+void* ConcurrentHashTableAdd( concurrent_hash_table *Table, hash_key Key, void* Value );
+
+/**
+ * @brief Unpublishes a key
+ * @return void* the value it had, NULL if there was none
+ */
+void* ConcurrentHashTableRemove( concurrent_hash_table *Table, U64 HashId );
+
 static U64 UCF_Strlen(const char* str );
 
 static u32 UCF_Streq( const char* a, const char* b );
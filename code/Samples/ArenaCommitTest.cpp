@@ -0,0 +1,146 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+#include "../types.h"
+
+#include "../memory.h"
+
+#define MEMORY_IMPL
+#include "../memory.h"
+
+// Makes the OS refuse commits and checks that the arenas notice. Reserving is
+// PROT_NONE and not charged to RLIMIT_DATA, making the pages writable is, so
+// with a low limit the reservation works and the commit fails. That is what
+// vm.overcommit_memory=2 does to a machine that runs out of commit charge.
+//
+//   plain    a push past the limit returns NULL, the arena is still usable
+//   chained  pushes fill what can be committed and every byte handed out is
+//            writable, then return NULL
+//   prefault stops at what could be committed
+//   concurrent a claim past the limit returns NULL
+//
+// Exits with 1 on the first check that fails.
+//
+
+#define COMMIT_TEST_LIMIT mebibyte( 64 )
+
+global u32 CommitTestFailures;
+
+fn_internal void
+CommitTestCheck( bool Ok, const char* What ) {
+  printf( "  %-58s %s\n", What, Ok ? "ok" : "FAILED" );
+  if( !Ok ) {
+    CommitTestFailures += 1;
+  }
+}
+
+fn_internal void
+CommitTestPlain( void ) {
+  printf( "plain\n" );
+  Arena* A = ArenaAlloc( gigabyte( 1 ) );
+  CommitTestCheck( A != NULL, "reserve 1 GiB over a 64 MiB limit" );
+  if( A == NULL ) {
+    return;
+  }
+
+  U64 Pos = ArenaPos( A );
+  u8* Big = PushArray( A, u8, mebibyte( 256 ) );
+  CommitTestCheck( Big == NULL, "push of 256 MiB returns NULL" );
+  CommitTestCheck( ArenaPos( A ) == Pos, "failed push leaves pos alone" );
+  CommitTestCheck( ArenaGetStats( A ).CommitFailures > 0, "failure counted in the stats" );
+
+  u8* Small = PushArray( A, u8, mebibyte( 1 ) );
+  CommitTestCheck( Small != NULL, "push of 1 MiB afterwards works" );
+  if( Small != NULL ) {
+    memset( Small, 0xAB, mebibyte( 1 ) );
+  }
+
+  ArenaRelease( A );
+}
+
+fn_internal void
+CommitTestChained( void ) {
+  printf( "chained\n" );
+  Arena* A = ArenaAllocEx( mebibyte( 16 ), ARENA_FLAG_CHAINED );
+  CommitTestCheck( A != NULL, "chained arena of 16 MiB segments" );
+  if( A == NULL ) {
+    return;
+  }
+
+  // Each push is written in full, a push that came back without being
+  // committed would fault here
+  //
+  U64 Pushed = 0;
+  for( ;; ) {
+    u8* Block = PushArray( A, u8, mebibyte( 1 ) );
+    if( Block == NULL ) {
+      break;
+    }
+    memset( Block, 0xCD, mebibyte( 1 ) );
+    Pushed += mebibyte( 1 );
+  }
+
+  printf( "  pushed %llu MiB before running out\n", (unsigned long long)(Pushed >> 20) );
+  CommitTestCheck( Pushed > mebibyte( 16 ), "grew past the first segment" );
+  CommitTestCheck( Pushed < COMMIT_TEST_LIMIT, "stopped at the limit" );
+
+  ArenaRelease( A );
+}
+
+fn_internal void
+CommitTestPrefault( void ) {
+  printf( "prefault\n" );
+  Arena* A = ArenaAlloc( gigabyte( 1 ) );
+  if( A == NULL ) {
+    CommitTestCheck( false, "reserve 1 GiB" );
+    return;
+  }
+
+  ArenaPrefault( A, mebibyte( 512 ), 0 );
+  CommitTestCheck( A->commit_pos < COMMIT_TEST_LIMIT, "prefault commits no more than the limit" );
+
+  ArenaRelease( A );
+}
+
+fn_internal void
+CommitTestConcurrent( void ) {
+  printf( "concurrent\n" );
+  ConcurrentArena* A = ConcurrentArenaAlloc( gigabyte( 1 ), kibibyte( 64 ) );
+  CommitTestCheck( A != NULL, "reserve 1 GiB" );
+  if( A == NULL ) {
+    return;
+  }
+
+  CommitTestCheck( ConcurrentArenaPush( A, mebibyte( 256 ) ) == NULL, "push of 256 MiB returns NULL" );
+
+  ConcurrentArenaRelease( A );
+}
+
+int main( void ) {
+#ifdef __linux__
+  struct rlimit Limit = {};
+  getrlimit( RLIMIT_DATA, &Limit );
+  Limit.rlim_cur = COMMIT_TEST_LIMIT;
+  if( setrlimit( RLIMIT_DATA, &Limit ) != 0 ) {
+    perror( "[ERROR] setrlimit(RLIMIT_DATA)" );
+    return 1;
+  }
+
+  CommitTestPlain();
+  CommitTestChained();
+  CommitTestPrefault();
+  CommitTestConcurrent();
+
+  printf( CommitTestFailures ? "%u checks failed\n" : "all checks passed\n", CommitTestFailures );
+  return CommitTestFailures ? 1 : 0;
+#else
+  printf( "RLIMIT_DATA is Linux only, nothing tested\n" );
+  return 0;
+#endif
+}
@@ -0,0 +1,590 @@
+#include <chrono>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#endif
+
+#include "../types.h"
+
+#include "../memory.h"
+#include "../allocator.h"
+#include "../alloc_trace.h"
+
+#define MEMORY_IMPL
+#include "../memory.h"
+#define ALLOCATOR_IMPL
+#include "../allocator.h"
+#define ALLOC_TRACE_IMPL
+#include "../alloc_trace.h"
+
+// Replays allocation traces recorded with -DALLOC_TRACE (make todolist_trace,
+// csv_test_trace, objload_trace) against every allocator we have, plus malloc.
+//
+// Arena and Stack_Allocator can only give memory back from the top, so a free
+// there marks the allocation dead and the top is popped once everything above
+// it is dead too, the same thing the samples do with TempBegin/TempEnd. What
+// stays stuck under a live allocation shows up as fragmentation.
+//
+// Every payload is written in full, like the program that recorded the trace
+// would, so peak RSS doesn't favour allocators that leave their memory alone
+// (stack_alloc_non_zeroed still clears it). Each allocator runs in its own
+// process on Linux to get a clean peak RSS; elsewhere that column is n/a.
+//
+// Fragmentation is 1 - peak live bytes / peak footprint, where the footprint is
+// what the allocator had to hold at its worst: arena/stack high water, buddy
+// blocks in use and TLSF pools. malloc doesn't tell, so it has none.
+//
+
+enum {
+  REPLAY_MALLOC,
+  REPLAY_ARENA,
+  REPLAY_STACK,
+  REPLAY_BUDDY,
+  REPLAY_TLSF,
+  REPLAY_COUNT
+};
+
+global const char* ReplayNames[REPLAY_COUNT] = { "malloc", "arena", "stack", "buddy", "tlsf" };
+
+typedef struct replay_result replay_result;
+struct replay_result {
+  F64 Seconds;
+  u64 Ops;
+  u64 P50Ns;
+  u64 P99Ns;
+  u64 PeakRss;
+  u64 Footprint;
+  u64 PeakLive;
+  u64 Failed;
+  bool HaveRss;
+  bool Skipped;  // heap too big to commit here
+  bool Crashed;
+};
+
+typedef struct replay_ctx replay_ctx;
+struct replay_ctx {
+  u32 Kind;
+
+  u8** Ptrs;     // what the trace sees, indexed by allocation id
+  u8** Raw;      // what has to be given back when Ptrs was aligned by hand
+  u64* Sizes;
+  u64* Marks;    // arena position before the push
+  u8*  Dead;     // freed by the trace but still under a live allocation
+  u64* Order;    // arena/stack allocations bottom to top
+  u64  OrderCount;
+
+  Arena*          Heap;
+  Stack_Allocator Stack;
+  Buddy_Allocator Buddy;
+  Tlsf_Allocator  Tlsf;
+  u64             HeapBase;
+  u64             HeapSize;
+
+  u64 LiveBytes;
+  u64 PeakLive;
+  u64 Footprint;
+  u64 Failed;
+};
+
+typedef struct trace_summary trace_summary;
+struct trace_summary {
+  u64 Allocs;
+  u64 Frees;
+  u64 PeakLive;
+  u64 TotalBytes;
+  u64 SizeP50, SizeP99;
+  u64 LifeP50, LifeP99;
+  u64 PerSource[ALLOC_TRACE_SOURCE_COUNT];
+};
+
+fn_internal int
+CompareU64( const void* a, const void* b ) {
+  u64 x = *(const u64*)a;
+  u64 y = *(const u64*)b;
+  return x < y ? -1 : x > y ? 1 : 0;
+}
+
+fn_internal u64
+Percentile( u64* Sorted, u64 Count, F64 P ) {
+  if( Count == 0 ) {
+    return 0;
+  }
+  u64 Index = (u64)(P * (F64)(Count - 1) + 0.5);
+  return Sorted[Index];
+}
+
+fn_internal u64
+NextPow2( u64 x ) {
+  u64 p = 1;
+  while( p < x ) {
+    p <<= 1;
+  }
+  return p;
+}
+
+// Sizes and lifetimes, lifetime counted in allocations done while it was live.
+// Allocations never freed live until the end of the trace.
+//
+fn_internal trace_summary
+SummarizeTrace( alloc_trace* Trace, Arena* Scratch ) {
+  trace_summary Summary = {};
+
+  u64  N        = Trace->AllocCount;
+  u64* Sizes    = PushArray( Scratch, u64, N );
+  u64* Born     = PushArray( Scratch, u64, N );
+  u64* Lifes    = PushArray( Scratch, u64, N );
+  u8*  Freed    = PushArray( Scratch, u8,  N );
+  u64  Live     = 0;
+  u64  LifeN    = 0;
+  memset( Freed, 0, N );
+
+  for( u64 i = 0; i < Trace->Count; i += 1 ) {
+    alloc_trace_record* R = &Trace->Records[i];
+    if( R->Id >= N ) {
+      continue;
+    }
+    if( R->Event == ALLOC_TRACE_ALLOC ) {
+      Sizes[R->Id] = R->Size;
+      Born[R->Id]  = Summary.Allocs;
+      Summary.Allocs     += 1;
+      Summary.TotalBytes += R->Size;
+      Live += R->Size;
+      if( Live > Summary.PeakLive ) {
+        Summary.PeakLive = Live;
+      }
+      if( R->Source < ALLOC_TRACE_SOURCE_COUNT ) {
+        Summary.PerSource[R->Source] += 1;
+      }
+    } else {
+      Summary.Frees += 1;
+      Live -= Sizes[R->Id];
+      Lifes[LifeN++] = Summary.Allocs - Born[R->Id];
+      Freed[R->Id]   = 1;
+    }
+  }
+
+  for( u64 Id = 0; Id < N; Id += 1 ) {
+    if( !Freed[Id] ) {
+      Lifes[LifeN++] = Summary.Allocs - Born[Id];
+    }
+  }
+
+  u64* Sorted = PushArray( Scratch, u64, N );
+  memcpy( Sorted, Sizes, N * sizeof( u64 ) );
+  qsort( Sorted, N, sizeof( u64 ), CompareU64 );
+  Summary.SizeP50 = Percentile( Sorted, N, 0.50 );
+  Summary.SizeP99 = Percentile( Sorted, N, 0.99 );
+
+  qsort( Lifes, LifeN, sizeof( u64 ), CompareU64 );
+  Summary.LifeP50 = Percentile( Lifes, LifeN, 0.50 );
+  Summary.LifeP99 = Percentile( Lifes, LifeN, 0.99 );
+
+  return Summary;
+}
+
+// With overcommit on, committing a fixed heap much bigger than the machine
+// still succeeds and only faults later. Those replays are skipped instead.
+//
+fn_internal bool
+HeapFits( u64 Size ) {
+#ifdef __linux__
+  u64 Physical = (u64)sysconf( _SC_PHYS_PAGES ) * (u64)sysconf( _SC_PAGESIZE );
+  return Size <= Physical / 2;
+#else
+  (void)Size;
+  return true;
+#endif
+}
+
+// False when the fixed heap of the stack or buddy replay can't be committed
+//
+fn_internal bool
+ReplayBegin( replay_ctx* Ctx, trace_summary* Summary ) {
+  Ctx->LiveBytes  = 0;
+  Ctx->PeakLive   = 0;
+  Ctx->Footprint  = 0;
+  Ctx->Failed     = 0;
+  Ctx->OrderCount = 0;
+
+  switch( Ctx->Kind ) {
+    case REPLAY_ARENA: {
+      Ctx->Heap     = ArenaAllocDefault();
+      Ctx->HeapBase = ArenaPos( Ctx->Heap );
+    } break;
+    case REPLAY_STACK: {
+      // Enough for every allocation of the trace to be stuck at once
+      //
+      Ctx->HeapSize = Summary->TotalBytes + 64 * Summary->Allocs + mebibyte( 1 );
+      if( !HeapFits( Ctx->HeapSize ) ) {
+        return false;
+      }
+      Ctx->Heap     = ArenaAlloc( Ctx->HeapSize + mebibyte( 4 ) );
+      u8* Memory    = PushArray( Ctx->Heap, u8, Ctx->HeapSize );
+      if( Memory == NULL ) {
+        ArenaRelease( Ctx->Heap );
+        return false;
+      }
+      stack_init( &Ctx->Stack, Memory, (i64)Ctx->HeapSize );
+    } break;
+    case REPLAY_BUDDY: {
+      Ctx->HeapSize = NextPow2( 2 * Summary->PeakLive + mebibyte( 1 ) );
+      if( !HeapFits( Ctx->HeapSize ) ) {
+        return false;
+      }
+      Ctx->Heap     = ArenaAlloc( Ctx->HeapSize + mebibyte( 4 ) );
+      u8* Memory    = PushArray( Ctx->Heap, u8, Ctx->HeapSize );
+      if( Memory == NULL ) {
+        ArenaRelease( Ctx->Heap );
+        return false;
+      }
+      buddy_allocator_init( &Ctx->Buddy, Memory, Ctx->HeapSize, 16 );
+    } break;
+    case REPLAY_TLSF: {
+      Ctx->Heap     = ArenaAllocDefault();
+      Ctx->HeapBase = ArenaPos( Ctx->Heap );
+      tlsf_init( &Ctx->Tlsf, Ctx->Heap, 0 );
+    } break;
+  }
+
+  return true;
+}
+
+fn_internal void
+ReplayEnd( replay_ctx* Ctx, u64 Count ) {
+  if( Ctx->Kind == REPLAY_MALLOC ) {
+    for( u64 i = 0; i < Count; i += 1 ) {
+      free( Ctx->Raw[i] );
+    }
+  } else {
+    ArenaRelease( Ctx->Heap );
+  }
+  memset( Ctx->Ptrs, 0, Count * sizeof( u8* ) );
+  memset( Ctx->Raw,  0, Count * sizeof( u8* ) );
+  memset( Ctx->Dead, 0, Count );
+}
+
+fn_internal void
+ReplayAlloc( replay_ctx* Ctx, u64 Id, u64 Size, u64 Align ) {
+  u64 Bytes = Size ? Size : 1;
+  u8* Raw   = NULL;
+  u8* Ptr   = NULL;
+
+  switch( Ctx->Kind ) {
+    case REPLAY_MALLOC: {
+      u64 Pad = Align > 16 ? Align - 1 : 0;
+      Raw = (u8*)malloc( Bytes + Pad );
+      Ptr = Raw && Pad ? (u8*)align_forward( (uintptr_t)Raw, Align ) : Raw;
+    } break;
+    case REPLAY_ARENA: {
+      u64 Pad = Align > _Alignof(max_align_t) ? Align - 1 : 0;
+      Ctx->Marks[Id] = ArenaPos( Ctx->Heap );
+      Ptr = (u8*)ArenaPush( Ctx->Heap, Bytes + Pad );
+      if( Ptr && Pad ) {
+        Ptr = (u8*)align_forward( (uintptr_t)Ptr, Align );
+      }
+      u64 Used = ArenaPos( Ctx->Heap ) - Ctx->HeapBase;
+      Ctx->Footprint = Used > Ctx->Footprint ? Used : Ctx->Footprint;
+    } break;
+    case REPLAY_STACK: {
+      Ptr = (u8*)stack_alloc_non_zeroed( &Ctx->Stack, (i64)Bytes, Align ? (i64)Align : 8 );
+    } break;
+    case REPLAY_BUDDY: {
+      u64 Pad = Align > 16 ? Align - 1 : 0;
+      Raw = (u8*)buddy_allocator_alloc( &Ctx->Buddy, Bytes + Pad );
+      Ptr = Raw && Pad ? (u8*)align_forward( (uintptr_t)Raw, Align ) : Raw;
+      Ctx->Footprint = Ctx->Buddy.used_bytes > Ctx->Footprint ? Ctx->Buddy.used_bytes : Ctx->Footprint;
+    } break;
+    case REPLAY_TLSF: {
+      Ptr = (u8*)tlsf_alloc( &Ctx->Tlsf, (i64)Bytes, (i64)Align );
+    } break;
+  }
+
+  if( Ptr == NULL ) {
+    Ctx->Failed += 1;
+    return;
+  }
+
+  memset( Ptr, (u8)Id, Bytes );
+  Ctx->Ptrs[Id]  = Ptr;
+  Ctx->Raw[Id]   = Raw;
+  Ctx->Sizes[Id] = Size;
+  Ctx->LiveBytes += Size;
+  if( Ctx->LiveBytes > Ctx->PeakLive ) {
+    Ctx->PeakLive = Ctx->LiveBytes;
+  }
+  if( Ctx->Kind == REPLAY_ARENA || Ctx->Kind == REPLAY_STACK ) {
+    Ctx->Order[Ctx->OrderCount++] = Id;
+  }
+}
+
+fn_internal void
+ReplayFree( replay_ctx* Ctx, u64 Id ) {
+  u8* Ptr = Ctx->Ptrs[Id];
+  if( Ptr == NULL || Ctx->Dead[Id] ) {
+    return;
+  }
+  Ctx->LiveBytes -= Ctx->Sizes[Id];
+
+  switch( Ctx->Kind ) {
+    case REPLAY_MALLOC: {
+      free( Ctx->Raw[Id] );
+      Ctx->Raw[Id]  = NULL;
+      Ctx->Ptrs[Id] = NULL;
+    } break;
+    case REPLAY_BUDDY: {
+      buddy_allocator_free( &Ctx->Buddy, Ctx->Raw[Id] ? Ctx->Raw[Id] : Ptr );
+      Ctx->Ptrs[Id] = NULL;
+    } break;
+    case REPLAY_TLSF: {
+      tlsf_free( &Ctx->Tlsf, Ptr );
+      Ctx->Ptrs[Id] = NULL;
+    } break;
+    case REPLAY_ARENA:
+    case REPLAY_STACK: {
+      Ctx->Dead[Id] = 1;
+      while( Ctx->OrderCount > 0 && Ctx->Dead[Ctx->Order[Ctx->OrderCount - 1]] ) {
+        u64 Top = Ctx->Order[--Ctx->OrderCount];
+        Ctx->Dead[Top] = 0;
+        if( Ctx->Kind == REPLAY_ARENA ) {
+          ArenaPopTo( Ctx->Heap, Ctx->Marks[Top] );
+        } else {
+          stack_free( &Ctx->Stack, Ctx->Ptrs[Top] );
+        }
+        Ctx->Ptrs[Top] = NULL;
+      }
+    } break;
+  }
+}
+
+fn_internal void
+ReplayFinish( replay_ctx* Ctx ) {
+  switch( Ctx->Kind ) {
+    case REPLAY_STACK: Ctx->Footprint = (u64)Ctx->Stack.peak_used;              break;
+    case REPLAY_TLSF:  Ctx->Footprint = ArenaPos( Ctx->Heap ) - Ctx->HeapBase; break;
+  }
+}
+
+fn_internal u64
+ResidentBytes( void ) {
+#ifdef __linux__
+  FILE* Statm = fopen( "/proc/self/statm", "r" );
+  unsigned long long Pages = 0, Resident = 0;
+  if( Statm != NULL ) {
+    if( fscanf( Statm, "%llu %llu", &Pages, &Resident ) != 2 ) {
+      Resident = 0;
+    }
+    fclose( Statm );
+  }
+  return (u64)Resident * (u64)sysconf( _SC_PAGESIZE );
+#else
+  return 0;
+#endif
+}
+
+fn_internal replay_result
+ReplayRun( replay_ctx* Ctx, alloc_trace* Trace, trace_summary* Summary, u64* Latencies ) {
+  replay_result Result = {};
+
+  // Throughput pass, no clock inside the loop
+  //
+  if( !ReplayBegin( Ctx, Summary ) ) {
+    Result.Skipped = true;
+    return Result;
+  }
+  std::chrono::time_point t0 = std::chrono::steady_clock::now();
+  for( u64 i = 0; i < Trace->Count; i += 1 ) {
+    alloc_trace_record* R = &Trace->Records[i];
+    if( R->Event == ALLOC_TRACE_ALLOC ) {
+      ReplayAlloc( Ctx, R->Id, R->Size, R->Align );
+    } else {
+      ReplayFree( Ctx, R->Id );
+    }
+  }
+  std::chrono::time_point t1 = std::chrono::steady_clock::now();
+  ReplayFinish( Ctx );
+
+  Result.Seconds   = std::chrono::duration<F64>( t1 - t0 ).count();
+  Result.Ops       = Trace->Count;
+  Result.PeakLive  = Ctx->PeakLive;
+  Result.Footprint = Ctx->Footprint;
+  Result.Failed    = Ctx->Failed;
+  ReplayEnd( Ctx, Trace->AllocCount );
+
+  // Latency pass, the cost of reading the clock is taken out
+  //
+  u64 Overhead = ~0ull;
+  for( u32 i = 0; i < 1000; i += 1 ) {
+    std::chrono::time_point a = std::chrono::steady_clock::now();
+    std::chrono::time_point b = std::chrono::steady_clock::now();
+    u64 ns = (u64)std::chrono::duration_cast<std::chrono::nanoseconds>( b - a ).count();
+    Overhead = ns < Overhead ? ns : Overhead;
+  }
+
+  if( !ReplayBegin( Ctx, Summary ) ) {
+    Result.Skipped = true;
+    return Result;
+  }
+  for( u64 i = 0; i < Trace->Count; i += 1 ) {
+    alloc_trace_record* R = &Trace->Records[i];
+    std::chrono::time_point a = std::chrono::steady_clock::now();
+    if( R->Event == ALLOC_TRACE_ALLOC ) {
+      ReplayAlloc( Ctx, R->Id, R->Size, R->Align );
+    } else {
+      ReplayFree( Ctx, R->Id );
+    }
+    std::chrono::time_point b = std::chrono::steady_clock::now();
+    u64 ns = (u64)std::chrono::duration_cast<std::chrono::nanoseconds>( b - a ).count();
+    Latencies[i] = ns > Overhead ? ns - Overhead : 0;
+  }
+  ReplayEnd( Ctx, Trace->AllocCount );
+
+  qsort( Latencies, Trace->Count, sizeof( u64 ), CompareU64 );
+  Result.P50Ns = Percentile( Latencies, Trace->Count, 0.50 );
+  Result.P99Ns = Percentile( Latencies, Trace->Count, 0.99 );
+
+  return Result;
+}
+
+// Runs the replay in a child so ru_maxrss only sees this allocator
+//
+fn_internal replay_result
+ReplayIsolated( replay_ctx* Ctx, alloc_trace* Trace, trace_summary* Summary, u64* Latencies ) {
+#ifdef __linux__
+  int Pipe[2];
+  fflush( stdout );
+  if( pipe( Pipe ) == 0 ) {
+    pid_t Child = fork();
+    if( Child == 0 ) {
+      close( Pipe[0] );
+      u64 Baseline         = ResidentBytes();
+      replay_result Result = ReplayRun( Ctx, Trace, Summary, Latencies );
+      Result.PeakRss       = Baseline;
+      if( write( Pipe[1], &Result, sizeof( Result ) ) != sizeof( Result ) ) {
+        _exit( 1 );
+      }
+      _exit( 0 );
+    }
+    close( Pipe[1] );
+
+    replay_result Result = {};
+    bool Ok = Child > 0 && read( Pipe[0], &Result, sizeof( Result ) ) == sizeof( Result );
+    close( Pipe[0] );
+
+    if( Child > 0 ) {
+      int Status = 0;
+      struct rusage Usage = {};
+      wait4( Child, &Status, 0, &Usage );
+      if( Ok ) {
+        u64 MaxRss     = (u64)Usage.ru_maxrss * 1024;
+        Result.PeakRss = MaxRss > Result.PeakRss ? MaxRss - Result.PeakRss : 0;
+        Result.HaveRss = true;
+        return Result;
+      }
+      Result.Crashed = true;
+      return Result;
+    }
+  }
+#endif
+  return ReplayRun( Ctx, Trace, Summary, Latencies );
+}
+
+fn_internal void
+BenchTrace( const char* Path ) {
+  Arena* Arena = ArenaAllocDefault();
+
+  alloc_trace Trace = AllocTraceLoad( Path, Arena );
+  if( Trace.Count == 0 ) {
+    printf( "[WARNING] %s: no trace, build the sample with make <sample>_trace and run it\n", Path );
+    ArenaRelease( Arena );
+    return;
+  }
+
+  trace_summary Summary = SummarizeTrace( &Trace, Arena );
+
+  printf( "\n%s: %llu allocs, %llu frees, peak live %.2lf MiB\n", Path,
+          (unsigned long long)Summary.Allocs, (unsigned long long)Summary.Frees,
+          (F64)Summary.PeakLive / (1 << 20) );
+  printf( "  size p50 %llu B p99 %llu B, lifetime p50 %llu p99 %llu allocs\n",
+          (unsigned long long)Summary.SizeP50, (unsigned long long)Summary.SizeP99,
+          (unsigned long long)Summary.LifeP50, (unsigned long long)Summary.LifeP99 );
+  printf( "  from" );
+  for( u32 i = 0; i < ALLOC_TRACE_SOURCE_COUNT; i += 1 ) {
+    if( Summary.PerSource[i] ) {
+      printf( " %s %llu", AllocTraceSourceName( i ), (unsigned long long)Summary.PerSource[i] );
+    }
+  }
+  printf( "\n\n  %-8s %12s %9s %9s %12s %8s %8s\n", "alloc", "Mops/s", "p50 ns", "p99 ns", "peak RSS", "frag", "failed" );
+
+  replay_ctx Ctx = {};
+  u64 N     = Trace.AllocCount;
+  Ctx.Ptrs  = PushArray( Arena, u8*, N );
+  Ctx.Raw   = PushArray( Arena, u8*, N );
+  Ctx.Sizes = PushArray( Arena, u64, N );
+  Ctx.Marks = PushArray( Arena, u64, N );
+  Ctx.Dead  = PushArray( Arena, u8,  N );
+  Ctx.Order = PushArray( Arena, u64, N );
+  u64* Latencies = PushArray( Arena, u64, Trace.Count );
+
+  // Touch the bookkeeping now so it is part of the baseline RSS
+  //
+  memset( Ctx.Ptrs,  0, N * sizeof( u8* ) );
+  memset( Ctx.Raw,   0, N * sizeof( u8* ) );
+  memset( Ctx.Sizes, 0, N * sizeof( u64 ) );
+  memset( Ctx.Marks, 0, N * sizeof( u64 ) );
+  memset( Ctx.Dead,  0, N );
+  memset( Ctx.Order, 0, N * sizeof( u64 ) );
+  memset( Latencies, 0, Trace.Count * sizeof( u64 ) );
+
+  for( u32 Kind = 0; Kind < REPLAY_COUNT; Kind += 1 ) {
+    Ctx.Kind = Kind;
+    replay_result Result = ReplayIsolated( &Ctx, &Trace, &Summary, Latencies );
+    if( Result.Skipped || Result.Crashed ) {
+      printf( "  %-8s %s\n", ReplayNames[Kind], Result.Skipped ? "skipped, heap for this trace can't be committed" : "crashed" );
+      continue;
+    }
+
+    char Frag[32];
+    if( Kind == REPLAY_MALLOC || Result.Footprint == 0 ) {
+      snprintf( Frag, sizeof( Frag ), "n/a" );
+    } else {
+      F64 Ratio = 1.0 - (F64)Result.PeakLive / (F64)Result.Footprint;
+      snprintf( Frag, sizeof( Frag ), "%.1lf%%", Ratio < 0 ? 0.0 : Ratio * 100.0 );
+    }
+
+    char Rss[32];
+    if( Result.HaveRss ) {
+      snprintf( Rss, sizeof( Rss ), "%.2lf MiB", (F64)Result.PeakRss / (1 << 20) );
+    } else {
+      snprintf( Rss, sizeof( Rss ), "n/a" );
+    }
+
+    printf( "  %-8s %12.2lf %9llu %9llu %12s %8s %8llu\n", ReplayNames[Kind],
+            (F64)Result.Ops / Result.Seconds / 1e6,
+            (unsigned long long)Result.P50Ns, (unsigned long long)Result.P99Ns,
+            Rss, Frag, (unsigned long long)Result.Failed );
+  }
+
+  ArenaRelease( Arena );
+}
+
+int main( int argc, char** argv ) {
+  const char* Defaults[] = { "./todolist.trace", "./csv_test.trace", "./objload.trace" };
+
+  if( argc > 1 ) {
+    for( i32 i = 1; i < argc; i += 1 ) {
+      BenchTrace( argv[i] );
+    }
+  } else {
+    for( u32 i = 0; i < ArrayCount( Defaults ); i += 1 ) {
+      BenchTrace( Defaults[i] );
+    }
+  }
+
+  return 0;
+}
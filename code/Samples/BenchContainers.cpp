@@ -0,0 +1,685 @@
+#include <chrono>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "../types.h"
+
+#include "../memory.h"
+#include "../allocator.h"
+#include "../files.h"
+#include "../strings.h"
+#include "../fmt_fast.h"
+#include "../vector.h"
+#include "../queue.h"
+#include "../HashTable.h"
+#include "../DynamicVector.h"
+#include "../encoders/csv_encoding.h"
+
+#define MEMORY_IMPL
+#include "../memory.h"
+#define ALLOCATOR_IMPL
+#include "../allocator.h"
+#define FILES_IMPL
+#include "../files.h"
+#define VECTOR_IMPL
+#include "../vector.h"
+#define QUEUE_IMPL
+#include "../queue.h"
+#define STRINGS_IMPL
+#include "../strings.h"
+
+#define FMT_FAST_IMPL
+#include "../fmt_fast.h"
+
+#include "../HashTable.c"
+#include "../DynamicVector.cpp"
+#include "../encoders/csv_encoding.cpp"
+
+#define XXH_INLINE_ALL
+#include "../third-party/xxhash.h"
+
+// Micro benchmarks of our containers next to the std ones doing the same job.
+// Every row is one operation repeated over a working set of N elements and
+// reports:
+//
+//   ns/op        wall time over the whole loop divided by the operations
+//   misses/op    cache misses from perf_event_open, n/a when the kernel does
+//                not let us (containers, perf_event_paranoid, not Linux)
+//   bytes/elem   memory the container holds for its elements, slots and
+//                buckets included, divided by the element count
+//
+// hash_table keys look like the UI ones: short labels ("Button 12",
+// "ScrollBarView", ...) hashed with XXH3 and seeded with the id of a parent
+// from a shallow tree, the way UI_BuildObjectWithParent does it.
+//
+// Results go to stdout and to a CSV file (first argument, bench_containers.csv
+// by default) through csv_encoder.
+//
+
+#define BENCH_REPEAT 8
+
+typedef struct bench_counters bench_counters;
+struct bench_counters {
+  int Fd;
+  u64 Start;
+  std::chrono::time_point<std::chrono::steady_clock> T0;
+};
+
+typedef struct bench_row bench_row;
+struct bench_row {
+  const char* Container;
+  const char* Op;
+  u64         N;
+  F64         NsPerOp;
+  F64         MissesPerOp;  // < 0 when not available
+  F64         BytesPerElem; // < 0 when it does not apply
+};
+
+typedef struct bench_ctx bench_ctx;
+struct bench_ctx {
+  bench_row* Rows;
+  u32        RowCount;
+  u32        RowCapacity;
+  int        PerfFd;
+};
+
+// ------------------------------------------------------------------------ //
+// Counters
+
+fn_internal int
+BenchPerfOpen( void ) {
+#ifdef __linux__
+  struct perf_event_attr Attr;
+  memset( &Attr, 0, sizeof( Attr ) );
+  Attr.type           = PERF_TYPE_HARDWARE;
+  Attr.size           = sizeof( Attr );
+  Attr.config         = PERF_COUNT_HW_CACHE_MISSES;
+  Attr.disabled       = 1;
+  Attr.exclude_kernel = 1;
+  Attr.exclude_hv     = 1;
+  return (int)syscall( __NR_perf_event_open, &Attr, 0, -1, -1, 0 );
+#else
+  return -1;
+#endif
+}
+
+fn_internal u64
+BenchPerfRead( int Fd ) {
+  u64 Value = 0;
+#ifdef __linux__
+  if( Fd >= 0 && read( Fd, &Value, sizeof( Value ) ) != sizeof( Value ) ) {
+    Value = 0;
+  }
+#endif
+  return Value;
+}
+
+fn_internal bench_counters
+BenchBegin( bench_ctx* Ctx ) {
+  bench_counters C;
+  C.Fd    = Ctx->PerfFd;
+  C.Start = 0;
+#ifdef __linux__
+  if( C.Fd >= 0 ) {
+    ioctl( C.Fd, PERF_EVENT_IOC_ENABLE, 0 );
+    C.Start = BenchPerfRead( C.Fd );
+  }
+#endif
+  C.T0 = std::chrono::steady_clock::now();
+  return C;
+}
+
+fn_internal void
+BenchEnd( bench_ctx* Ctx, bench_counters* C, const char* Container, const char* Op, u64 N, u64 Ops, F64 BytesPerElem ) {
+  std::chrono::time_point T1 = std::chrono::steady_clock::now();
+  F64 Misses = -1;
+#ifdef __linux__
+  if( C->Fd >= 0 ) {
+    Misses = (F64)(BenchPerfRead( C->Fd ) - C->Start) / (F64)Ops;
+    ioctl( C->Fd, PERF_EVENT_IOC_DISABLE, 0 );
+  }
+#endif
+
+  if( Ctx->RowCount == Ctx->RowCapacity ) {
+    return;
+  }
+  bench_row* Row    = &Ctx->Rows[Ctx->RowCount++];
+  Row->Container    = Container;
+  Row->Op           = Op;
+  Row->N            = N;
+  Row->NsPerOp      = std::chrono::duration<F64, std::nano>( T1 - C->T0 ).count() / (F64)Ops;
+  Row->MissesPerOp  = Misses;
+  Row->BytesPerElem = BytesPerElem;
+
+  printf( "%-24s %-14s %9llu %10.2lf", Container, Op, (unsigned long long)N, Row->NsPerOp );
+  if( Misses >= 0 ) { printf( " %10.3lf", Misses ); } else { printf( " %10s", "n/a" ); }
+  if( BytesPerElem >= 0 ) { printf( " %10.1lf\n", BytesPerElem ); } else { printf( " %10s\n", "-" ); }
+  fflush( stdout );
+}
+
+// Keeps the optimizer from dropping loops whose results we don't use
+//
+global volatile u64 BenchSink;
+
+// ------------------------------------------------------------------------ //
+// std allocator that counts what the std containers hold
+
+global u64 BenchStdBytes;
+
+template <typename T>
+struct bench_counting_allocator {
+  typedef T value_type;
+
+  bench_counting_allocator() = default;
+  template <typename U> bench_counting_allocator( const bench_counting_allocator<U>& ) {}
+
+  T* allocate( size_t n ) {
+    BenchStdBytes += n * sizeof( T );
+    return (T*)malloc( n * sizeof( T ) );
+  }
+  void deallocate( T* p, size_t n ) {
+    BenchStdBytes -= n * sizeof( T );
+    free( p );
+  }
+
+  template <typename U> bool operator==( const bench_counting_allocator<U>& ) const { return true; }
+  template <typename U> bool operator!=( const bench_counting_allocator<U>& ) const { return false; }
+};
+
+typedef std::basic_string<char, std::char_traits<char>, bench_counting_allocator<char>> bench_std_string;
+
+struct bench_string_hash {
+  size_t operator()( const bench_std_string& s ) const { return XXH3_64bits( s.data(), s.size() ); }
+};
+
+// ------------------------------------------------------------------------ //
+// UI-like keys
+
+typedef struct bench_key bench_key;
+struct bench_key {
+  const char* Str;
+  u64         Len;
+  u64         Parent;
+  u64         Hash;   // what the table stores, for the Get rows
+};
+
+global const char* BenchWidgetNames[] = {
+  "Button", "Label", "TextBox", "ScrollBarView", "EndOfScroll", "TreeNode",
+  "Window", "Icon", "Send", "Download", "Details", "Folder"
+};
+
+fn_internal u64
+BenchXXHash( const u8* buffer, u64 len, u64 seed ) {
+  return XXH3_64bits_withSeed( buffer, len, seed );
+}
+
+fn_internal u32
+BenchRand( u32* State ) {
+  u32 x = *State;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *State = x;
+  return x;
+}
+
+// N labels spread over windows and containers: a few hundred parents, each
+// with a handful of children whose labels repeat across parents
+//
+fn_internal bench_key*
+BenchMakeKeys( Arena* Arena, u64 N, u32 Seed ) {
+  bench_key* Keys    = PushArray( Arena, bench_key, N );
+  u64*       Parents = PushArray( Arena, u64, (N / 8 + 1) );
+  u64        ParentCount = 1;
+  Parents[0] = 0;
+
+  for( u64 i = 0; i < N; i += 1 ) {
+    char Buffer[64];
+    const char* Name = BenchWidgetNames[BenchRand( &Seed ) % ArrayCount( BenchWidgetNames )];
+    int Len = snprintf( Buffer, sizeof( Buffer ), "%s %llu", Name, (unsigned long long)(i % 97) );
+
+    char* Str = PushArray( Arena, char, (Len + 1) );
+    memcpy( Str, Buffer, Len + 1 );
+
+    Keys[i].Str    = Str;
+    Keys[i].Len    = (u64)Len;
+    Keys[i].Parent = Parents[BenchRand( &Seed ) % ParentCount];
+    Keys[i].Hash   = BenchXXHash( (const u8*)Str, Len, Keys[i].Parent );
+
+    if( (i & 7) == 0 ) {
+      Parents[ParentCount++] = Keys[i].Hash;
+    }
+  }
+  return Keys;
+}
+
+// ------------------------------------------------------------------------ //
+// hash_table vs std::unordered_map
+
+fn_internal void
+BenchHashTable( bench_ctx* Ctx, Arena* Arena, u64 N ) {
+  Temp Scratch = TempBegin( Arena );
+
+  bench_key* Keys   = BenchMakeKeys( Arena, N, 0x1234567u + (u32)N );
+  bench_key* Misses = BenchMakeKeys( Arena, N, 0x7654321u + (u32)N );
+  for( u64 i = 0; i < N; i += 1 ) {
+    Misses[i].Parent ^= 0x9E3779B97F4A7C15ull;
+  }
+
+  u64 StackBytes = N * 128 + mebibyte( 1 );
+  Stack_Allocator Stack;
+  stack_init( &Stack, PushArray( Arena, u8, StackBytes ), StackBytes );
+
+  // Insert, starting small so growth is part of the cost
+  //
+  hash_table Table;
+  HashTableInit( &Table, &Stack, 16, BenchXXHash );
+  bench_counters C = BenchBegin( Ctx );
+  for( u64 i = 0; i < N; i += 1 ) {
+    HashTableAdd( &Table, Keys[i].Str, (void*)(uintptr_t)(i + 1), Keys[i].Parent );
+  }
+  F64 TableBytes = (F64)(Table.Allocated * (sizeof( entry ) + 1) + HASH_TABLE_GROUP_WIDTH) / (F64)Table.Count;
+  BenchEnd( Ctx, &C, "hash_table", "insert", N, N, TableBytes );
+
+  u64 Sum = 0;
+  C = BenchBegin( Ctx );
+  for( u32 r = 0; r < BENCH_REPEAT; r += 1 ) {
+    for( u64 i = 0; i < N; i += 1 ) {
+      entry* Entry = HashTableFindPointer( &Table, Keys[i].Str, Keys[i].Parent );
+      Sum += (u64)(uintptr_t)Entry->Value;
+    }
+  }
+  BenchEnd( Ctx, &C, "hash_table", "find hit", N, N * BENCH_REPEAT, TableBytes );
+
+  C = BenchBegin( Ctx );
+  for( u32 r = 0; r < BENCH_REPEAT; r += 1 ) {
+    for( u64 i = 0; i < N; i += 1 ) {
+      Sum += HashTableFindPointer( &Table, Misses[i].Str, Misses[i].Parent ) != NULL;
+    }
+  }
+  BenchEnd( Ctx, &C, "hash_table", "find miss", N, N * BENCH_REPEAT, TableBytes );
+
+  C = BenchBegin( Ctx );
+  for( u32 r = 0; r < BENCH_REPEAT; r += 1 ) {
+    for( u64 i = 0; i < N; i += 1 ) {
+      Sum += (u64)(uintptr_t)HashTableGet( &Table, Keys[i].Hash, 0 );
+    }
+  }
+  BenchEnd( Ctx, &C, "hash_table", "get hashed", N, N * BENCH_REPEAT, TableBytes );
+
+  C = BenchBegin( Ctx );
+  for( u64 i = 0; i < N; i += 1 ) {
+    Sum += (u64)(uintptr_t)HashTableRemove( &Table, Keys[i].Str, Keys[i].Parent );
+  }
+  BenchEnd( Ctx, &C, "hash_table", "remove", N, N, TableBytes );
+
+  // Same keys in std::unordered_map, a string key can't carry the parent seed
+  // so it is keyed by the seeded hash for the string rows too
+  //
+  {
+    typedef std::unordered_map<bench_std_string, void*, bench_string_hash, std::equal_to<bench_std_string>,
+                               bench_counting_allocator<std::pair<const bench_std_string, void*>>> string_map;
+    BenchStdBytes = 0;
+    string_map* Map = new string_map();
+
+    std::vector<bench_std_string> StdKeys( N );
+    std::vector<bench_std_string> StdMisses( N );
+    for( u64 i = 0; i < N; i += 1 ) {
+      char Buffer[96];
+      int  Len = snprintf( Buffer, sizeof( Buffer ), "%s#%016llx", Keys[i].Str, (unsigned long long)Keys[i].Parent );
+      StdKeys[i].assign( Buffer, Len );
+      Len = snprintf( Buffer, sizeof( Buffer ), "%s#%016llx", Misses[i].Str, (unsigned long long)Misses[i].Parent );
+      StdMisses[i].assign( Buffer, Len );
+    }
+    u64 KeyBytes = BenchStdBytes;
+
+    C = BenchBegin( Ctx );
+    for( u64 i = 0; i < N; i += 1 ) {
+      Map->emplace( StdKeys[i], (void*)(uintptr_t)(i + 1) );
+    }
+    F64 MapBytes = (F64)(BenchStdBytes - KeyBytes) / (F64)Map->size();
+    BenchEnd( Ctx, &C, "std::unordered_map<str>", "insert", N, N, MapBytes );
+
+    C = BenchBegin( Ctx );
+    for( u32 r = 0; r < BENCH_REPEAT; r += 1 ) {
+      for( u64 i = 0; i < N; i += 1 ) {
+        Sum += (u64)(uintptr_t)Map->find( StdKeys[i] )->second;
+      }
+    }
+    BenchEnd( Ctx, &C, "std::unordered_map<str>", "find hit", N, N * BENCH_REPEAT, MapBytes );
+
+    C = BenchBegin( Ctx );
+    for( u32 r = 0; r < BENCH_REPEAT; r += 1 ) {
+      for( u64 i = 0; i < N; i += 1 ) {
+        Sum += Map->find( StdMisses[i] ) != Map->end();
+      }
+    }
+    BenchEnd( Ctx, &C, "std::unordered_map<str>", "find miss", N, N * BENCH_REPEAT, MapBytes );
+
+    C = BenchBegin( Ctx );
+    for( u64 i = 0; i < N; i += 1 ) {
+      Sum += Map->erase( StdKeys[i] );
+    }
+    BenchEnd( Ctx, &C, "std::unordered_map<str>", "remove", N, N, MapBytes );
+    delete Map;
+  }
+
+  {
+    typedef std::unordered_map<u64, void*, std::hash<u64>, std::equal_to<u64>,
+                               bench_counting_allocator<std::pair<const u64, void*>>> hash_map;
+    BenchStdBytes = 0;
+    hash_map Map;
+    for( u64 i = 0; i < N; i += 1 ) {
+      Map.emplace( Keys[i].Hash, (void*)(uintptr_t)(i + 1) );
+    }
+    F64 MapBytes = (F64)BenchStdBytes / (F64)Map.size();
+
+    C = BenchBegin( Ctx );
+    for( u32 r = 0; r < BENCH_REPEAT; r += 1 ) {
+      for( u64 i = 0; i < N; i += 1 ) {
+        Sum += (u64)(uintptr_t)Map.find( Keys[i].Hash )->second;
+      }
+    }
+    BenchEnd( Ctx, &C, "std::unordered_map<u64>", "get hashed", N, N * BENCH_REPEAT, MapBytes );
+  }
+
+  BenchSink = Sum;
+  TempEnd( Scratch );
+}
+
+// ------------------------------------------------------------------------ //
+// concurrent_hash_table under add/remove churn
+//
+// N keys stay live while distinct keys keep coming in and going out, the way
+// resource names do. Removes leave tombstones and every rebuild has to reuse
+// a retired array, so the arena must stop growing once the table has reached
+// its size and gone through a couple of rebuilds there.
+
+fn_internal void
+BenchConcurrentChurn( bench_ctx* Ctx, u64 N ) {
+  concurrent_hash_table Table;
+  ConcurrentHashTableInit( &Table, N * 2, NULL );
+
+  u64 Rounds  = 16;
+  u64 Ops     = N * Rounds;
+  u64 WarmPos = 0;
+  u64 Sum     = 0;
+  bench_counters C = BenchBegin( Ctx );
+  for( u64 i = 0; i < Ops; i += 1 ) {
+    hash_key Key = {};
+    Key.Hash = (i + 1) * 0x9E3779B97F4A7C15ull;
+    ConcurrentHashTableAdd( &Table, Key, (void*)(uintptr_t)(i + 1) );
+    if( i >= N ) {
+      Sum += (u64)(uintptr_t)ConcurrentHashTableRemove( &Table, (i + 1 - N) * 0x9E3779B97F4A7C15ull );
+    }
+    if( i == Ops / 2 ) {
+      WarmPos = ArenaPos( Table.Backing );
+    }
+  }
+  u64 EndPos = ArenaPos( Table.Backing );
+  BenchEnd( Ctx, &C, "concurrent_hash_table", "churn", N, Ops * 2, (F64)EndPos / (F64)N );
+
+  if( EndPos != WarmPos ) {
+    printf( "[ERROR] concurrent_hash_table grew from %llu to %llu bytes under churn\n",
+            (unsigned long long)WarmPos, (unsigned long long)EndPos );
+  }
+  assert( EndPos == WarmPos && "concurrent_hash_table leaks arrays under churn" );
+
+  BenchSink = Sum;
+  ConcurrentHashTableRelease( &Table );
+}
+
+// ------------------------------------------------------------------------ //
+// vector, dyn_vector vs std::vector
+
+fn_internal void
+BenchVectors( bench_ctx* Ctx, Arena* Arena, u64 N ) {
+  Temp Scratch = TempBegin( Arena );
+  u64  Sum     = 0;
+
+  {
+    vector V = VectorNew( PushArray( Arena, u32, N ), 0, (u32)N, u32 );
+    bench_counters C = BenchBegin( Ctx );
+    for( u32 i = 0; i < N; i += 1 ) {
+      VectorAppend( &V, &i );
+    }
+    F64 Bytes = (F64)V.capacity * V.data_size / (F64)V.len;
+    BenchEnd( Ctx, &C, "vector", "append", N, N, Bytes );
+
+    C = BenchBegin( Ctx );
+    for( u32 r = 0; r < BENCH_REPEAT; r += 1 ) {
+      for( u32 i = 0; i < N; i += 1 ) {
+        Sum += *(u32*)VectorGet( &V, i );
+      }
+    }
+    BenchEnd( Ctx, &C, "vector", "get", N, N * BENCH_REPEAT, Bytes );
+  }
+
+  {
+    dyn_vector<u32> V = dyn_vector<u32>::Init( Arena, N );
+    bench_counters C = BenchBegin( Ctx );
+    for( u32 i = 0; i < N; i += 1 ) {
+      V.Append( (u32)i );
+    }
+    F64 Bytes = (F64)V.Size * sizeof( u32 ) / (F64)V.Length();
+    BenchEnd( Ctx, &C, "dyn_vector", "append", N, N, Bytes );
+
+    C = BenchBegin( Ctx );
+    for( u32 r = 0; r < BENCH_REPEAT; r += 1 ) {
+      for( u32 i = 0; i < N; i += 1 ) {
+        Sum += V.At( i );
+      }
+    }
+    BenchEnd( Ctx, &C, "dyn_vector", "get", N, N * BENCH_REPEAT, Bytes );
+  }
+
+  {
+    BenchStdBytes = 0;
+    std::vector<u32, bench_counting_allocator<u32>> V;
+    bench_counters C = BenchBegin( Ctx );
+    for( u32 i = 0; i < N; i += 1 ) {
+      V.push_back( i );
+    }
+    F64 Bytes = (F64)BenchStdBytes / (F64)V.size();
+    BenchEnd( Ctx, &C, "std::vector", "append", N, N, Bytes );
+
+    C = BenchBegin( Ctx );
+    for( u32 r = 0; r < BENCH_REPEAT; r += 1 ) {
+      for( u32 i = 0; i < N; i += 1 ) {
+        Sum += V[i];
+      }
+    }
+    BenchEnd( Ctx, &C, "std::vector", "get", N, N * BENCH_REPEAT, Bytes );
+  }
+
+  BenchSink = Sum;
+  TempEnd( Scratch );
+}
+
+// ------------------------------------------------------------------------ //
+// queue vs std::deque
+
+fn_internal void
+BenchQueues( bench_ctx* Ctx, Arena* Arena, u64 N ) {
+  Temp Scratch = TempBegin( Arena );
+  u64  Sum     = 0;
+
+  {
+    queue Q = QueueInit( PushArray( Arena, u64, N ), 0, (u32)N, sizeof( u64 ) );
+    bench_counters C = BenchBegin( Ctx );
+    for( u32 r = 0; r < BENCH_REPEAT; r += 1 ) {
+      QueueClear( &Q );
+      for( u64 i = 0; i < N; i += 1 ) {
+        QueuePush( &Q, &i );
+      }
+      for( u64 i = 0; i < N; i += 1 ) {
+        Sum += *QueueGetFront( &Q, u64 );
+        QueuePopRaw( &Q );
+      }
+    }
+    BenchEnd( Ctx, &C, "queue", "push+pop", N, 2 * N * BENCH_REPEAT, (F64)Q.capacity * Q.data_size / (F64)N );
+  }
+
+  {
+    BenchStdBytes = 0;
+    std::deque<u64, bench_counting_allocator<u64>> Q;
+    u64 Peak = 0;
+    bench_counters C = BenchBegin( Ctx );
+    for( u32 r = 0; r < BENCH_REPEAT; r += 1 ) {
+      for( u64 i = 0; i < N; i += 1 ) {
+        Q.push_back( i );
+      }
+      Peak = Peak > BenchStdBytes ? Peak : BenchStdBytes;
+      for( u64 i = 0; i < N; i += 1 ) {
+        Sum += Q.front();
+        Q.pop_front();
+      }
+    }
+    BenchEnd( Ctx, &C, "std::deque", "push+pop", N, 2 * N * BENCH_REPEAT, (F64)Peak / (F64)N );
+  }
+
+  BenchSink = Sum;
+  TempEnd( Scratch );
+}
+
+// ------------------------------------------------------------------------ //
+// U8_String vs std::string
+
+fn_internal void
+BenchStrings( bench_ctx* Ctx, Arena* Arena, u64 N ) {
+  Temp Scratch = TempBegin( Arena );
+  u64  Sum     = 0;
+  const char* Piece = "label ";
+  u64 PieceLen = 6;
+
+  u64 StackBytes = N * PieceLen * 2 + kibibyte( 64 );
+  Stack_Allocator Stack;
+  stack_init( &Stack, PushArray( Arena, u8, StackBytes ), StackBytes );
+
+  {
+    U8_String S = StringCreate( N * PieceLen + 1, &Stack );
+    bench_counters C = BenchBegin( Ctx );
+    for( u64 i = 0; i < N; i += 1 ) {
+      StringAppend( &S, Piece );
+    }
+    F64 Bytes = (F64)S.len / (F64)S.idx;
+    BenchEnd( Ctx, &C, "U8_String", "append", N, N, Bytes );
+
+    // Edits in the middle of a short string, the text box case
+    //
+    U8_String T = StringCreate( 4096, &Stack );
+    StringAppend( &T, "The quick brown fox jumps over the lazy dog" );
+    C = BenchBegin( Ctx );
+    for( u64 i = 0; i < N; i += 1 ) {
+      StringInsert( &T, 20, "x" );
+      StringErase( &T, 20 );
+    }
+    Sum += T.idx;
+    BenchEnd( Ctx, &C, "U8_String", "insert+erase", N, 2 * N, -1 );
+  }
+
+  {
+    BenchStdBytes = 0;
+    bench_std_string S;
+    bench_counters C = BenchBegin( Ctx );
+    for( u64 i = 0; i < N; i += 1 ) {
+      S.append( Piece, PieceLen );
+    }
+    F64 Bytes = (F64)BenchStdBytes / (F64)S.size();
+    BenchEnd( Ctx, &C, "std::string", "append", N, N, Bytes );
+
+    bench_std_string T = "The quick brown fox jumps over the lazy dog";
+    C = BenchBegin( Ctx );
+    for( u64 i = 0; i < N; i += 1 ) {
+      T.insert( 20, "x", 1 );
+      T.erase( 20, 1 );
+    }
+    Sum += T.size();
+    BenchEnd( Ctx, &C, "std::string", "insert+erase", N, 2 * N, -1 );
+  }
+
+  BenchSink = Sum;
+  TempEnd( Scratch );
+}
+
+// ------------------------------------------------------------------------ //
+
+fn_internal void
+BenchWriteCsv( bench_ctx* Ctx, const char* Path, Arena* Arena ) {
+  remove( Path );
+
+  csv_encoder Enc = CSV_Init( Path, 6, Arena );
+  const char* ColumnNames[] = { "container", "op", "n", "ns_per_op", "cache_misses_per_op", "bytes_per_elem" };
+  CSV_SetTitleNames( &Enc, ColumnNames );
+
+  for( u32 i = 0; i < Ctx->RowCount; i += 1 ) {
+    bench_row* Row = &Ctx->Rows[i];
+    char Ns[32], Misses[32], Bytes[32];
+    snprintf( Ns, sizeof( Ns ), "%.3lf", Row->NsPerOp );
+    if( Row->MissesPerOp >= 0 ) { snprintf( Misses, sizeof( Misses ), "%.4lf", Row->MissesPerOp ); } else { Misses[0] = 0; }
+    if( Row->BytesPerElem >= 0 ) { snprintf( Bytes, sizeof( Bytes ), "%.2lf", Row->BytesPerElem ); } else { Bytes[0] = 0; }
+
+    CSV_BeginRow( &Enc );
+    CSV_PushValue( &Enc, Row->Container );
+    CSV_PushValue( &Enc, Row->Op );
+    CSV_PushU64( &Enc, Row->N );
+    CSV_PushValue( &Enc, Ns );
+    CSV_PushValue( &Enc, Misses );
+    CSV_PushValue( &Enc, Bytes );
+    CSV_EndRow( &Enc );
+  }
+
+  CSV_WriteToFile( &Enc );
+  CSV_Destroy( &Enc );
+}
+
+int main( int argc, char** argv ) {
+  const char* CsvPath = argc > 1 ? argv[1] : "./bench_containers.csv";
+
+  Arena* Arena = ArenaAllocDefault();
+
+  bench_ctx Ctx   = {};
+  Ctx.RowCapacity = 256;
+  Ctx.Rows        = PushArray( Arena, bench_row, Ctx.RowCapacity );
+  Ctx.PerfFd      = BenchPerfOpen();
+  if( Ctx.PerfFd < 0 ) {
+    printf( "perf_event_open not available, cache misses are n/a\n" );
+  }
+
+  printf( "%-24s %-14s %9s %10s %10s %10s\n", "container", "op", "n", "ns/op", "misses/op", "bytes/elem" );
+
+  // UI sized tables (a few thousand widgets) and one that spills out of cache
+  //
+  u64 Sizes[] = { 4096, 262144 };
+  for( u32 i = 0; i < ArrayCount( Sizes ); i += 1 ) {
+    BenchHashTable( &Ctx, Arena, Sizes[i] );
+    BenchConcurrentChurn( &Ctx, Sizes[i] );
+    BenchVectors( &Ctx, Arena, Sizes[i] );
+    BenchQueues( &Ctx, Arena, Sizes[i] );
+    BenchStrings( &Ctx, Arena, Sizes[i] );
+  }
+
+  BenchWriteCsv( &Ctx, CsvPath, Arena );
+  printf( "Wrote %s\n", CsvPath );
+
+#ifdef __linux__
+  if( Ctx.PerfFd >= 0 ) {
+    close( Ctx.PerfFd );
+  }
+#endif
+  return 0;
+}
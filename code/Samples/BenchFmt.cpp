@@ -0,0 +1,177 @@
+#include <chrono>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../types.h"
+
+#include "../memory.h"
+#include "../allocator.h"
+#include "../strings.h"
+#include "../fmt_fast.h"
+
+#define MEMORY_IMPL
+#include "../memory.h"
+#define ALLOCATOR_IMPL
+#include "../allocator.h"
+#define STRINGS_IMPL
+#include "../strings.h"
+#define FMT_FAST_IMPL
+#include "../fmt_fast.h"
+
+// fmt_fast.h against snprintf on the same values, ns per number. Integers
+// have random magnitudes so every digit count shows up. Doubles are compared
+// with "%.17g", the shortest printf format that always reads back the same
+// (fmt writes fewer digits than that), and with "%.3f". The csv row case
+// formats 2 integers and 3 doubles into a string_builder per row, either
+// typed or through snprintf plus an append.
+//
+// The count of values can be changed with the first argument.
+//
+
+#define BENCH_REPS 8
+
+enum {
+  BENCH_U64,
+  BENCH_I64,
+  BENCH_F64,
+  BENCH_F64_FIXED,
+  BENCH_CSV_ROW,
+  BENCH_CASE_COUNT
+};
+
+global const char* BenchCaseNames[BENCH_CASE_COUNT] = { "u64", "i64", "f64 shortest", "f64 %.3f", "csv row" };
+
+global volatile u64 BenchSink;
+
+typedef struct bench_values bench_values;
+struct bench_values {
+  u64* U;
+  i64* I;
+  F64* F;
+  u64  Count;
+};
+
+fn_internal u64
+BenchRand( u64* State ) {
+  u64 x = *State;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  *State = x;
+  return x;
+}
+
+// Level 0 is snprintf, 1 is fmt_fast
+//
+fn_internal u64
+BenchCase( u32 Case, u32 Level, bench_values* Values, string_builder* Rows ) {
+  char Buffer[64];
+  u8   Out[FMT_F64_FIXED_SIZE( 3 )];
+  u64  Sum = 0;
+
+  switch( Case ) {
+    case BENCH_U64: {
+      for( u64 i = 0; i < Values->Count; i += 1 ) {
+        Sum += Level == 0 ? snprintf( Buffer, sizeof( Buffer ), "%llu", (unsigned long long)Values->U[i] ) : FmtU64( Out, Values->U[i] );
+      }
+    } break;
+    case BENCH_I64: {
+      for( u64 i = 0; i < Values->Count; i += 1 ) {
+        Sum += Level == 0 ? snprintf( Buffer, sizeof( Buffer ), "%lld", (long long)Values->I[i] ) : FmtI64( Out, Values->I[i] );
+      }
+    } break;
+    case BENCH_F64: {
+      for( u64 i = 0; i < Values->Count; i += 1 ) {
+        Sum += Level == 0 ? snprintf( Buffer, sizeof( Buffer ), "%.17g", Values->F[i] ) : FmtF64( Out, Values->F[i] );
+      }
+    } break;
+    case BENCH_F64_FIXED: {
+      for( u64 i = 0; i < Values->Count; i += 1 ) {
+        Sum += Level == 0 ? snprintf( Buffer, sizeof( Buffer ), "%.3f", Values->F[i] ) : FmtF64Fixed( Out, Values->F[i], 3 );
+      }
+    } break;
+    case BENCH_CSV_ROW: {
+      StringBuilderClear( Rows );
+      for( u64 i = 0; i + 5 <= Values->Count; i += 5 ) {
+        if( Level == 0 ) {
+          i32 Len = snprintf( Buffer, sizeof( Buffer ), "%llu,%lld,%.17g,%.17g,%.17g\n",
+                              (unsigned long long)Values->U[i], (long long)Values->I[i + 1],
+                              Values->F[i + 2], Values->F[i + 3], Values->F[i + 4] );
+          StringBuilderAppendN( Rows, Buffer, Len );
+        } else {
+          StringBuilderAppendU64( Rows, Values->U[i] );
+          StringBuilderAppendChar( Rows, ',' );
+          StringBuilderAppendI64( Rows, Values->I[i + 1] );
+          StringBuilderAppendChar( Rows, ',' );
+          StringBuilderAppendF64( Rows, Values->F[i + 2] );
+          StringBuilderAppendChar( Rows, ',' );
+          StringBuilderAppendF64( Rows, Values->F[i + 3] );
+          StringBuilderAppendChar( Rows, ',' );
+          StringBuilderAppendF64( Rows, Values->F[i + 4] );
+          StringBuilderAppendChar( Rows, '\n' );
+        }
+      }
+      Sum += StringBuilderLength( Rows );
+    } break;
+  }
+  return Sum;
+}
+
+int main( int argc, char** argv ) {
+  u64 Count = 1 << 20;
+  if( argc > 1 ) {
+    Count = (u64)strtoull( argv[1], NULL, 10 );
+  }
+  if( Count < 5 ) {
+    Count = 5;
+  }
+
+  Arena* Arena = ArenaAlloc( DEFAULT_RESERVE );
+
+  bench_values Values = {};
+  Values.Count = Count;
+  Values.U     = PushArray( Arena, u64, Count );
+  Values.I     = PushArray( Arena, i64, Count );
+  Values.F     = PushArray( Arena, F64, Count );
+
+  // Doubles are a mix of "measured" values (few significant digits, the
+  // common case in csv files and labels) and random bit patterns
+  //
+  u64 State = 0x9E3779B97F4A7C15ull;
+  for( u64 i = 0; i < Count; i += 1 ) {
+    Values.U[i] = BenchRand( &State ) >> (BenchRand( &State ) % 64);
+    Values.I[i] = (i64)(BenchRand( &State ) >> (BenchRand( &State ) % 64)) * ((i & 1) ? -1 : 1);
+    if( i & 1 ) {
+      Values.F[i] = (F64)(BenchRand( &State ) % 10000000) / 1000.0;
+    } else {
+      u64 Bits = BenchRand( &State ) & ~(0x7FFull << 52);
+      Bits    |= (u64)(900 + BenchRand( &State ) % 250) << 52;
+      memcpy( &Values.F[i], &Bits, sizeof( Bits ) );
+    }
+  }
+
+  string_builder Rows;
+  StringBuilderInit( &Rows, ArenaAlloc( DEFAULT_RESERVE ), 0 );
+
+  printf( "%-14s %12s %12s %10s   (ns per number, %llu numbers)\n", "case", "snprintf", "fmt_fast", "speedup", (unsigned long long)Count );
+  for( u32 Case = 0; Case < BENCH_CASE_COUNT; Case += 1 ) {
+    F64 Ns[2];
+    for( u32 Level = 0; Level < 2; Level += 1 ) {
+      // One warm up pass, then the timed ones
+      //
+      BenchSink += BenchCase( Case, Level, &Values, &Rows );
+
+      std::chrono::time_point t0 = std::chrono::steady_clock::now();
+      for( u32 r = 0; r < BENCH_REPS; r += 1 ) {
+        BenchSink += BenchCase( Case, Level, &Values, &Rows );
+      }
+      std::chrono::time_point t1 = std::chrono::steady_clock::now();
+      Ns[Level] = std::chrono::duration<F64, std::nano>( t1 - t0 ).count() / ((F64)Count * BENCH_REPS);
+    }
+    printf( "%-14s %12.2lf %12.2lf %9.2lfx\n", BenchCaseNames[Case], Ns[0], Ns[1], Ns[0] / Ns[1] );
+  }
+
+  return 0;
+}
@@ -0,0 +1,229 @@
+#include <chrono>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <wchar.h>
+#include <locale.h>
+
+#include "../types.h"
+
+#include "../memory.h"
+#include "../allocator.h"
+#include "../strings.h"
+
+#define MEMORY_IMPL
+#include "../memory.h"
+#define ALLOCATOR_IMPL
+#include "../allocator.h"
+#define STRINGS_IMPL
+#include "../strings.h"
+
+// Throughput of the strings.h byte kernels on 1 KB to 1 GB of text (the
+// largest size can be lowered with the first argument, in MB). Every kernel
+// runs at every level the CPU supports plus the libc call doing the same job,
+// and prints GB/s. The text is letters, digits and spaces, so:
+//
+//   find / find last   look for '\n', which is never there, full scan
+//   count              counts ' '
+//   find any           looks for "\t\r\n", never there, full scan
+//   length             strlen, the terminator is the last byte
+//   utf8 valid         Utf8Validate against mbstowcs in a UTF-8 locale
+//   utf8 dec           Utf8Decode into a BENCH_DECODE_SPAN codepoint buffer,
+//                      against mbsrtowcs into a wchar_t one
+//
+// Small sizes repeat until BENCH_BYTES_PER_RUN bytes went through, so each
+// row costs about the same.
+//
+
+#define BENCH_BYTES_PER_RUN ((u64)256 << 20)
+#define BENCH_DECODE_SPAN   4096
+
+enum {
+  BENCH_FIND,
+  BENCH_FIND_LAST,
+  BENCH_COUNT,
+  BENCH_FIND_ANY,
+  BENCH_LENGTH,
+  BENCH_UTF8_VALID,
+  BENCH_UTF8_DECODE,
+  BENCH_KERNEL_COUNT
+};
+
+global const char* BenchKernelNames[BENCH_KERNEL_COUNT] = { "find", "find last", "count", "find any", "length", "utf8 valid", "utf8 dec" };
+
+global volatile i64 BenchSink;
+
+global u32     BenchCodepoints[BENCH_DECODE_SPAN];
+global wchar_t BenchWide[BENCH_DECODE_SPAN];
+
+fn_internal i64
+BenchLibc( u32 Kernel, const u8* Data, u64 Size ) {
+  switch( Kernel ) {
+    case BENCH_FIND: {
+      const void* Ptr = memchr( Data, '\n', Size );
+      return Ptr ? (const u8*)Ptr - Data : -1;
+    }
+    case BENCH_FIND_LAST: {
+#ifdef __GLIBC__
+      const void* Ptr = memrchr( Data, '\n', Size );
+      return Ptr ? (const u8*)Ptr - Data : -1;
+#else
+      return -1;
+#endif
+    }
+    case BENCH_COUNT: {
+      i64 Count = 0;
+      const u8* End = Data + Size;
+      for( const u8* Ptr = Data; (Ptr = (const u8*)memchr( Ptr, ' ', End - Ptr )) != NULL; Ptr += 1 ) {
+        Count += 1;
+      }
+      return Count;
+    }
+    case BENCH_FIND_ANY: {
+      return (i64)strcspn( (const char*)Data, "\t\r\n" );
+    }
+    case BENCH_LENGTH: {
+      return (i64)strlen( (const char*)Data );
+    }
+    case BENCH_UTF8_VALID: {
+      return (i64)mbstowcs( NULL, (const char*)Data, 0 );
+    }
+    case BENCH_UTF8_DECODE: {
+      mbstate_t   State = {};
+      const char* Src   = (const char*)Data;
+      i64         Count = 0;
+      while( Src != NULL ) {
+        size_t Written = mbsrtowcs( BenchWide, &Src, BENCH_DECODE_SPAN, &State );
+        if( Written == (size_t)-1 ) {
+          break;
+        }
+        Count += (i64)Written;
+      }
+      return Count;
+    }
+  }
+  return -1;
+}
+
+fn_internal i64
+BenchKernel( u32 Kernel, const u8* Data, u64 Size, const byte_set* Set ) {
+  switch( Kernel ) {
+    case BENCH_FIND:      return StringFindByte( Data, Size, '\n' );
+    case BENCH_FIND_LAST: return StringFindLastByte( Data, Size, '\n' );
+    case BENCH_COUNT:     return StringCountByte( Data, Size, ' ' );
+    case BENCH_FIND_ANY:  return StringFindAnyByte( Data, Size, Set );
+    case BENCH_LENGTH:    return StringLength( (const char*)Data );
+    case BENCH_UTF8_VALID: return Utf8Validate( Data, Size );
+    case BENCH_UTF8_DECODE: {
+      i64 Count = 0;
+      u64 Pos   = 0;
+      while( Pos < Size ) {
+        i64 Used = 0;
+        Count += Utf8Decode( Data + Pos, Size - Pos, BenchCodepoints, BENCH_DECODE_SPAN, &Used );
+        Pos   += Used;
+      }
+      return Count;
+    }
+  }
+  return -1;
+}
+
+// Level 0 is libc, the rest are STRING_KERNELS_*
+//
+fn_internal F64
+BenchRun( u32 Level, u32 Kernel, const u8* Data, u64 Size, const byte_set* Set ) {
+  u64 Reps = BENCH_BYTES_PER_RUN / Size;
+  if( Reps == 0 ) {
+    Reps = 1;
+  }
+
+  i64 Sum = 0;
+  std::chrono::time_point t0 = std::chrono::steady_clock::now();
+  for( u64 r = 0; r < Reps; r += 1 ) {
+    Sum += Level == 0 ? BenchLibc( Kernel, Data, Size ) : BenchKernel( Kernel, Data, Size, Set );
+  }
+  std::chrono::time_point t1 = std::chrono::steady_clock::now();
+  BenchSink = Sum;
+
+  F64 Seconds = std::chrono::duration<F64>( t1 - t0 ).count();
+  return (F64)Size * Reps / Seconds / 1e9;
+}
+
+int main( int argc, char** argv ) {
+  u64 MaxSize = gigabyte( (u64)1 );
+  if( argc > 1 ) {
+    MaxSize = (u64)strtoull( argv[1], NULL, 10 ) << 20;
+  }
+
+  // Text with a terminator after the last byte for the length and libc rows
+  //
+  u8* Data = (u8*)malloc( MaxSize + 1 );
+  if( Data == NULL ) {
+    fprintf( stderr, "[ERROR] Could not allocate %llu bytes\n", (unsigned long long)MaxSize );
+    return 1;
+  }
+  const char Alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789     ";
+  u32 Rand = 0x2545F491;
+  for( u64 i = 0; i < MaxSize; i += 1 ) {
+    Rand ^= Rand << 13;
+    Rand ^= Rand >> 17;
+    Rand ^= Rand << 5;
+    Data[i] = (u8)Alphabet[Rand % (sizeof( Alphabet ) - 1)];
+  }
+
+  byte_set Set = ByteSetMake( "\t\r\n" );
+
+  if( setlocale( LC_CTYPE, "C.UTF-8" ) == NULL ) {
+    fprintf( stderr, "[WARNING] No C.UTF-8 locale, the libc utf8 rows are not decoding UTF-8\n" );
+  }
+
+  const char* LevelNames[] = { "libc", "scalar", "sse2", "avx2" };
+  bool        LevelOk[4]   = { true, false, false, false };
+  for( u32 Level = STRING_KERNELS_SCALAR; Level <= STRING_KERNELS_AVX2; Level += 1 ) {
+    LevelOk[Level] = StringSelectKernels( Level );
+  }
+
+  printf( "%-10s %-10s", "kernel", "size" );
+  for( u32 Level = 0; Level < ArrayCount( LevelNames ); Level += 1 ) {
+    if( LevelOk[Level] ) {
+      printf( " %10s", LevelNames[Level] );
+    }
+  }
+  printf( "   (GB/s)\n" );
+
+  for( u32 Kernel = 0; Kernel < BENCH_KERNEL_COUNT; Kernel += 1 ) {
+    for( u64 Size = kibibyte( (u64)1 ); Size <= MaxSize; Size *= 16 ) {
+      // length needs the terminator right after the block
+      //
+      u8 Saved   = Data[Size];
+      Data[Size] = 0;
+
+      char SizeName[32];
+      if( Size >= gigabyte( (u64)1 ) )      { snprintf( SizeName, sizeof( SizeName ), "%llu GB", (unsigned long long)(Size >> 30) ); }
+      else if( Size >= mebibyte( (u64)1 ) ) { snprintf( SizeName, sizeof( SizeName ), "%llu MB", (unsigned long long)(Size >> 20) ); }
+      else                                  { snprintf( SizeName, sizeof( SizeName ), "%llu KB", (unsigned long long)(Size >> 10) ); }
+
+      printf( "%-10s %-10s", BenchKernelNames[Kernel], SizeName );
+      for( u32 Level = 0; Level < ArrayCount( LevelNames ); Level += 1 ) {
+        if( !LevelOk[Level] ) {
+          continue;
+        }
+        if( Level != 0 ) {
+          StringSelectKernels( Level );
+        }
+        printf( " %10.2lf", BenchRun( Level, Kernel, Data, Size, &Set ) );
+        fflush( stdout );
+      }
+      printf( "\n" );
+
+      Data[Size] = Saved;
+      if( Size > MaxSize / 16 && Size != MaxSize ) {
+        Size = MaxSize / 16;
+      }
+    }
+  }
+
+  free( Data );
+  return 0;
+}
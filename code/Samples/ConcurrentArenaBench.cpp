@@ -0,0 +1,157 @@
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../types.h"
+
+#include "../memory.h"
+
+#define MEMORY_IMPL
+#include "../memory.h"
+
+// Every thread pushes BENCH_PUSHES small blocks (16 to 256 bytes) and writes
+// the first bytes of each, like a receive thread copying packets in. Runs 1 to
+// N threads against:
+//
+//   chunked  ConcurrentArena with per-thread chunks
+//   shared   ConcurrentArena with every push on the shared fetch-add
+//   locked   Arena behind a std::mutex, what you get today
+//   malloc
+//
+// and prints millions of pushes per second for the whole process.
+//
+
+#define BENCH_PUSHES 2000000
+
+enum {
+  BENCH_CHUNKED,
+  BENCH_SHARED,
+  BENCH_LOCKED,
+  BENCH_MALLOC,
+  BENCH_COUNT
+};
+
+global const char* BenchNames[BENCH_COUNT] = { "chunked", "shared", "locked", "malloc" };
+
+typedef struct bench_shared bench_shared;
+struct bench_shared {
+  u32              Mode;
+  ConcurrentArena* Concurrent;
+  Arena*           Locked;
+  std::mutex       Lock;
+  volatile bool    Go;
+};
+
+fn_internal void
+BenchWorker( bench_shared* Shared, u32 Seed, void** Keep ) {
+  while( !Shared->Go ) {
+    std::this_thread::yield();
+  }
+
+  u32 Rand = Seed * 2654435761u + 1;
+  for( u32 i = 0; i < BENCH_PUSHES; i += 1 ) {
+    Rand ^= Rand << 13;
+    Rand ^= Rand >> 17;
+    Rand ^= Rand << 5;
+    u64 Size = 16 + (Rand & 240);
+
+    u8* Ptr = NULL;
+    switch( Shared->Mode ) {
+      case BENCH_CHUNKED:
+      case BENCH_SHARED: {
+        Ptr = (u8*)ConcurrentArenaPush( Shared->Concurrent, Size );
+      } break;
+      case BENCH_LOCKED: {
+        Shared->Lock.lock();
+        Ptr = (u8*)ArenaPush( Shared->Locked, Size );
+        Shared->Lock.unlock();
+      } break;
+      case BENCH_MALLOC: {
+        Ptr = (u8*)malloc( Size );
+        Keep[i] = Ptr;
+      } break;
+    }
+
+    if( Ptr == NULL ) {
+      fprintf( stderr, "[ERROR] push failed\n" );
+      return;
+    }
+    memset( Ptr, (int)i, 16 );
+  }
+}
+
+fn_internal F64
+BenchRun( u32 Mode, u32 Threads ) {
+  bench_shared Shared;
+  Shared.Mode       = Mode;
+  Shared.Concurrent = NULL;
+  Shared.Locked     = NULL;
+  Shared.Go         = false;
+
+  void** Keep = NULL;
+  switch( Mode ) {
+    case BENCH_CHUNKED: Shared.Concurrent = ConcurrentArenaAlloc( gigabyte( 8 ), CONCURRENT_ARENA_CHUNK ); break;
+    case BENCH_SHARED:  Shared.Concurrent = ConcurrentArenaAlloc( gigabyte( 8 ), 0 );                      break;
+    case BENCH_LOCKED:  Shared.Locked     = ArenaAllocDefault();                                          break;
+    case BENCH_MALLOC:  Keep = (void**)calloc( (size_t)Threads * BENCH_PUSHES, sizeof( void* ) );          break;
+  }
+
+  std::thread* Workers = new std::thread[Threads];
+  for( u32 i = 0; i < Threads; i += 1 ) {
+    Workers[i] = std::thread( BenchWorker, &Shared, i + 1, Keep ? Keep + (size_t)i * BENCH_PUSHES : NULL );
+  }
+
+  std::chrono::time_point t0 = std::chrono::steady_clock::now();
+  Shared.Go = true;
+  for( u32 i = 0; i < Threads; i += 1 ) {
+    Workers[i].join();
+  }
+  std::chrono::time_point t1 = std::chrono::steady_clock::now();
+  delete[] Workers;
+
+  switch( Mode ) {
+    case BENCH_CHUNKED:
+    case BENCH_SHARED: ConcurrentArenaRelease( Shared.Concurrent ); break;
+    case BENCH_LOCKED: ArenaRelease( Shared.Locked );               break;
+    case BENCH_MALLOC: {
+      for( size_t i = 0; i < (size_t)Threads * BENCH_PUSHES; i += 1 ) {
+        free( Keep[i] );
+      }
+      free( Keep );
+    } break;
+  }
+
+  F64 Seconds = std::chrono::duration<F64>( t1 - t0 ).count();
+  return (F64)Threads * BENCH_PUSHES / Seconds / 1e6;
+}
+
+int main( void ) {
+  u32 Cores = std::thread::hardware_concurrency();
+  if( Cores == 0 ) {
+    Cores = 1;
+  }
+
+  printf( "%-8s", "threads" );
+  for( u32 Mode = 0; Mode < BENCH_COUNT; Mode += 1 ) {
+    printf( " %12s", BenchNames[Mode] );
+  }
+  printf( "   (M pushes/s)\n" );
+
+  for( u32 Threads = 1; ; Threads = Threads * 2 < Cores ? Threads * 2 : Cores ) {
+    printf( "%-8u", Threads );
+    for( u32 Mode = 0; Mode < BENCH_COUNT; Mode += 1 ) {
+      printf( " %12.2lf", BenchRun( Mode, Threads ) );
+      fflush( stdout );
+    }
+    printf( "\n" );
+    if( Threads == Cores ) {
+      break;
+    }
+  }
+
+  return 0;
+}
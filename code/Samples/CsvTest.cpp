@@ -2,24 +2,32 @@
 
 #include "../memory.h"
 #include "../allocator.h"
+#include "../alloc_trace.h"
 #include "../files.h"
 #include "../strings.h"
+#include "../fmt_fast.h"
 #include "../encoders/csv_encoding.h"
 
 #define MEMORY_IMPL
 #include "../memory.h"
 #define ALLOCATOR_IMPL
 #include "../allocator.h"
+#define ALLOC_TRACE_IMPL
+#include "../alloc_trace.h"
 #define FILES_IMPL
 #include "../files.h"
 #define STRINGS_IMPL
 #include "../strings.h"
 
+#define FMT_FAST_IMPL
+#include "../fmt_fast.h"
+
 #include "../encoders/csv_encoding.cpp"
 
 #include <chrono>
 
 int main( void ) {
+  AllocTraceBegin("./csv_test.trace");
 
   printf("Creating a CSV file of 5 columns, 3 million rows\n");
 
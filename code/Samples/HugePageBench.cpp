@@ -0,0 +1,267 @@
+#include <chrono>
+#if __linux__
+#include <X11/Xlib.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#define VK_USE_PLATFORM_XLIB_KHR
+#elif _WIN32
+#define VK_USE_PLATFORM_WIN32_KHR
+#endif
+#include <vulkan/vulkan.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include "../third-party/stb_truetype.h"
+
+#include "../types.h"
+#include "../memory.h"
+#include "../allocator.h"
+#include "../strings.h"
+#include "../fmt_fast.h"
+#include "../vector.h"
+#include "../queue.h"
+#include "../files.h"
+
+#include "../load_font.h"
+#include "../window_creation.h"
+#include "../third-party/vk_mem_alloc.h"
+#include "../vk_render.h"
+#include "../draw.h"
+#include "../encoders/csv_encoding.h"
+
+#define MEMORY_IMPL
+#include "../memory.h"
+
+#define ALLOCATOR_IMPL
+#include "../allocator.h"
+
+#define STRINGS_IMPL
+#include "../strings.h"
+
+#define FMT_FAST_IMPL
+#include "../fmt_fast.h"
+
+#define VECTOR_IMPL
+#include "../vector.h"
+
+#define QUEUE_IMPL
+#include "../queue.h"
+
+#define FILES_IMPL
+#include "../files.h"
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "../third-party/stb_truetype.h"
+
+#define LOAD_FONT_IMPL
+#include "../load_font.h"
+
+#define DRAW_IMPL
+#include "../draw.h"
+
+#include "../encoders/csv_encoding.cpp"
+
+// Streams the CSV row buffer and the 2D draw bucket through arenas backed by
+// regular pages, transparent huge pages and hugetlbfs pages, and reports time
+// and dTLB read misses for each. TLB counters come from perf_event_open, when it
+// is not available (Windows, perf_event_paranoid, containers) only time is shown.
+//
+
+#define BENCH_CSV_ROWS    3000000
+#define BENCH_CSV_ROW_MAX 64 // five "My Value N" columns, delimiters and newline fit
+#define BENCH_RECT_FRAMES 60
+
+typedef struct bench_result bench_result;
+struct bench_result {
+  F64 Seconds;
+  u64 TlbMisses;
+  u64 Items;
+  u32 Flags;         // ARENA_FLAG_* the arena really got
+  bool HaveCounters;
+};
+
+fn_internal i32
+BenchCounterOpen( void ) {
+#ifdef __linux__
+  struct perf_event_attr Attr = {};
+  Attr.type           = PERF_TYPE_HW_CACHE;
+  Attr.size           = sizeof(Attr);
+  Attr.config         = PERF_COUNT_HW_CACHE_DTLB |
+                        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  Attr.disabled       = 1;
+  Attr.exclude_kernel = 1;
+  Attr.exclude_hv     = 1;
+  return (i32)syscall( SYS_perf_event_open, &Attr, 0, -1, -1, 0 );
+#else
+  return -1;
+#endif
+}
+
+fn_internal void
+BenchCounterStart( i32 Fd ) {
+#ifdef __linux__
+  if( Fd >= 0 ) {
+    ioctl( Fd, PERF_EVENT_IOC_RESET, 0 );
+    ioctl( Fd, PERF_EVENT_IOC_ENABLE, 0 );
+  }
+#endif
+}
+
+fn_internal u64
+BenchCounterStop( i32 Fd ) {
+  u64 Count = 0;
+#ifdef __linux__
+  if( Fd >= 0 ) {
+    ioctl( Fd, PERF_EVENT_IOC_DISABLE, 0 );
+    if( read( Fd, &Count, sizeof(Count) ) != sizeof(Count) ) {
+      Count = 0;
+    }
+  }
+#endif
+  return Count;
+}
+
+fn_internal const char*
+BenchFlagsName( u32 Flags ) {
+  if( Flags & ARENA_FLAG_HUGE_EXPLICIT ) return "hugetlb";
+  if( Flags & ARENA_FLAG_HUGE_HINT )     return "thp";
+  return "4k";
+}
+
+// hugetlbfs pages are taken from the pool for the whole reservation at map time,
+// so the arenas reserve what the stream needs instead of DEFAULT_RESERVE
+//
+fn_internal void
+BenchReportFallback( const char* Stream, u32 Asked, u32 Got, u64 Reserve ) {
+  if( (Asked & ARENA_FLAG_HUGE_EXPLICIT) && (Got & ARENA_FLAG_HUGE_EXPLICIT) == 0 ) {
+    printf( "[WARNING] %s: hugetlb pool can't hold %llu MiB (%llu pages), fell back to %s. See /proc/sys/vm/nr_hugepages\n",
+            Stream, (unsigned long long)(Reserve >> 20),
+            (unsigned long long)((Reserve + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE), BenchFlagsName( Got ) );
+  }
+}
+
+fn_internal bench_result
+BenchCsvStream( u32 Flags, i32 CounterFd ) {
+  bench_result Result = {};
+
+  u64 Reserve  = (u64)BENCH_CSV_ROWS * BENCH_CSV_ROW_MAX + mebibyte(16);
+  Arena* Arena = ArenaAllocEx( Reserve, Flags );
+  Result.Flags = Arena->flags;
+  BenchReportFallback( "csv", Flags, Arena->flags, Reserve );
+
+  csv_encoder Enc = CSV_Init( "./HugePageBench.csv", 5, Arena );
+
+  std::chrono::time_point t0 = std::chrono::high_resolution_clock::now();
+  BenchCounterStart( CounterFd );
+
+  for( u64 i = 0; i < BENCH_CSV_ROWS; i += 1 ) {
+    CSV_BeginRow( &Enc );
+    CSV_PushValue( &Enc, "My Value 1" );
+    CSV_PushValue( &Enc, "My Value 2" );
+    CSV_PushValue( &Enc, "My Value 3" );
+    CSV_PushValue( &Enc, "My Value 4" );
+    CSV_PushValue( &Enc, "My Value 5" );
+    CSV_EndRow( &Enc );
+  }
+
+  Result.TlbMisses = BenchCounterStop( CounterFd );
+  std::chrono::time_point t1 = std::chrono::high_resolution_clock::now();
+  Result.Seconds = std::chrono::duration<F64>( t1 - t0 ).count();
+  Result.Items   = StringBuilderLength( &Enc.Rows );
+
+  CSV_Destroy( &Enc );
+  ArenaRelease( Arena );
+
+  return Result;
+}
+
+fn_internal bench_result
+BenchRectStream( u32 Flags, i32 CounterFd ) {
+  bench_result Result = {};
+
+  u64 BucketSize = sizeof(v_2d) * MinVec2D_Size + mebibyte(2);
+  u64 Reserve    = BucketSize + mebibyte(4);
+  Arena* Arena   = ArenaAllocEx( Reserve, Flags );
+  Result.Flags   = Arena->flags;
+  BenchReportFallback( "rect", Flags, Arena->flags, Reserve );
+
+  Stack_Allocator Allocator;
+  stack_init( &Allocator, PushArray( Arena, u8, BucketSize ), BucketSize );
+  draw_bucket_instance Draw = D_DrawInit( &Allocator );
+
+  vec4 Color = { 0.2f, 0.4f, 0.6f, 1.0f };
+
+  std::chrono::time_point t0 = std::chrono::high_resolution_clock::now();
+  BenchCounterStart( CounterFd );
+
+  for( u32 Frame = 0; Frame < BENCH_RECT_FRAMES; Frame += 1 ) {
+    D_BeginDraw2D( &Draw );
+    for( u32 i = 0; i < MinVec2D_Size; i += 1 ) {
+      rect_2d Rect = NewRect2D( (f32)(i & 1023), (f32)(i >> 10), 10, 10 );
+      D_DrawRect2D( &Draw, Rect, 2, 1, Color );
+    }
+    D_EndDraw2D( &Draw );
+    Result.Items += Draw.Current2DBuffer.len;
+  }
+
+  Result.TlbMisses = BenchCounterStop( CounterFd );
+  std::chrono::time_point t1 = std::chrono::high_resolution_clock::now();
+  Result.Seconds = std::chrono::duration<F64>( t1 - t0 ).count();
+
+  ArenaRelease( Arena );
+
+  return Result;
+}
+
+fn_internal void
+BenchPrint( const char* Stream, u32 Asked, bench_result Result, const char* Unit ) {
+  char Mode[32];
+  snprintf( Mode, sizeof(Mode), "%s", BenchFlagsName( Asked ) );
+  if( Result.Flags != Asked ) {
+    snprintf( Mode, sizeof(Mode), "%s->%s", BenchFlagsName( Asked ), BenchFlagsName( Result.Flags ) );
+  }
+
+  if( Result.HaveCounters ) {
+    printf( "%-6s %-12s %10.4lf s %12.2lf M%s/s %14llu dTLB misses\n", Stream, Mode, Result.Seconds,
+            (F64)Result.Items / Result.Seconds / 1e6, Unit, (unsigned long long)Result.TlbMisses );
+  } else {
+    printf( "%-6s %-12s %10.4lf s %12.2lf M%s/s %14s dTLB misses\n", Stream, Mode, Result.Seconds,
+            (F64)Result.Items / Result.Seconds / 1e6, Unit, "n/a" );
+  }
+}
+
+int main( void ) {
+  u32 Modes[] = { 0, ARENA_FLAG_HUGE_HINT, ARENA_FLAG_HUGE_EXPLICIT };
+
+  i32 CounterFd = BenchCounterOpen();
+  if( CounterFd < 0 ) {
+    printf( "[WARNING] perf_event_open not available, TLB misses won't be reported\n" );
+  }
+
+  for( u32 i = 0; i < ArrayCount( Modes ); i += 1 ) {
+    bench_result Result = BenchCsvStream( Modes[i], CounterFd );
+    Result.HaveCounters = CounterFd >= 0;
+    BenchPrint( "csv", Modes[i], Result, "B" );
+  }
+
+  for( u32 i = 0; i < ArrayCount( Modes ); i += 1 ) {
+    bench_result Result = BenchRectStream( Modes[i], CounterFd );
+    Result.HaveCounters = CounterFd >= 0;
+    BenchPrint( "rect", Modes[i], Result, "rect" );
+  }
+
+#ifdef __linux__
+  if( CounterFd >= 0 ) {
+    close( CounterFd );
+  }
+#endif
+
+  return 0;
+}
@@ -41,7 +41,10 @@
 #include "../types.h"
 #include "../memory.h"
 #include "../allocator.h"
+#include "../alloc_trace.h"
 #include "../strings.h"
+#include "../gap_buffer.h"
+#include "../string_intern.h"
 #include "../vector.h"
 #include "../queue.h"
 #include "../files.h"
@@ -69,9 +72,18 @@
 #define ALLOCATOR_IMPL
 #include "../allocator.h"
 
+#define ALLOC_TRACE_IMPL
+#include "../alloc_trace.h"
+
 #define STRINGS_IMPL
 #include "../strings.h"
 
+#define GAP_BUFFER_IMPL
+#include "../gap_buffer.h"
+
+#define STRING_INTERN_IMPL
+#include "../string_intern.h"
+
 #define VECTOR_IMPL
 #include "../vector.h"
 
@@ -117,10 +129,14 @@
 global bool AppRunning = true;
 
 int main(void) {
+  AllocTraceBegin("./objload.trace");
+
   std::chrono::time_point LastFrame = std::chrono::high_resolution_clock::now();
 
   Arena *Arena = ArenaAllocDefault();
+  AllocTraceMute();
   u8 *BackBuffer = PushArray(Arena, u8, mebibyte(256));
+  AllocTraceUnmute();
   Stack_Allocator Allocator;
   stack_init(&Allocator, (void*)BackBuffer, mebibyte(256));
   
@@ -42,7 +42,11 @@
 #include "../types.h"
 #include "../memory.h"
 #include "../allocator.h"
+#include "../alloc_trace.h"
 #include "../strings.h"
+#include "../fmt_fast.h"
+#include "../gap_buffer.h"
+#include "../string_intern.h"
 #include "../vector.h"
 #include "../queue.h"
 #include "../files.h"
@@ -68,9 +72,21 @@
 #define ALLOCATOR_IMPL
 #include "../allocator.h"
 
+#define ALLOC_TRACE_IMPL
+#include "../alloc_trace.h"
+
 #define STRINGS_IMPL
 #include "../strings.h"
 
+#define FMT_FAST_IMPL
+#include "../fmt_fast.h"
+
+#define GAP_BUFFER_IMPL
+#include "../gap_buffer.h"
+
+#define STRING_INTERN_IMPL
+#include "../string_intern.h"
+
 #define VECTOR_IMPL
 #include "../vector.h"
 
@@ -109,6 +125,10 @@
 
 #include "../render.c"
 
+// Longest directory entry name, its trailing '/' and the terminator
+//
+#define FILE_NAME_SIZE 258
+
 typedef struct line_vert line_vert;
 struct line_vert {
 	rect_2d Rect;
@@ -155,6 +175,8 @@ struct todo_render {
 
   Stack_Allocator Allocator;
   Stack_Allocator TempAllocator;
+  Pool_Allocator  FileNodePool;
+  Pool_Allocator  FileNamePool;
 
   Arena *main_arena;
   Temp   arena_temp;
@@ -182,7 +204,8 @@ struct todo_list {
 fn_internal r_vertex_input_description Vertex2DInputDescription(Stack_Allocator* Allocator);
 fn_internal r_vertex_input_description Line2DInputDescription(Stack_Allocator* Allocator);
 
-fn_internal U8_String_List* ListFilesFromDir(U8_String* Path, Stack_Allocator* Allocator);
+fn_internal U8_String_List* ListFilesFromDir(U8_String* Path, Pool_Allocator* NodePool, Pool_Allocator* NamePool);
+fn_internal void FreeFileList(U8_String_List* List, Pool_Allocator* NodePool, Pool_Allocator* NamePool);
 fn_internal U8_String_List* RecursiveSearch(U8_String* Path, Stack_Allocator* Allocator);
 
 fn_internal r_vertex_input_description
@@ -215,11 +238,12 @@ Line2DInputDescription(Stack_Allocator* Allocator)
 fn_internal void TodoRenderInit(todo_render* Render);
 
 int main( void ) {
+	AllocTraceBegin("./todolist.trace");
 	todo_render TodoApp;
 	TodoRenderInit(&TodoApp);
 
   U8_String Dir = StringNew((const char*)"./code", CustomStrlen("./code"), &TodoApp.TempAllocator);
-	U8_String_List *Files = ListFilesFromDir(&Dir, &TodoApp.Allocator);
+	U8_String_List *Files = ListFilesFromDir(&Dir, &TodoApp.FileNodePool, &TodoApp.FileNamePool);
 
 	rgba HardDark    = HexToRGBA(0x050505FF);
 	rgba Dark        = HexToRGBA(0x121212FF);
@@ -350,11 +374,16 @@ int main( void ) {
 
 	    UI_PushNextLayoutBoxSize(TodoApp.UI_Context, (vec2) {PanelRect.Size.x, TitleObj->Size.y});
 	    UI_BeginScrollbarView(TodoApp.UI_Context);
+	    Temp LabelScratch = GetScratch(NULL, 0);
+	    string_builder Labels;
+	    StringBuilderInit(&Labels, LabelScratch.arena, 0);
 	    for (i32 i = 0; i < 4000; i += 1) {
-	      char buf[64] = { 0 };
-	      snprintf(buf, 64, "Tarea Num. %d", i);
-	      UI_Label(TodoApp.UI_Context, buf);
+	      i64 Start = StringBuilderLength(&Labels);
+	      StringBuilderAppendN(&Labels, "Tarea Num. ", 11);
+	      StringBuilderAppendI64(&Labels, i);
+	      UI_LabelWithId(TodoApp.UI_Context, (u64)i, (const char*)StringBuilderView(&Labels, Start).data);
 	    }
+	    ReleaseScratch(LabelScratch);
 	    UI_EndScrollbarView(TodoApp.UI_Context);
 
 	    StackPop(&TodoApp.UI_Context->Layouts);
@@ -382,14 +411,23 @@ int main( void ) {
       UI_Button(TodoApp.UI_Context, "Set Recursive");
       local_persist U8_String_List* Files = NULL;
 	    if(UI_TextBox(TodoApp.UI_Context, (const char*)"Path") & Input_Return) {
-        Files = ListFilesFromDir(UI_GetTextFromBox(TodoApp.UI_Context, "Path"), &TodoApp.Allocator);
+        FreeFileList(Files, &TodoApp.FileNodePool, &TodoApp.FileNamePool);
+        U8_String Path = UI_GetTextFromBox(TodoApp.UI_Context, "Path");
+        Files = ListFilesFromDir(&Path, &TodoApp.FileNodePool, &TodoApp.FileNamePool);
 	    }
 	    if( Files ) {
 	     UI_BeginScrollbarView(TodoApp.UI_Context);
+       // Rows are keyed by position, a file called like another widget of
+       // the panel (or listed twice) still gets its own object and the name
+       // is never hashed
+       //
+       UI_PushIdString(TodoApp.UI_Context, "Files");
+       u64 Row = 0;
 	     for( U8_String_List* it = Files->Next; it != Files; it = it->Next ) {
-         UI_Label(TodoApp.UI_Context, (const char*)it->val.data);
+         UI_LabelWithId(TodoApp.UI_Context, Row++, (const char*)it->val.data);
          UI_Spacer(TodoApp.UI_Context, Vec2New(0, 10));
 	     }
+       UI_PopId(TodoApp.UI_Context);
 	     UI_EndScrollbarView(TodoApp.UI_Context);
 	    }
 	  }
@@ -432,10 +470,17 @@ int main( void ) {
 	      rect_2d TextRect = {};
 	      TextRect.Pos = Object->Pos;
 	      TextRect.Size = Object->Size;
-	      D_DrawText2D(&TodoApp.DrawInstance, TextRect, &Object->Text, Object->Theme.Font, Object->Theme.Foreground);
+	      i64 End = Object->Type == UI_InputText ? UI_GetTextVisibleEnd(Object) : UI_GetTextLength(Object);
+
+	      U8_String Spans[2];
+	      u32 SpanCount = UI_GetTextSpans(Object, Max(0, Object->TextStartIdx), End, Spans);
+	      for( u32 i = 0; i < SpanCount; i += 1 ) {
+	        D_DrawText2D(&TodoApp.DrawInstance, TextRect, &Spans[i], Object->Theme.Font, Object->Theme.Foreground);
+	        TextRect.Pos.x += F_TextWidth(Object->Theme.Font, (const char*)Spans[i].data, (int)Spans[i].idx);
+	      }
 
         if( Object->TextCursorIdx >= 0 && Object->TextStartIdx >= 0 && Object->Type == UI_InputText) {
-          float Start = Object->Pos.x + F_TextWidth(Object->Theme.Font, "H", 1) * (Object->TextCursorIdx - Object->TextStartIdx);
+          float Start = Object->Pos.x + UI_GetTextWidth(Object, Object->TextStartIdx, Object->TextCursorIdx);
 					float CursorSize = F_TextWidth(Object->Theme.Font, "H", 1);
 					D_DrawRect2D(
 						&TodoApp.DrawInstance,
@@ -454,9 +499,13 @@ int main( void ) {
 	  }
 
 	  {
-	    char buf[126];
-	    snprintf(buf, 126, "Render (ms): %.8lf", duration);
-	    U8_String Text = StringNew(buf, 126, &TodoApp.TempAllocator);
+	    Temp StatsScratch = GetScratch(NULL, 0);
+	    string_builder Stats;
+	    StringBuilderInit(&Stats, StatsScratch.arena, kibibyte(1));
+
+	    StringBuilderAppendN(&Stats, "Render (ms): ", 13);
+	    StringBuilderAppendF64Fixed(&Stats, duration, 8);
+	    U8_String Text = StringBuilderView(&Stats, 0);
 	    D_DrawText2D(&TodoApp.DrawInstance, NewRect2D(20, 20, 200, 40), &Text, TodoApp.UI_Context->DefaultTheme.Window.Font, Vec4New(0.8, 0.6, 0.55, 1.0f));
 	    #ifdef SDL_USAGE
       const char* StringOs = "Window manager: SDL";
@@ -467,6 +516,20 @@ int main( void ) {
       #endif
       U8_String TextOs = StringNew(StringOs, CustomStrlen(StringOs), &TodoApp.TempAllocator);
       D_DrawText2D(&TodoApp.DrawInstance, NewRect2D(20, 60, 200, 40), &TextOs, TodoApp.UI_Context->DefaultTheme.Window.Font, Vec4New(0.8, 0.6, 0.55, 1.0f));
+
+      // Commit/decommit syscalls done by the scratch arenas during the last frame,
+      // should stay at 0 once the UI has warmed up
+      //
+      local_persist u64 LastScratchSyscalls = 0;
+      arena_stats ScratchStats = ScratchPoolGetStats();
+      u64 ScratchSyscalls = ScratchStats.CommitCalls + ScratchStats.DecommitCalls;
+      i64 Start = StringBuilderLength(&Stats);
+      StringBuilderAppendN(&Stats, "Arena syscalls/frame: ", 22);
+      StringBuilderAppendU64(&Stats, ScratchSyscalls - LastScratchSyscalls);
+      LastScratchSyscalls = ScratchSyscalls;
+      U8_String TextArena = StringBuilderView(&Stats, Start);
+      D_DrawText2D(&TodoApp.DrawInstance, NewRect2D(20, 100, 200, 40), &TextArena, TodoApp.UI_Context->DefaultTheme.Window.Font, Vec4New(0.8, 0.6, 0.55, 1.0f));
+      ReleaseScratch(StatsScratch);
     }
 	}
 
@@ -560,7 +623,7 @@ int main( void ) {
 				 VK_IMAGE_LAYOUT_UNDEFINED,
 				 VK_IMAGE_LAYOUT_GENERAL
 				 );
-	  R_BindTexture(&TodoApp.Render, "Compute Texture", 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+	  R_BindTexture(&TodoApp.Render, R_ID("Compute Texture"), 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
 	  R_DispatchCompute(&TodoApp.Render, TodoApp.ComputePipeline, ceilf(window_width / 32), ceilf(window_height / 32), 1);
 	  R_SendImageToSwapchain(&TodoApp.Render, TodoApp.ComputeImageHandle);
 	}
@@ -578,8 +641,8 @@ int main( void ) {
 
 	R_BeginRenderPass(&TodoApp.Render);
 	{
-	  R_BindTexture(&TodoApp.Render, "Fonts Atlas", 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	  R_UpdateUniformBuffer(&TodoApp.Render, "Uniform Buffer", 1, &TodoApp.UniformData, sizeof(ui_uniform));
+	  R_BindTexture(&TodoApp.Render, R_ID("Fonts Atlas"), 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+	  R_UpdateUniformBuffer(&TodoApp.Render, R_ID("Uniform Buffer"), 1, &TodoApp.UniformData, sizeof(ui_uniform));
 	  //R_BindTexture(&TodoApp.Render, "Icons Atlas", 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 	  R_BindVertexBuffer(&TodoApp.Render, TodoApp.VBuffer[TodoApp.Render.VulkanBase->CurrentFrame]);
 	  R_BindIndexBuffer(&TodoApp.Render, TodoApp.IBuffer[TodoApp.Render.VulkanBase->CurrentFrame]);
@@ -611,10 +674,16 @@ fn_internal void TodoRenderInit(todo_render* TodoRenderer) {
   TodoRenderer->VkBase = VulkanInit();
   TodoRenderer->main_arena = TodoRenderer->VkBase.Arena;
   TodoRenderer->arena_temp = TempBegin(TodoRenderer->main_arena);
+  // The stacks trace their own allocations, their buffers would count twice
+  //
+  AllocTraceMute();
   u8 *Buffer     = PushArray(TodoRenderer->main_arena, u8, gigabyte(1));
   u8 *TempBuffer = PushArray(TodoRenderer->main_arena, u8, gigabyte(1));
+  AllocTraceUnmute();
   stack_init(&TodoRenderer->Allocator, Buffer, gigabyte(1));
   stack_init(&TodoRenderer->TempAllocator, TempBuffer, gigabyte(1));
+  pool_init_type(&TodoRenderer->FileNodePool, &TodoRenderer->Allocator, U8_String_List, 256);
+  pool_init(&TodoRenderer->FileNamePool, &TodoRenderer->Allocator, FILE_NAME_SIZE, 1, 256);
 
   FontCache *DefaultFont = stack_push(&TodoRenderer->Allocator, FontCache, 1);
   FontCache *TitleFont   = stack_push(&TodoRenderer->Allocator, FontCache, 1);
@@ -783,28 +852,38 @@ fn_internal void TodoRenderInit(todo_render* TodoRenderer) {
   TodoRenderer->UI_Context->DefaultTheme = DefaultTheme;
 }
 
-fn_internal U8_String_List* ListFilesFromDir(U8_String* Path, Stack_Allocator* Allocator)
+// Every name takes one FILE_NAME_SIZE element of NamePool and goes back with
+// its node in FreeFileList. Path may be UI text, which is read only, so it is
+// copied to add the terminator
+//
+fn_internal U8_String_List* ListFilesFromDir(U8_String* Path, Pool_Allocator* NodePool, Pool_Allocator* NamePool)
 {
-  Path->data[Path->idx] = '\0';
-  U8_String_List* PathList = stack_push(Allocator, U8_String_List, 1);
+  char PathName[4096];
+  snprintf(PathName, sizeof(PathName), "%.*s", (int)Path->idx, (const char*)Path->data);
+  U8_String_List* PathList = pool_push(NodePool, U8_String_List);
   DLIST_INIT(PathList);
 
   #ifdef __linux__
   DIR *dir;
   struct dirent *ent;
 
-  if ((dir = opendir((const char*)Path->data)) != NULL)
+  if ((dir = opendir(PathName)) != NULL)
   {
       /* print all the files and directories within directory */
       while ((ent = readdir (dir)) != NULL) {
           printf("%s", ent->d_name);
-          U8_String_List* List = stack_push(Allocator, U8_String_List, 1);
-          List->val = StringNew(ent->d_name, CustomStrlen(ent->d_name) + 2, Allocator);
+          u8*  Name = (u8*)pool_alloc(NamePool);
+          u64  Len  = CustomStrlen(ent->d_name);
+          memcpy(Name, ent->d_name, Len);
           if( ent->d_type == DT_DIR ) {
-            StringAppend(&List->val, "/");
+            Name[Len++] = '/';
             printf("/");
           }
-          StringAppend(&List->val, "\0");
+          Name[Len] = 0;
+          U8_String_List* List = pool_push(NodePool, U8_String_List);
+          List->val.data = Name;
+          List->val.len  = FILE_NAME_SIZE;
+          List->val.idx  = (i64)Len;
           printf("\n");
           DLIST_INIT(List);
           DLIST_INSERT(PathList, List);
@@ -814,8 +893,9 @@ fn_internal U8_String_List* ListFilesFromDir(U8_String* Path, Stack_Allocator* A
   else
   {
   /* could not open directory */
-    fprintf(stderr, "[ERROR] Listing path: %s\n", Path->data);
+    fprintf(stderr, "[ERROR] Listing path: %s\n", PathName);
     perror ("");
+    pool_free(NodePool, PathList);
     return NULL;
   }
 
@@ -823,3 +903,19 @@ fn_internal U8_String_List* ListFilesFromDir(U8_String* Path, Stack_Allocator* A
 
   return PathList;
 }
+
+fn_internal void FreeFileList(U8_String_List* List, Pool_Allocator* NodePool, Pool_Allocator* NamePool)
+{
+  if( List == NULL ) {
+    return;
+  }
+
+  U8_String_List* it = List->Next;
+  while( it != List ) {
+    U8_String_List* Next = it->Next;
+    pool_free(NamePool, it->val.data);
+    pool_free(NodePool, it);
+    it = Next;
+  }
+  pool_free(NodePool, List);
+}
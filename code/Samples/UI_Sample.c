@@ -260,7 +260,7 @@ main( int argc, char *argv[] )
                     for( i32 i = 0; i < 100; i += 1 ) {
                         char buf[64] = {0};
                         snprintf(buf, 64, "Label number %d", i);
-                        UI_Label(UI_Context, buf);
+                        UI_LabelWithId(UI_Context, (u64)i, buf);
                     }
                 }
                 UI_EndScrollbarView(UI_Context);
@@ -288,7 +288,7 @@ main( int argc, char *argv[] )
                     for( i32 i = 0; i < 20; i += 1 ) {
                         char buf[64] = {0};
                         snprintf(buf, 64, "Label number %d", i);
-                        UI_Label(UI_Context, buf);
+                        UI_LabelWithId(UI_Context, (u64)i, buf);
                     }
                 }
                 UI_EndScrollbarView(UI_Context);
@@ -32,6 +32,8 @@
 #include "../memory.h"
 #include "../allocator.h"
 #include "../strings.h"
+#include "../gap_buffer.h"
+#include "../string_intern.h"
 #include "../vector.h"
 #include "../queue.h"
 #include "../files.h"
@@ -55,6 +57,12 @@
 #define STRINGS_IMPL
 #include "../strings.h"
 
+#define GAP_BUFFER_IMPL
+#include "../gap_buffer.h"
+
+#define STRING_INTERN_IMPL
+#include "../string_intern.h"
+
 #define VECTOR_IMPL
 #include "../vector.h"
 
@@ -0,0 +1,285 @@
+/* date = October 18th 2026 */
+/*
+Allocation traces. A program built with -DALLOC_TRACE that calls AllocTraceBegin
+writes every allocation and free done through memory.h and allocator.h to a file,
+that file can be replayed later against any allocator (see Samples/BenchAlloc.cpp).
+
+Frees are resolved while recording: arena pops and free-alls become one
+ALLOC_TRACE_FREE per allocation they release, so a trace is only a list of
+"allocation Id of Size bytes" and "Id is freed" records. Lifetime is the distance
+between both. Allocations never freed live until the end of the trace.
+
+Without ALLOC_TRACE, AllocTraceBegin and AllocTraceEnd do nothing and the
+loader is the only thing left.
+*/
+
+#ifndef ALLOC_TRACE_H
+#define ALLOC_TRACE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ALLOC_TRACE_MAGIC   0x43525441 // "ATRC"
+#define ALLOC_TRACE_VERSION 1
+
+typedef struct alloc_trace_record alloc_trace_record;
+struct alloc_trace_record {
+    U64 Id;     // allocation the record belongs to, ids are given in allocation order
+    U64 Size;   // requested bytes, 0 on frees
+    U32 Align;
+    U8  Event;  // ALLOC_TRACE_ALLOC or ALLOC_TRACE_FREE
+    U8  Source; // ALLOC_TRACE_SOURCE_*
+    U8  Pad[2];
+};
+
+typedef struct alloc_trace alloc_trace;
+struct alloc_trace {
+    alloc_trace_record* Records;
+    U64                 Count;
+    U64                 AllocCount;
+};
+
+/**
+ * @brief Starts recording to $ALLOC_TRACE_FILE, or DefaultPath when it is not
+ * set. Recording stops at AllocTraceEnd or at exit.
+ */
+fn_internal void AllocTraceBegin( const char* DefaultPath );
+
+fn_internal void AllocTraceEnd( void );
+
+/**
+ * @brief Reads a whole trace into the arena. Count is 0 when the file can't be
+ * read or is not a trace.
+ */
+fn_internal alloc_trace AllocTraceLoad( const char* Path, Arena* Arena );
+
+fn_internal const char* AllocTraceSourceName( U32 Source );
+
+#endif // ALLOC_TRACE_H
+
+#ifdef ALLOC_TRACE_IMPL
+
+#ifdef ALLOC_TRACE
+
+typedef struct alloc_trace_live alloc_trace_live;
+struct alloc_trace_live {
+    U8* Ptr;
+    U64 Size;
+    U64 Id;
+    U32 Source;
+};
+
+// The recorder sits under the allocators, so it keeps its own state on malloc.
+// Live allocations are a plain array in allocation order: arenas and stacks
+// free from the top, so lookups from the end are short. A range free walks the
+// whole array, which is fine for a run that is only done to get a trace.
+//
+typedef struct alloc_trace_recorder alloc_trace_recorder;
+struct alloc_trace_recorder {
+    FILE*             File;
+    alloc_trace_live* Live;
+    U64               LiveCount;
+    U64               LiveCapacity;
+    U64               NextId;
+    long              Lock;
+    bool              AtExit;
+};
+
+static alloc_trace_recorder AllocTraceRecorder;
+
+fn_internal void
+AllocTraceLock( void ) {
+#if defined(_MSC_VER)
+    while( _InterlockedExchange( &AllocTraceRecorder.Lock, 1 ) != 0 ) {}
+#else
+    while( __atomic_exchange_n( &AllocTraceRecorder.Lock, 1, __ATOMIC_ACQUIRE ) != 0 ) {}
+#endif
+}
+
+fn_internal void
+AllocTraceUnlock( void ) {
+#if defined(_MSC_VER)
+    _InterlockedExchange( &AllocTraceRecorder.Lock, 0 );
+#else
+    __atomic_store_n( &AllocTraceRecorder.Lock, 0, __ATOMIC_RELEASE );
+#endif
+}
+
+fn_internal void
+AllocTraceWrite( U8 Event, U32 Source, U64 Id, U64 Size, U64 Align ) {
+    alloc_trace_record Record = {};
+    Record.Id     = Id;
+    Record.Size   = Size;
+    Record.Align  = (U32)Align;
+    Record.Event  = Event;
+    Record.Source = (U8)Source;
+    fwrite( &Record, sizeof( Record ), 1, AllocTraceRecorder.File );
+}
+
+fn_internal void
+AllocTraceRecord( U32 Event, U32 Source, void* Ptr, U64 Size, U64 Align ) {
+    alloc_trace_recorder* R = &AllocTraceRecorder;
+    AllocTraceLock();
+
+    switch( Event ) {
+        case ALLOC_TRACE_ALLOC: {
+            if( R->LiveCount == R->LiveCapacity ) {
+                U64 Capacity = R->LiveCapacity ? R->LiveCapacity * 2 : 4096;
+                alloc_trace_live* Live = (alloc_trace_live*)realloc( R->Live, Capacity * sizeof( alloc_trace_live ) );
+                if( Live == NULL ) {
+                    break;
+                }
+                R->Live         = Live;
+                R->LiveCapacity = Capacity;
+            }
+            alloc_trace_live* Entry = &R->Live[R->LiveCount++];
+            Entry->Ptr    = (U8*)Ptr;
+            Entry->Size   = Size;
+            Entry->Id     = R->NextId++;
+            Entry->Source = Source;
+            AllocTraceWrite( ALLOC_TRACE_ALLOC, Source, Entry->Id, Size, Align );
+        } break;
+
+        case ALLOC_TRACE_FREE: {
+            // Frees of memory handed out before AllocTraceBegin find nothing
+            //
+            for( U64 i = R->LiveCount; i > 0; i -= 1 ) {
+                alloc_trace_live* Entry = &R->Live[i - 1];
+                if( Entry->Ptr == (U8*)Ptr && Entry->Source == Source ) {
+                    AllocTraceWrite( ALLOC_TRACE_FREE, Source, Entry->Id, 0, 0 );
+                    memmove( Entry, Entry + 1, (R->LiveCount - i) * sizeof( alloc_trace_live ) );
+                    R->LiveCount -= 1;
+                    break;
+                }
+            }
+        } break;
+
+        case ALLOC_TRACE_FREE_RANGE: {
+            U8* Begin = (U8*)Ptr;
+            U8* End   = Begin + Size;
+            U64 Kept  = 0;
+            for( U64 i = 0; i < R->LiveCount; i += 1 ) {
+                alloc_trace_live* Entry = &R->Live[i];
+                if( Entry->Ptr >= Begin && Entry->Ptr < End ) {
+                    AllocTraceWrite( ALLOC_TRACE_FREE, Entry->Source, Entry->Id, 0, 0 );
+                } else {
+                    R->Live[Kept++] = *Entry;
+                }
+            }
+            R->LiveCount = Kept;
+        } break;
+    }
+
+    AllocTraceUnlock();
+}
+
+fn_internal void
+AllocTraceAtExit( void ) {
+    AllocTraceEnd();
+}
+
+fn_internal void
+AllocTraceBegin( const char* DefaultPath ) {
+    alloc_trace_recorder* R = &AllocTraceRecorder;
+    if( R->File != NULL ) {
+        return;
+    }
+
+    const char* Path = getenv( "ALLOC_TRACE_FILE" );
+    if( Path == NULL || Path[0] == 0 ) {
+        Path = DefaultPath;
+    }
+
+    R->File = fopen( Path, "wb" );
+    if( R->File == NULL ) {
+        fprintf( stderr, "[ERROR] Could not open allocation trace %s\n", Path );
+        return;
+    }
+
+    U32 Header[2] = { ALLOC_TRACE_MAGIC, ALLOC_TRACE_VERSION };
+    fwrite( Header, sizeof( Header ), 1, R->File );
+
+    R->LiveCount = 0;
+    R->NextId    = 0;
+    if( !R->AtExit ) {
+        atexit( AllocTraceAtExit );
+        R->AtExit = true;
+    }
+
+    AllocTraceHook = AllocTraceRecord;
+}
+
+fn_internal void
+AllocTraceEnd( void ) {
+    alloc_trace_recorder* R = &AllocTraceRecorder;
+    if( R->File == NULL ) {
+        return;
+    }
+
+    AllocTraceLock();
+    AllocTraceHook = NULL;
+    fclose( R->File );
+    R->File = NULL;
+    free( R->Live );
+    R->Live         = NULL;
+    R->LiveCount    = 0;
+    R->LiveCapacity = 0;
+    AllocTraceUnlock();
+}
+
+#else
+
+fn_internal void AllocTraceBegin( const char* DefaultPath ) { (void)DefaultPath; }
+fn_internal void AllocTraceEnd( void ) {}
+
+#endif // ALLOC_TRACE
+
+fn_internal alloc_trace
+AllocTraceLoad( const char* Path, Arena* Arena ) {
+    alloc_trace Trace = {};
+
+    FILE* File = fopen( Path, "rb" );
+    if( File == NULL ) {
+        return Trace;
+    }
+
+    U32 Header[2] = {};
+    if( fread( Header, sizeof( Header ), 1, File ) != 1 ||
+        Header[0] != ALLOC_TRACE_MAGIC || Header[1] != ALLOC_TRACE_VERSION ) {
+        fclose( File );
+        return Trace;
+    }
+
+    fseek( File, 0, SEEK_END );
+    long Bytes = ftell( File ) - (long)sizeof( Header );
+    fseek( File, sizeof( Header ), SEEK_SET );
+
+    U64 Count     = Bytes > 0 ? (U64)Bytes / sizeof( alloc_trace_record ) : 0;
+    Trace.Records = PushArray( Arena, alloc_trace_record, Count );
+    if( Trace.Records != NULL ) {
+        Trace.Count = fread( Trace.Records, sizeof( alloc_trace_record ), Count, File );
+    }
+    fclose( File );
+
+    for( U64 i = 0; i < Trace.Count; i += 1 ) {
+        if( Trace.Records[i].Event == ALLOC_TRACE_ALLOC ) {
+            Trace.AllocCount += 1;
+        }
+    }
+
+    return Trace;
+}
+
+fn_internal const char*
+AllocTraceSourceName( U32 Source ) {
+    switch( Source ) {
+        case ALLOC_TRACE_SOURCE_ARENA: return "arena";
+        case ALLOC_TRACE_SOURCE_STACK: return "stack";
+        case ALLOC_TRACE_SOURCE_POOL:  return "pool";
+        case ALLOC_TRACE_SOURCE_BUDDY: return "buddy";
+        case ALLOC_TRACE_SOURCE_TLSF:  return "tlsf";
+        default:                       return "?";
+    }
+}
+
+#endif // ALLOC_TRACE_IMPL
@@ -26,6 +26,10 @@
 #include <stdlib.h>
 #include <assert.h>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #ifndef DEFAULT_ALIGNMENT
 #define DEFAULT_ALIGNMENT 8
 #endif
@@ -47,17 +51,54 @@ struct Allocator {
     void* data;
 };
 
+// Orders go from the smallest block (two alignments, header + payload) up to
+// the whole heap, one bit of Buddy_Allocator::free_orders per order.
+//
+#define BUDDY_MAX_ORDERS 64
+
 typedef struct Buddy_Block Buddy_Block;
 struct Buddy_Block { // Allocation header (metadata)
     size_t size;
+    u32    requested; // bytes asked for, saturated at 4 GiB, only used for stats
     bool   is_free;
 };
 
+// Free-list links, they live in the payload of free blocks so they cost nothing
+//
+typedef struct Buddy_Free_Node Buddy_Free_Node;
+struct Buddy_Free_Node {
+    Buddy_Free_Node *next;
+    Buddy_Free_Node *prev;
+};
+
+typedef struct Buddy_Stats Buddy_Stats;
+struct Buddy_Stats {
+    size_t total_size;
+    size_t used_bytes;         // bytes of the blocks handed out
+    size_t requested_bytes;    // bytes the callers asked for
+    size_t free_bytes;
+    size_t largest_free_block;
+    size_t free_blocks;
+    size_t used_blocks;
+    f32    internal_fragmentation; // 1 - requested / used, lost to power-of-two rounding
+    f32    external_fragmentation; // 1 - largest free / free, free memory we can't hand out in one piece
+};
+
 typedef struct Buddy_Allocator Buddy_Allocator;
 struct Buddy_Allocator {
     Buddy_Block *head; // same pointer as the backing memory data
     Buddy_Block *tail; // sentinel pointer representing the memory boundary
     size_t alignment;
+
+    size_t           min_block;   // size of an order 0 block
+    u32              order_count;
+    u64              free_orders; // bit k set when free_lists[k] isn't empty
+    Buddy_Free_Node *free_lists[BUDDY_MAX_ORDERS];
+
+    size_t used_bytes;
+    size_t requested_bytes;
+    size_t free_blocks;
+    size_t used_blocks;
 };
 
 bool is_power_of_two(uintptr_t x);
@@ -70,20 +111,23 @@ size_t align_forward_size(size_t ptr, size_t align);
 
 Buddy_Block *buddy_block_next(Buddy_Block *block);
 
-Buddy_Block *buddy_block_split(Buddy_Block *block, size_t size);
-
-Buddy_Block *buddy_block_find_best(Buddy_Block *head, Buddy_Block *tail, size_t size);
-
 void buddy_allocator_init(Buddy_Allocator *b, void *data, size_t size, size_t alignment);
 
 size_t buddy_block_size_required(Buddy_Allocator *b, size_t size);
 
-void buddy_block_coalescence(Buddy_Block *head, Buddy_Block *tail);
-
+/**
+ * @brief Pops the smallest free block that fits and splits it down, O(log n).
+ */
 void *buddy_allocator_alloc(Buddy_Allocator *b, size_t size);
 
+/**
+ * @brief Gives the block back and merges it with its buddy for as long as the
+ * buddy is free and whole, O(log n).
+ */
 void buddy_allocator_free(Buddy_Allocator *b, void *data);
 
+Buddy_Stats buddy_allocator_stats(Buddy_Allocator *b);
+
 
 typedef struct Stack_Allocator Stack_Allocator;
 struct Stack_Allocator {
@@ -114,10 +158,185 @@ void* stack_resize(Stack_Allocator* s, void* old_memory, i64 old_size, i64 size,
 
 void* stack_resize_non_zeroed(Stack_Allocator* s, void* old_memory, i64 old_size, i64 size, i64 alignment);
 
-void* *stack_allocator_proc(void* data, Allocator_Mode mode, i64 size, i64 alignment, void* old_memory, i64 old_size);
+void* stack_allocator_proc(void* data, Allocator_Mode mode, i64 size, i64 alignment, void* old_memory, i64 old_size);
 
 #define stack_push(s, type, size) (type*)stack_alloc(s, sizeof(type) * size, DEFAULT_ALIGNMENT)
 
+// Fixed-size pool: free list over chunks of chunk_count elements, taken from a
+// Stack_Allocator or an Arena as the pool grows. Chunks are never given back,
+// freed elements are recycled by the next pool_alloc.
+//
+// Defined in memory.h, which may come after us (<string.h> pulls strings.h in)
+//
+typedef struct Arena Arena;
+
+typedef struct Pool_Free_Node Pool_Free_Node;
+struct Pool_Free_Node {
+    Pool_Free_Node* next;
+};
+
+typedef struct Pool_Chunk Pool_Chunk;
+struct Pool_Chunk {
+    Pool_Chunk* next;
+    u8*         elements;
+    i64         count;
+};
+
+typedef struct Pool_Allocator Pool_Allocator;
+struct Pool_Allocator {
+    Pool_Free_Node*  free_list;
+    Pool_Chunk*      chunks;
+
+    Stack_Allocator* stack; // chunk source, only one of them is set
+    Arena*           arena;
+
+    i64 elem_size;
+    i64 alignment;
+    i64 stride;             // elem_size padded to the alignment and a free node
+    i64 chunk_count;
+
+    i64 used;
+    i64 capacity;
+
+    long lock;              // only taken by the *_cached calls
+};
+
+void  pool_init(Pool_Allocator* p, Stack_Allocator* s, i64 elem_size, i64 alignment, i64 chunk_count);
+
+void  pool_init_arena(Pool_Allocator* p, Arena* a, i64 elem_size, i64 alignment, i64 chunk_count);
+
+/**
+ * @brief Pops a zeroed element from the free list, grows by a chunk when empty. O(1).
+ */
+void* pool_alloc(Pool_Allocator* p);
+
+void  pool_free(Pool_Allocator* p, void* ptr);
+
+/**
+ * @brief Puts every element back in the free list. Don't use it on a pool other
+ * threads are caching from.
+ */
+void  pool_free_all(Pool_Allocator* p);
+
+// Thread safe versions. Each thread keeps a small cache of free elements per
+// pool and only takes the pool lock to move POOL_THREAD_CACHE_BATCH elements at
+// a time. A pool used through these must not be used through pool_alloc/pool_free.
+//
+#ifndef POOL_THREAD_CACHE_SLOTS
+#define POOL_THREAD_CACHE_SLOTS 8
+#endif
+#ifndef POOL_THREAD_CACHE_BATCH
+#define POOL_THREAD_CACHE_BATCH 32
+#endif
+
+void* pool_alloc_cached(Pool_Allocator* p);
+
+void  pool_free_cached(Pool_Allocator* p, void* ptr);
+
+/**
+ * @brief Returns the calling thread's cached elements to the pool, call it
+ * before a thread that used the pool exits.
+ */
+void  pool_flush_thread_cache(Pool_Allocator* p);
+
+#define pool_init_type(p, s, type, chunk_count) pool_init(p, s, sizeof(type), _Alignof(type), chunk_count)
+#define pool_push(p, type) (type*)pool_alloc(p)
+
+/**
+ * Two-Level Segregated Fit allocator (Masmano et al.). Free blocks are kept in
+ * TLSF_FL_COUNT x TLSF_SL_COUNT size classes with a bitmap per level, so
+ * alloc, free and resize find their block with two bit scans and never walk a
+ * list: O(1) and bounded. Pools come from an Arena, a new one is pushed only
+ * when no class can serve a request, which is the one unbounded step.
+ */
+#define TLSF_SL_LOG2     5
+#define TLSF_SL_COUNT    (1 << TLSF_SL_LOG2)
+#define TLSF_ALIGN_LOG2  3
+#define TLSF_ALIGN       (1 << TLSF_ALIGN_LOG2)
+#define TLSF_FL_MAX      32
+#define TLSF_FL_SHIFT    (TLSF_SL_LOG2 + TLSF_ALIGN_LOG2)
+#define TLSF_FL_COUNT    (TLSF_FL_MAX - TLSF_FL_SHIFT + 1)
+#define TLSF_SMALL_BLOCK ((size_t)1 << TLSF_FL_SHIFT)
+
+#ifndef TLSF_POOL_SIZE
+#define TLSF_POOL_SIZE   ((i64)64 << 20)
+#endif
+
+// prev_phys lives in the last word of the previous block and is only valid
+// while that block is free. next_free/prev_free overlap the payload of used
+// blocks, so the real per-block overhead is the size word.
+//
+typedef struct Tlsf_Block Tlsf_Block;
+struct Tlsf_Block {
+    Tlsf_Block* prev_phys;
+    size_t      size;      // payload bytes, bit 0 free, bit 1 previous block free
+    Tlsf_Block* next_free;
+    Tlsf_Block* prev_free;
+};
+
+typedef struct Tlsf_Pool Tlsf_Pool;
+struct Tlsf_Pool {
+    Tlsf_Pool* next;
+    size_t     size;
+};
+
+typedef struct Tlsf_Allocator Tlsf_Allocator;
+struct Tlsf_Allocator {
+    Tlsf_Block  block_null;  // every empty free list points here
+    u32         fl_bitmap;
+    u32         sl_bitmap[TLSF_FL_COUNT];
+    Tlsf_Block* blocks[TLSF_FL_COUNT][TLSF_SL_COUNT];
+
+    Arena*      arena;       // where new pools come from, NULL for a fixed heap
+    i64         pool_size;
+    Tlsf_Pool*  pools;
+};
+
+/**
+ * @brief Sets up an empty allocator that pushes pools of pool_size bytes from
+ * arena on demand. arena can be NULL and pools given with tlsf_add_pool.
+ */
+void  tlsf_init(Tlsf_Allocator* t, Arena* arena, i64 pool_size);
+
+void  tlsf_add_pool(Tlsf_Allocator* t, void* mem, i64 size);
+
+void* tlsf_alloc(Tlsf_Allocator* t, i64 size, i64 alignment);
+
+void  tlsf_free(Tlsf_Allocator* t, void* ptr);
+
+/**
+ * @brief realloc. Grows in place when the next block is free and big enough,
+ * otherwise allocates, copies and frees.
+ */
+void* tlsf_resize(Tlsf_Allocator* t, void* ptr, i64 size, i64 alignment);
+
+/** @brief Usable bytes of an allocation, at least what was asked for. */
+i64   tlsf_block_size(void* ptr);
+
+/** @brief Frees everything, every pool becomes a single free block again. */
+void  tlsf_free_all(Tlsf_Allocator* t);
+
+void* tlsf_allocator_proc(void* data, Allocator_Mode mode, i64 size, i64 alignment, void* old_memory, i64 old_size);
+
+// Allocator_Proc adapters, so a container that takes an Allocator can run on
+// any of them. Free on an Arena is a no-op, Free_All clears it.
+//
+void* arena_allocator_proc(void* data, Allocator_Mode mode, i64 size, i64 alignment, void* old_memory, i64 old_size);
+
+void* buddy_allocator_proc(void* data, Allocator_Mode mode, i64 size, i64 alignment, void* old_memory, i64 old_size);
+
+Allocator tlsf_allocator(Tlsf_Allocator* t);
+Allocator arena_allocator(Arena* a);
+Allocator stack_allocator(Stack_Allocator* s);
+Allocator buddy_allocator(Buddy_Allocator* b);
+
+void* allocator_alloc(Allocator* a, i64 size, i64 alignment);
+void* allocator_resize(Allocator* a, void* old_memory, i64 old_size, i64 size, i64 alignment);
+void  allocator_free(Allocator* a, void* ptr);
+void  allocator_free_all(Allocator* a);
+
+#define allocator_push(a, type, count) (type*)allocator_alloc(a, sizeof(type) * (count), _Alignof(type))
+
 
 #endif // _ALLOCATOR_H_
 
@@ -178,91 +397,59 @@ Buddy_Block *buddy_block_next(Buddy_Block *block) {
     return (Buddy_Block *)((char *)block + block->size);
 }
 
-Buddy_Block *buddy_block_split(Buddy_Block *block, size_t size) {
-    if (block != NULL && size != 0) {
-        // Recursive split
-        while (size < block->size) {
-            size_t sz = block->size >> 1;
-            block->size = sz;
-            block = buddy_block_next(block);
-            block->size = sz;
-            block->is_free = true;
-        }
-
-        if (size <= block->size) {
-            return block;
-        }
-    }
+// Both sizes are powers of two, so the order is the distance between their bits
+//
+u32 buddy_order_of(Buddy_Allocator *b, size_t size) {
+    size_t blocks = size / b->min_block;
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, (unsigned long long)blocks);
+    return (u32)idx;
+#else
+    return (u32)__builtin_ctzll((unsigned long long)blocks);
+#endif
+}
 
-    // Block cannot fit the requested allocation size
-    return NULL;
+Buddy_Free_Node *buddy_free_node(Buddy_Allocator *b, Buddy_Block *block) {
+    return (Buddy_Free_Node *)((char *)block + b->alignment);
 }
 
-Buddy_Block *buddy_block_find_best(Buddy_Block *head, Buddy_Block *tail, size_t size) {
-    // Assumes size != 0
+Buddy_Block *buddy_free_node_block(Buddy_Allocator *b, Buddy_Free_Node *node) {
+    return (Buddy_Block *)((char *)node - b->alignment);
+}
 
-    Buddy_Block *best_block = NULL;
-    Buddy_Block *block = head;                    // Left Buddy
-    Buddy_Block *buddy = buddy_block_next(block); // Right Buddy
+void buddy_free_list_push(Buddy_Allocator *b, Buddy_Block *block) {
+    u32 order = buddy_order_of(b, block->size);
+    Buddy_Free_Node *node = buddy_free_node(b, block);
 
-    // The entire memory section between head and tail is free,
-    // just call 'buddy_block_split' to get the allocation
-    if (buddy == tail && block->is_free) {
-        return buddy_block_split(block, size);
+    block->is_free = true;
+    node->prev = NULL;
+    node->next = b->free_lists[order];
+    if (node->next != NULL) {
+        node->next->prev = node;
     }
+    b->free_lists[order] = node;
+    b->free_orders |= (u64)1 << order;
+    b->free_blocks += 1;
+}
 
-    // Find the block which is the 'best_block' to requested allocation sized
-    while (block < tail && buddy < tail) { // make sure the buddies are within the range
-        // If both buddies are free, coalesce them together
-        // NOTE: this is an optimization to reduce fragmentation
-        //       this could be completely ignored
-        if (block->is_free && buddy->is_free && block->size == buddy->size) {
-            block->size <<= 1;
-            if (size <= block->size && (best_block == NULL || block->size <= best_block->size)) {
-                best_block = block;
-            }
-
-            block = buddy_block_next(buddy);
-            if (block < tail) {
-                // Delay the buddy block for the next iteration
-                buddy = buddy_block_next(block);
-            }
-            continue;
-        }
-
-
-        if (block->is_free && size <= block->size &&
-            (best_block == NULL || block->size <= best_block->size)) {
-            best_block = block;
-        }
+void buddy_free_list_remove(Buddy_Allocator *b, Buddy_Block *block) {
+    u32 order = buddy_order_of(b, block->size);
+    Buddy_Free_Node *node = buddy_free_node(b, block);
 
-        if (buddy->is_free && size <= buddy->size &&
-            (best_block == NULL || buddy->size < best_block->size)) {
-            // If each buddy are the same size, then it makes more sense
-            // to pick the buddy as it "bounces around" less
-            best_block = buddy;
-        }
-
-        if (block->size <= buddy->size) {
-            block = buddy_block_next(buddy);
-            if (block < tail) {
-                // Delay the buddy block for the next iteration
-                buddy = buddy_block_next(block);
-            }
-        } else {
-            // Buddy was split into smaller blocks
-            block = buddy;
-            buddy = buddy_block_next(buddy);
-        }
+    if (node->prev != NULL) {
+        node->prev->next = node->next;
+    } else {
+        b->free_lists[order] = node->next;
     }
-
-    if (best_block != NULL) {
-        // This will handle the case if the 'best_block' is also the perfect fit
-        return buddy_block_split(best_block, size);
+    if (node->next != NULL) {
+        node->next->prev = node->prev;
     }
-
-    // Maybe out of memory
-    return NULL;
+    if (b->free_lists[order] == NULL) {
+        b->free_orders &= ~((u64)1 << order);
+    }
+    block->is_free = false;
+    b->free_blocks -= 1;
 }
 
 void buddy_allocator_init(Buddy_Allocator *b, void *data, size_t size, size_t alignment) {
@@ -270,25 +457,34 @@ void buddy_allocator_init(Buddy_Allocator *b, void *data, size_t size, size_t al
     assert(is_power_of_two(size) && "size is not a power-of-two");
     assert(is_power_of_two(alignment) && "alignment is not a power-of-two");
 
-    // The minimum alignment depends on the size of the `Buddy_Block` header
+    // The minimum alignment depends on the size of the `Buddy_Block` header,
+    // and a free block needs room for its free-list links after it
     assert(is_power_of_two(sizeof(Buddy_Block)));
+    assert(sizeof(Buddy_Free_Node) <= sizeof(Buddy_Block));
     if (alignment < sizeof(Buddy_Block)) {
         alignment = sizeof(Buddy_Block);
     }
     assert(((uintptr_t)data % alignment == 0) && "data is not aligned to minimum alignment");
 
-    b->head          = (Buddy_Block *)data;
-    b->head->size    = size;
-    b->head->is_free = true;
+    memset(b, 0, sizeof(Buddy_Allocator));
+    b->alignment = alignment;
+    b->min_block = alignment << 1;
+    assert(size >= b->min_block && "size is too small for a single block");
+
+    b->order_count = buddy_order_of(b, size) + 1;
+    assert(b->order_count <= BUDDY_MAX_ORDERS);
+
+    b->head       = (Buddy_Block *)data;
+    b->head->size = size;
 
     // The tail here is a sentinel value and not a true block
     b->tail = buddy_block_next(b->head);
 
-    b->alignment = alignment;
+    buddy_free_list_push(b, b->head);
 }
 
 size_t buddy_block_size_required(Buddy_Allocator *b, size_t size) {
-    size_t actual_size = b->alignment;
+    size_t actual_size = b->min_block;
 
     size += sizeof(Buddy_Block);
     size = align_forward_size(size, b->alignment);
@@ -300,77 +496,121 @@ size_t buddy_block_size_required(Buddy_Allocator *b, size_t size) {
     return actual_size;
 }
 
-void buddy_block_coalescence(Buddy_Block *head, Buddy_Block *tail) {
-    for (;;) {
-        // Keep looping until there are no more buddies to coalesce
-
-        Buddy_Block *block = head;
-        Buddy_Block *buddy = buddy_block_next(block);
-
-        bool no_coalescence = true;
-        while (block < tail && buddy < tail) { // make sure the buddies are within the range
-            if (block->is_free && buddy->is_free && block->size == buddy->size) {
-                // Coalesce buddies into one
-                block->size <<= 1;
-                block = buddy_block_next(block);
-                if (block < tail) {
-                    buddy = buddy_block_next(block);
-                    no_coalescence = false;
-                }
-            } else if (block->size < buddy->size) {
-                // The buddy block is split into smaller blocks
-                block = buddy;
-                buddy = buddy_block_next(buddy);
-            } else {
-                block = buddy_block_next(buddy);
-                if (block < tail) {
-                    // Leave the buddy block for the next iteration
-                    buddy = buddy_block_next(block);
-                }
-            }
-        }
+void *buddy_allocator_alloc(Buddy_Allocator *b, size_t size) {
+    if (size == 0) {
+        return NULL;
+    }
 
-        if (no_coalescence) {
-            return;
-        }
+    size_t actual_size = buddy_block_size_required(b, size);
+    u32 order = buddy_order_of(b, actual_size);
+    if (order >= b->order_count) {
+        return NULL;
     }
-}
 
-void *buddy_allocator_alloc(Buddy_Allocator *b, size_t size) {
-    if (size != 0) {
-        size_t actual_size = buddy_block_size_required(b, size);
-
-        Buddy_Block *found = buddy_block_find_best(b->head, b->tail, actual_size);
-        if (found == NULL) {
-            // Try to coalesce all the free buddy blocks and then search again
-            buddy_block_coalescence(b->head, b->tail);
-            found = buddy_block_find_best(b->head, b->tail, actual_size);
-        }
+    // Smallest non empty order that fits, straight from the bitmap
+    //
+    u64 candidates = b->free_orders & ~(((u64)1 << order) - 1);
+    if (candidates == 0) {
+        // Out of memory (possibly due to too much external fragmentation)
+        return NULL;
+    }
+#if defined(_MSC_VER)
+    unsigned long found_order;
+    _BitScanForward64(&found_order, candidates);
+#else
+    u32 found_order = (u32)__builtin_ctzll(candidates);
+#endif
 
-        if (found != NULL) {
-            found->is_free = false;
-            return (void *)((char *)found + b->alignment);
-        }
+    Buddy_Block *block = buddy_free_node_block(b, b->free_lists[found_order]);
+    buddy_free_list_remove(b, block);
 
-        // Out of memory (possibly due to too much fn_internal fragmentation)
+    // Split down, the upper halves go back to their free lists
+    //
+    while (block->size > actual_size) {
+        size_t half = block->size >> 1;
+        block->size = half;
+        Buddy_Block *buddy = buddy_block_next(block);
+        buddy->size = half;
+        buddy_free_list_push(b, buddy);
     }
 
-    return NULL;
+    block->is_free   = false;
+    block->requested = size > 0xFFFFFFFF ? 0xFFFFFFFF : (u32)size;
+    b->used_bytes      += block->size;
+    b->requested_bytes += block->requested;
+    b->used_blocks     += 1;
+
+    AllocTraceEmit(ALLOC_TRACE_ALLOC, ALLOC_TRACE_SOURCE_BUDDY, (char *)block + b->alignment, size, b->alignment);
+    return (void *)((char *)block + b->alignment);
 }
 
 void buddy_allocator_free(Buddy_Allocator *b, void *data) {
-    if (data != NULL) {
-        Buddy_Block *block;
+    if (data == NULL) {
+        return;
+    }
+
+    Buddy_Block *block;
+
+    assert((uintptr_t)b->head <= (uintptr_t)data);
+    assert((uintptr_t)data < (uintptr_t)b->tail);
 
-        assert((uintptr_t)b->head <= (uintptr_t)data);
-        assert((uintptr_t)data < (uintptr_t)b->tail);
+    block = (Buddy_Block *)((char *)data - b->alignment);
+    assert(!block->is_free && "double free");
+    AllocTraceEmit(ALLOC_TRACE_FREE, ALLOC_TRACE_SOURCE_BUDDY, data, 0, 0);
 
-        block = (Buddy_Block *)((char *)data - b->alignment);
-        block->is_free = true;
+    b->used_bytes      -= block->size;
+    b->requested_bytes -= block->requested;
+    b->used_blocks     -= 1;
 
-        // NOTE: Coalescence could be done now but it is optional
-        // buddy_block_coalescence(b->head, b->tail);
+    // The buddy sits at our offset with the size bit flipped. Its header is
+    // always a live block header, if it was split it reports a smaller size.
+    //
+    size_t total = (size_t)((char *)b->tail - (char *)b->head);
+    while (block->size < total) {
+        size_t offset = (size_t)((char *)block - (char *)b->head);
+        Buddy_Block *buddy = (Buddy_Block *)((char *)b->head + (offset ^ block->size));
+        if (!buddy->is_free || buddy->size != block->size) {
+            break;
+        }
+        buddy_free_list_remove(b, buddy);
+        if (buddy < block) {
+            buddy->size = block->size;
+            block = buddy;
+        }
+        block->size <<= 1;
     }
+
+    buddy_free_list_push(b, block);
+}
+
+Buddy_Stats buddy_allocator_stats(Buddy_Allocator *b) {
+    Buddy_Stats stats = {0};
+
+    stats.total_size      = (size_t)((char *)b->tail - (char *)b->head);
+    stats.used_bytes      = b->used_bytes;
+    stats.requested_bytes = b->requested_bytes;
+    stats.free_bytes      = stats.total_size - b->used_bytes;
+    stats.free_blocks     = b->free_blocks;
+    stats.used_blocks     = b->used_blocks;
+
+    if (b->free_orders != 0) {
+#if defined(_MSC_VER)
+        unsigned long top;
+        _BitScanReverse64(&top, b->free_orders);
+#else
+        u32 top = 63 - (u32)__builtin_clzll(b->free_orders);
+#endif
+        stats.largest_free_block = b->min_block << top;
+    }
+
+    if (stats.used_bytes > 0) {
+        stats.internal_fragmentation = 1.0f - (f32)stats.requested_bytes / (f32)stats.used_bytes;
+    }
+    if (stats.free_bytes > 0) {
+        stats.external_fragmentation = 1.0f - (f32)stats.largest_free_block / (f32)stats.free_bytes;
+    }
+
+    return stats;
 }
 
 void
@@ -444,6 +684,7 @@ stack_alloc_non_zeroed(Stack_Allocator* s, i64 size, i64 alignment) {
     s->peak_used = Max(s->peak_used, s->curr_offset);
 
     memset(next_addr, 0, size);
+    AllocTraceEmit(ALLOC_TRACE_ALLOC, ALLOC_TRACE_SOURCE_STACK, next_addr, size, alignment);
     return next_addr;
 }
 
@@ -474,12 +715,14 @@ stack_free(Stack_Allocator* s, void* old_memory) {
 
     s->prev_offset = header->prev_offset;
     s->curr_offset = old_offset;
+    AllocTraceEmit(ALLOC_TRACE_FREE, ALLOC_TRACE_SOURCE_STACK, old_memory, 0, 0);
 
     return NULL;
 }
 
 void
 stack_free_all(Stack_Allocator* s) {
+    AllocTraceEmit(ALLOC_TRACE_FREE_RANGE, ALLOC_TRACE_SOURCE_STACK, s->data, s->curr_offset, 0);
     s->prev_offset = 0;
     s->curr_offset = 0;
 }
@@ -519,6 +762,8 @@ stack_resize_non_zeroed(Stack_Allocator* s, void* old_memory, i64 old_size, i64
         }
     }
     if( old_size == size ) {
+        AllocTraceEmit(ALLOC_TRACE_FREE, ALLOC_TRACE_SOURCE_STACK, old_memory, 0, 0);
+        AllocTraceEmit(ALLOC_TRACE_ALLOC, ALLOC_TRACE_SOURCE_STACK, old_memory, size, alignment);
         return memset(old_memory, 0, size);
     }
 
@@ -539,7 +784,855 @@ stack_resize_non_zeroed(Stack_Allocator* s, void* old_memory, i64 old_size, i64
         memset((u8*)curr_addr + diff, 0, diff);
     }
 
+    AllocTraceEmit(ALLOC_TRACE_FREE, ALLOC_TRACE_SOURCE_STACK, old_memory, 0, 0);
+    AllocTraceEmit(ALLOC_TRACE_ALLOC, ALLOC_TRACE_SOURCE_STACK, old_memory, size, alignment);
     return memset(old_memory, 0, size);
 }
 
+typedef struct Pool_Thread_Cache Pool_Thread_Cache;
+struct Pool_Thread_Cache {
+    Pool_Allocator* pool;
+    Pool_Free_Node* free_list;
+    i64             count;
+};
+
+thread_static Pool_Thread_Cache PoolThreadCaches[POOL_THREAD_CACHE_SLOTS];
+
+void
+pool_lock(Pool_Allocator* p) {
+#if defined(_MSC_VER)
+    while( _InterlockedExchange(&p->lock, 1) != 0 ) {}
+#else
+    while( __atomic_exchange_n(&p->lock, 1, __ATOMIC_ACQUIRE) != 0 ) {}
+#endif
+}
+
+void
+pool_unlock(Pool_Allocator* p) {
+#if defined(_MSC_VER)
+    _InterlockedExchange(&p->lock, 0);
+#else
+    __atomic_store_n(&p->lock, 0, __ATOMIC_RELEASE);
+#endif
+}
+
+void
+pool_setup(Pool_Allocator* p, i64 elem_size, i64 alignment, i64 chunk_count) {
+    if( alignment < (i64)_Alignof(Pool_Free_Node) ) {
+        alignment = _Alignof(Pool_Free_Node);
+    }
+    assert(is_power_of_two((uintptr_t)alignment));
+    assert(chunk_count > 0);
+
+    i64 stride = elem_size < (i64)sizeof(Pool_Free_Node) ? (i64)sizeof(Pool_Free_Node) : elem_size;
+
+    p->free_list   = NULL;
+    p->chunks      = NULL;
+    p->elem_size   = elem_size;
+    p->alignment   = alignment;
+    p->stride      = (i64)align_forward_size((size_t)stride, (size_t)alignment);
+    p->chunk_count = chunk_count;
+    p->used        = 0;
+    p->capacity    = 0;
+    p->lock        = 0;
+}
+
+void
+pool_init(Pool_Allocator* p, Stack_Allocator* s, i64 elem_size, i64 alignment, i64 chunk_count) {
+    pool_setup(p, elem_size, alignment, chunk_count);
+    p->stack = s;
+    p->arena = NULL;
+}
+
+void
+pool_init_arena(Pool_Allocator* p, Arena* a, i64 elem_size, i64 alignment, i64 chunk_count) {
+    pool_setup(p, elem_size, alignment, chunk_count);
+    p->stack = NULL;
+    p->arena = a;
+}
+
+void
+pool_chunk_thread(Pool_Allocator* p, Pool_Chunk* chunk) {
+    // Thread it backwards so the first pool_alloc gets the first element
+    //
+    for( i64 i = chunk->count - 1; i >= 0; i -= 1 ) {
+        Pool_Free_Node* node = (Pool_Free_Node*)(chunk->elements + i * p->stride);
+        node->next   = p->free_list;
+        p->free_list = node;
+    }
+}
+
+bool
+pool_grow(Pool_Allocator* p) {
+    i64 bytes = (i64)sizeof(Pool_Chunk) + p->alignment + p->stride * p->chunk_count;
+
+    // The elements are traced one by one in pool_alloc, not the chunk
+    //
+    u8* memory = NULL;
+    AllocTraceMute();
+    if( p->stack != NULL ) {
+        memory = (u8*)stack_alloc_non_zeroed(p->stack, bytes, DEFAULT_ALIGNMENT);
+    } else if( p->arena != NULL ) {
+        memory = (u8*)ArenaPush(p->arena, (U64)bytes);
+    }
+    AllocTraceUnmute();
+    if( memory == NULL ) {
+        return false;
+    }
+
+    Pool_Chunk* chunk = (Pool_Chunk*)memory;
+    chunk->elements   = (u8*)align_forward((uintptr_t)(memory + sizeof(Pool_Chunk)), (size_t)p->alignment);
+    chunk->count      = p->chunk_count;
+    chunk->next       = p->chunks;
+    p->chunks         = chunk;
+    p->capacity      += chunk->count;
+
+    pool_chunk_thread(p, chunk);
+
+    return true;
+}
+
+void*
+pool_alloc(Pool_Allocator* p) {
+    if( p->free_list == NULL && !pool_grow(p) ) {
+        return NULL;
+    }
+
+    Pool_Free_Node* node = p->free_list;
+    p->free_list = node->next;
+    p->used     += 1;
+
+    AllocTraceEmit(ALLOC_TRACE_ALLOC, ALLOC_TRACE_SOURCE_POOL, node, p->elem_size, p->alignment);
+    return memset(node, 0, (size_t)p->elem_size);
+}
+
+void
+pool_free(Pool_Allocator* p, void* ptr) {
+    if( ptr == NULL ) {
+        return;
+    }
+
+    AllocTraceEmit(ALLOC_TRACE_FREE, ALLOC_TRACE_SOURCE_POOL, ptr, 0, 0);
+    Pool_Free_Node* node = (Pool_Free_Node*)ptr;
+    node->next   = p->free_list;
+    p->free_list = node;
+    p->used     -= 1;
+}
+
+void
+pool_free_all(Pool_Allocator* p) {
+    p->free_list = NULL;
+    for( Pool_Chunk* chunk = p->chunks; chunk != NULL; chunk = chunk->next ) {
+        AllocTraceEmit(ALLOC_TRACE_FREE_RANGE, ALLOC_TRACE_SOURCE_POOL, chunk->elements, chunk->count * p->stride, 0);
+        pool_chunk_thread(p, chunk);
+    }
+    p->used = 0;
+}
+
+Pool_Thread_Cache*
+pool_thread_cache(Pool_Allocator* p) {
+    Pool_Thread_Cache* empty = NULL;
+    for( u32 i = 0; i < POOL_THREAD_CACHE_SLOTS; i += 1 ) {
+        if( PoolThreadCaches[i].pool == p ) {
+            return &PoolThreadCaches[i];
+        }
+        if( empty == NULL && PoolThreadCaches[i].pool == NULL ) {
+            empty = &PoolThreadCaches[i];
+        }
+    }
+    if( empty != NULL ) {
+        empty->pool      = p;
+        empty->free_list = NULL;
+        empty->count     = 0;
+    }
+    return empty;
+}
+
+void*
+pool_alloc_cached(Pool_Allocator* p) {
+    Pool_Thread_Cache* cache = pool_thread_cache(p);
+
+    if( cache == NULL ) {
+        // Every slot is taken by another pool, go straight to the shared list
+        //
+        pool_lock(p);
+        void* result = pool_alloc(p);
+        pool_unlock(p);
+        return result;
+    }
+
+    if( cache->free_list == NULL ) {
+        pool_lock(p);
+        for( i64 i = 0; i < POOL_THREAD_CACHE_BATCH; i += 1 ) {
+            if( p->free_list == NULL && !pool_grow(p) ) {
+                break;
+            }
+            Pool_Free_Node* node = p->free_list;
+            p->free_list     = node->next;
+            node->next       = cache->free_list;
+            cache->free_list = node;
+            cache->count    += 1;
+        }
+        p->used += cache->count;
+        pool_unlock(p);
+
+        if( cache->free_list == NULL ) {
+            return NULL;
+        }
+    }
+
+    Pool_Free_Node* node = cache->free_list;
+    cache->free_list = node->next;
+    cache->count    -= 1;
+
+    AllocTraceEmit(ALLOC_TRACE_ALLOC, ALLOC_TRACE_SOURCE_POOL, node, p->elem_size, p->alignment);
+    return memset(node, 0, (size_t)p->elem_size);
+}
+
+void
+pool_cache_give_back(Pool_Allocator* p, Pool_Thread_Cache* cache, i64 count) {
+    pool_lock(p);
+    for( i64 i = 0; i < count && cache->free_list != NULL; i += 1 ) {
+        Pool_Free_Node* node = cache->free_list;
+        cache->free_list = node->next;
+        cache->count    -= 1;
+        node->next   = p->free_list;
+        p->free_list = node;
+        p->used     -= 1;
+    }
+    pool_unlock(p);
+}
+
+void
+pool_free_cached(Pool_Allocator* p, void* ptr) {
+    if( ptr == NULL ) {
+        return;
+    }
+
+    Pool_Thread_Cache* cache = pool_thread_cache(p);
+    if( cache == NULL ) {
+        pool_lock(p);
+        pool_free(p, ptr);
+        pool_unlock(p);
+        return;
+    }
+
+    AllocTraceEmit(ALLOC_TRACE_FREE, ALLOC_TRACE_SOURCE_POOL, ptr, 0, 0);
+    Pool_Free_Node* node = (Pool_Free_Node*)ptr;
+    node->next       = cache->free_list;
+    cache->free_list = node;
+    cache->count    += 1;
+
+    // Keep at most two batches around, the rest goes back for other threads
+    //
+    if( cache->count > 2 * POOL_THREAD_CACHE_BATCH ) {
+        pool_cache_give_back(p, cache, POOL_THREAD_CACHE_BATCH);
+    }
+}
+
+void
+pool_flush_thread_cache(Pool_Allocator* p) {
+    for( u32 i = 0; i < POOL_THREAD_CACHE_SLOTS; i += 1 ) {
+        Pool_Thread_Cache* cache = &PoolThreadCaches[i];
+        if( cache->pool == p ) {
+            pool_cache_give_back(p, cache, cache->count);
+            cache->pool = NULL;
+            return;
+        }
+    }
+}
+
+// ------------------------------------------------------------------------ //
+// TLSF
+
+#define TLSF_BLOCK_FREE      ((size_t)1)
+#define TLSF_BLOCK_PREV_FREE ((size_t)2)
+#define TLSF_BLOCK_OVERHEAD  sizeof(size_t)
+#define TLSF_BLOCK_START     (offsetof(Tlsf_Block, size) + sizeof(size_t))
+#define TLSF_BLOCK_MIN       (sizeof(Tlsf_Block) - sizeof(Tlsf_Block*))
+#define TLSF_BLOCK_MAX       ((size_t)1 << TLSF_FL_MAX)
+
+i32 tlsf_fls(size_t x) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    return _BitScanReverse64(&idx, (unsigned long long)x) ? (i32)idx : -1;
+#else
+    return x ? 63 - __builtin_clzll((unsigned long long)x) : -1;
+#endif
+}
+
+i32 tlsf_ffs(u32 x) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    return _BitScanForward(&idx, x) ? (i32)idx : -1;
+#else
+    return x ? __builtin_ctz(x) : -1;
+#endif
+}
+
+size_t      tlsf_block_get_size(Tlsf_Block* b)   { return b->size & ~(TLSF_BLOCK_FREE | TLSF_BLOCK_PREV_FREE); }
+void        tlsf_block_set_size(Tlsf_Block* b, size_t size) { b->size = size | (b->size & (TLSF_BLOCK_FREE | TLSF_BLOCK_PREV_FREE)); }
+bool        tlsf_block_is_free(Tlsf_Block* b)    { return (b->size & TLSF_BLOCK_FREE) != 0; }
+bool        tlsf_block_is_prev_free(Tlsf_Block* b) { return (b->size & TLSF_BLOCK_PREV_FREE) != 0; }
+void        tlsf_block_set_prev_free(Tlsf_Block* b) { b->size |= TLSF_BLOCK_PREV_FREE; }
+void        tlsf_block_set_prev_used(Tlsf_Block* b) { b->size &= ~TLSF_BLOCK_PREV_FREE; }
+Tlsf_Block* tlsf_block_from_ptr(void* ptr)       { return (Tlsf_Block*)((u8*)ptr - TLSF_BLOCK_START); }
+void*       tlsf_block_to_ptr(Tlsf_Block* b)     { return (u8*)b + TLSF_BLOCK_START; }
+
+Tlsf_Block* tlsf_offset_to_block(void* ptr, i64 offset) {
+    return (Tlsf_Block*)((u8*)ptr + offset);
+}
+
+Tlsf_Block* tlsf_block_next(Tlsf_Block* b) {
+    return tlsf_offset_to_block(tlsf_block_to_ptr(b), (i64)tlsf_block_get_size(b) - (i64)TLSF_BLOCK_OVERHEAD);
+}
+
+Tlsf_Block* tlsf_block_link_next(Tlsf_Block* b) {
+    Tlsf_Block* next = tlsf_block_next(b);
+    next->prev_phys = b;
+    return next;
+}
+
+void tlsf_block_mark_as_free(Tlsf_Block* b) {
+    Tlsf_Block* next = tlsf_block_link_next(b);
+    tlsf_block_set_prev_free(next);
+    b->size |= TLSF_BLOCK_FREE;
+}
+
+void tlsf_block_mark_as_used(Tlsf_Block* b) {
+    Tlsf_Block* next = tlsf_block_next(b);
+    tlsf_block_set_prev_used(next);
+    b->size &= ~TLSF_BLOCK_FREE;
+}
+
+// First level is the power of two, second level splits it linearly in
+// TLSF_SL_COUNT steps. Small sizes all go to first level 0.
+//
+void tlsf_mapping_insert(size_t size, i32* fl, i32* sl) {
+    if( size < TLSF_SMALL_BLOCK ) {
+        *fl = 0;
+        *sl = (i32)(size / (TLSF_SMALL_BLOCK / TLSF_SL_COUNT));
+    } else {
+        i32 f = tlsf_fls(size);
+        *sl = (i32)(size >> (f - TLSF_SL_LOG2)) ^ (1 << TLSF_SL_LOG2);
+        *fl = f - (TLSF_FL_SHIFT - 1);
+    }
+}
+
+// Rounds up to the next class so any block found there is big enough
+//
+void tlsf_mapping_search(size_t size, i32* fl, i32* sl) {
+    if( size >= TLSF_SMALL_BLOCK ) {
+        size_t round = ((size_t)1 << (tlsf_fls(size) - TLSF_SL_LOG2)) - 1;
+        size += round;
+    }
+    tlsf_mapping_insert(size, fl, sl);
+}
+
+Tlsf_Block* tlsf_search_suitable_block(Tlsf_Allocator* t, i32* fl, i32* sl) {
+    u32 sl_map = t->sl_bitmap[*fl] & (~0u << *sl);
+    if( !sl_map ) {
+        u32 fl_map = *fl + 1 < 32 ? t->fl_bitmap & (~0u << (*fl + 1)) : 0;
+        if( !fl_map ) {
+            return NULL;
+        }
+        *fl    = tlsf_ffs(fl_map);
+        sl_map = t->sl_bitmap[*fl];
+    }
+    *sl = tlsf_ffs(sl_map);
+    return t->blocks[*fl][*sl];
+}
+
+void tlsf_remove_free_block(Tlsf_Allocator* t, Tlsf_Block* b, i32 fl, i32 sl) {
+    Tlsf_Block* prev = b->prev_free;
+    Tlsf_Block* next = b->next_free;
+    next->prev_free = prev;
+    prev->next_free = next;
+
+    if( t->blocks[fl][sl] == b ) {
+        t->blocks[fl][sl] = next;
+        if( next == &t->block_null ) {
+            t->sl_bitmap[fl] &= ~(1u << sl);
+            if( !t->sl_bitmap[fl] ) {
+                t->fl_bitmap &= ~(1u << fl);
+            }
+        }
+    }
+}
+
+void tlsf_insert_free_block(Tlsf_Allocator* t, Tlsf_Block* b, i32 fl, i32 sl) {
+    Tlsf_Block* current = t->blocks[fl][sl];
+    b->next_free       = current;
+    b->prev_free       = &t->block_null;
+    current->prev_free = b;
+
+    t->blocks[fl][sl] = b;
+    t->fl_bitmap     |= 1u << fl;
+    t->sl_bitmap[fl] |= 1u << sl;
+}
+
+void tlsf_block_remove(Tlsf_Allocator* t, Tlsf_Block* b) {
+    i32 fl, sl;
+    tlsf_mapping_insert(tlsf_block_get_size(b), &fl, &sl);
+    tlsf_remove_free_block(t, b, fl, sl);
+}
+
+void tlsf_block_insert(Tlsf_Allocator* t, Tlsf_Block* b) {
+    i32 fl, sl;
+    tlsf_mapping_insert(tlsf_block_get_size(b), &fl, &sl);
+    tlsf_insert_free_block(t, b, fl, sl);
+}
+
+bool tlsf_block_can_split(Tlsf_Block* b, size_t size) {
+    return tlsf_block_get_size(b) >= sizeof(Tlsf_Block) + size;
+}
+
+Tlsf_Block* tlsf_block_split(Tlsf_Block* b, size_t size) {
+    Tlsf_Block* remaining = tlsf_offset_to_block(tlsf_block_to_ptr(b), (i64)size - (i64)TLSF_BLOCK_OVERHEAD);
+    size_t remain_size    = tlsf_block_get_size(b) - (size + TLSF_BLOCK_OVERHEAD);
+
+    tlsf_block_set_size(remaining, remain_size);
+    tlsf_block_set_size(b, size);
+    tlsf_block_mark_as_free(remaining);
+
+    return remaining;
+}
+
+Tlsf_Block* tlsf_block_absorb(Tlsf_Block* prev, Tlsf_Block* b) {
+    prev->size += tlsf_block_get_size(b) + TLSF_BLOCK_OVERHEAD;
+    tlsf_block_link_next(prev);
+    return prev;
+}
+
+Tlsf_Block* tlsf_block_merge_prev(Tlsf_Allocator* t, Tlsf_Block* b) {
+    if( tlsf_block_is_prev_free(b) ) {
+        Tlsf_Block* prev = b->prev_phys;
+        tlsf_block_remove(t, prev);
+        b = tlsf_block_absorb(prev, b);
+    }
+    return b;
+}
+
+Tlsf_Block* tlsf_block_merge_next(Tlsf_Allocator* t, Tlsf_Block* b) {
+    Tlsf_Block* next = tlsf_block_next(b);
+    if( tlsf_block_is_free(next) ) {
+        tlsf_block_remove(t, next);
+        b = tlsf_block_absorb(b, next);
+    }
+    return b;
+}
+
+void tlsf_block_trim_free(Tlsf_Allocator* t, Tlsf_Block* b, size_t size) {
+    if( tlsf_block_can_split(b, size) ) {
+        Tlsf_Block* remaining = tlsf_block_split(b, size);
+        tlsf_block_link_next(b);
+        tlsf_block_set_prev_free(remaining);
+        tlsf_block_insert(t, remaining);
+    }
+}
+
+void tlsf_block_trim_used(Tlsf_Allocator* t, Tlsf_Block* b, size_t size) {
+    if( tlsf_block_can_split(b, size) ) {
+        Tlsf_Block* remaining = tlsf_block_split(b, size);
+        tlsf_block_set_prev_used(remaining);
+        remaining = tlsf_block_merge_next(t, remaining);
+        tlsf_block_insert(t, remaining);
+    }
+}
+
+Tlsf_Block* tlsf_block_trim_free_leading(Tlsf_Allocator* t, Tlsf_Block* b, size_t size) {
+    Tlsf_Block* remaining = b;
+    if( tlsf_block_can_split(b, size) ) {
+        remaining = tlsf_block_split(b, size - TLSF_BLOCK_OVERHEAD);
+        tlsf_block_set_prev_free(remaining);
+        tlsf_block_link_next(b);
+        tlsf_block_insert(t, b);
+    }
+    return remaining;
+}
+
+Tlsf_Block* tlsf_block_locate_free(Tlsf_Allocator* t, size_t size) {
+    i32 fl = 0, sl = 0;
+    Tlsf_Block* b = NULL;
+
+    if( size ) {
+        tlsf_mapping_search(size, &fl, &sl);
+        if( fl < TLSF_FL_COUNT ) {
+            b = tlsf_search_suitable_block(t, &fl, &sl);
+        }
+    }
+    if( b != NULL ) {
+        tlsf_remove_free_block(t, b, fl, sl);
+    }
+    return b;
+}
+
+size_t tlsf_adjust_request_size(size_t size, size_t align) {
+    size_t adjust = 0;
+    if( size ) {
+        size_t aligned = align_forward_size(size, align);
+        if( aligned < TLSF_BLOCK_MAX ) {
+            adjust = aligned < TLSF_BLOCK_MIN ? TLSF_BLOCK_MIN : aligned;
+        }
+    }
+    return adjust;
+}
+
+void tlsf_init(Tlsf_Allocator* t, Arena* arena, i64 pool_size) {
+    memset(t, 0, sizeof(Tlsf_Allocator));
+    t->block_null.next_free = &t->block_null;
+    t->block_null.prev_free = &t->block_null;
+    for( i32 i = 0; i < TLSF_FL_COUNT; i += 1 ) {
+        for( i32 j = 0; j < TLSF_SL_COUNT; j += 1 ) {
+            t->blocks[i][j] = &t->block_null;
+        }
+    }
+    t->arena     = arena;
+    t->pool_size = pool_size > 0 ? pool_size : TLSF_POOL_SIZE;
+}
+
+// Lays out a pool as one free block followed by a zero sized used sentinel
+// that stops merges at the pool end
+//
+void tlsf_pool_reset(Tlsf_Allocator* t, Tlsf_Pool* pool) {
+    u8*    mem   = (u8*)align_forward((uintptr_t)(pool + 1), TLSF_ALIGN);
+    size_t bytes = pool->size - (size_t)(mem - (u8*)pool);
+    bytes        = (bytes - 2 * TLSF_BLOCK_OVERHEAD) & ~((size_t)TLSF_ALIGN - 1);
+
+    Tlsf_Block* b = tlsf_offset_to_block(mem, -(i64)TLSF_BLOCK_OVERHEAD);
+    b->size = bytes;
+    b->size |= TLSF_BLOCK_FREE;
+    tlsf_block_set_prev_used(b);
+    tlsf_block_insert(t, b);
+
+    Tlsf_Block* sentinel = tlsf_block_link_next(b);
+    sentinel->size = 0;
+    tlsf_block_set_prev_free(sentinel);
+}
+
+void tlsf_add_pool(Tlsf_Allocator* t, void* mem, i64 size) {
+    assert(size > (i64)(sizeof(Tlsf_Pool) + TLSF_ALIGN + 2 * TLSF_BLOCK_OVERHEAD + TLSF_BLOCK_MIN));
+
+    Tlsf_Pool* pool = (Tlsf_Pool*)align_forward((uintptr_t)mem, _Alignof(Tlsf_Pool));
+    pool->size = (size_t)size - (size_t)((u8*)pool - (u8*)mem);
+    pool->next = t->pools;
+    t->pools   = pool;
+
+    tlsf_pool_reset(t, pool);
+}
+
+bool tlsf_grow(Tlsf_Allocator* t, size_t size, size_t alignment) {
+    if( t->arena == NULL ) {
+        return false;
+    }
+
+    size_t needed = size + alignment + sizeof(Tlsf_Pool) + sizeof(Tlsf_Block) + 4 * TLSF_BLOCK_OVERHEAD;
+    // Round to a whole class above needed, tlsf_mapping_search rounds requests up
+    //
+    needed += needed >> TLSF_SL_LOG2;
+    i64 bytes = (i64)needed > t->pool_size ? (i64)needed : t->pool_size;
+
+    AllocTraceMute();
+    void* mem = ArenaPush(t->arena, (U64)bytes);
+    AllocTraceUnmute();
+    if( mem == NULL ) {
+        return false;
+    }
+    tlsf_add_pool(t, mem, bytes);
+    return true;
+}
+
+void* tlsf_alloc(Tlsf_Allocator* t, i64 size, i64 alignment) {
+    size_t align  = alignment > TLSF_ALIGN ? (size_t)alignment : TLSF_ALIGN;
+    size_t adjust = tlsf_adjust_request_size((size_t)size, TLSF_ALIGN);
+    if( adjust == 0 ) {
+        return NULL;
+    }
+
+    // Over-allocate so an aligned pointer with room for a free block in front
+    // of it always fits
+    //
+    size_t gap_minimum  = sizeof(Tlsf_Block);
+    size_t aligned_size = adjust;
+    if( align > TLSF_ALIGN ) {
+        aligned_size = tlsf_adjust_request_size(adjust + align + gap_minimum, align);
+    }
+
+    Tlsf_Block* b = tlsf_block_locate_free(t, aligned_size);
+    if( b == NULL && tlsf_grow(t, aligned_size, align) ) {
+        b = tlsf_block_locate_free(t, aligned_size);
+    }
+    if( b == NULL ) {
+        return NULL;
+    }
+
+    if( align > TLSF_ALIGN ) {
+        u8*    ptr     = (u8*)tlsf_block_to_ptr(b);
+        u8*    aligned = (u8*)align_forward((uintptr_t)ptr, align);
+        size_t gap     = (size_t)(aligned - ptr);
+
+        if( gap && gap < gap_minimum ) {
+            size_t gap_remain = gap_minimum - gap;
+            size_t offset     = gap_remain > align ? gap_remain : align;
+            aligned = (u8*)align_forward((uintptr_t)(aligned + offset), align);
+            gap     = (size_t)(aligned - ptr);
+        }
+        if( gap ) {
+            b = tlsf_block_trim_free_leading(t, b, gap);
+        }
+    }
+
+    tlsf_block_trim_free(t, b, adjust);
+    tlsf_block_mark_as_used(b);
+    AllocTraceEmit(ALLOC_TRACE_ALLOC, ALLOC_TRACE_SOURCE_TLSF, tlsf_block_to_ptr(b), size, align);
+    return tlsf_block_to_ptr(b);
+}
+
+void tlsf_free(Tlsf_Allocator* t, void* ptr) {
+    if( ptr == NULL ) {
+        return;
+    }
+
+    Tlsf_Block* b = tlsf_block_from_ptr(ptr);
+    assert(!tlsf_block_is_free(b) && "block already marked as free");
+    AllocTraceEmit(ALLOC_TRACE_FREE, ALLOC_TRACE_SOURCE_TLSF, ptr, 0, 0);
+    tlsf_block_mark_as_free(b);
+    b = tlsf_block_merge_prev(t, b);
+    b = tlsf_block_merge_next(t, b);
+    tlsf_block_insert(t, b);
+}
+
+void* tlsf_resize(Tlsf_Allocator* t, void* ptr, i64 size, i64 alignment) {
+    if( ptr == NULL ) {
+        return tlsf_alloc(t, size, alignment);
+    }
+    if( size == 0 ) {
+        tlsf_free(t, ptr);
+        return NULL;
+    }
+
+    Tlsf_Block* b    = tlsf_block_from_ptr(ptr);
+    Tlsf_Block* next = tlsf_block_next(b);
+
+    size_t cursize  = tlsf_block_get_size(b);
+    size_t combined = cursize + tlsf_block_get_size(next) + TLSF_BLOCK_OVERHEAD;
+    size_t adjust   = tlsf_adjust_request_size((size_t)size, TLSF_ALIGN);
+    if( adjust == 0 ) {
+        return NULL;
+    }
+
+    bool misaligned = alignment > TLSF_ALIGN && ((uintptr_t)ptr & (uintptr_t)(alignment - 1)) != 0;
+    if( misaligned || (adjust > cursize && (!tlsf_block_is_free(next) || adjust > combined)) ) {
+        void* p = tlsf_alloc(t, size, alignment);
+        if( p != NULL ) {
+            memcpy(p, ptr, cursize < (size_t)size ? cursize : (size_t)size);
+            tlsf_free(t, ptr);
+        }
+        return p;
+    }
+
+    if( adjust > cursize ) {
+        tlsf_block_merge_next(t, b);
+        tlsf_block_mark_as_used(b);
+    }
+    tlsf_block_trim_used(t, b, adjust);
+    AllocTraceEmit(ALLOC_TRACE_FREE, ALLOC_TRACE_SOURCE_TLSF, ptr, 0, 0);
+    AllocTraceEmit(ALLOC_TRACE_ALLOC, ALLOC_TRACE_SOURCE_TLSF, ptr, size, alignment);
+    return ptr;
+}
+
+i64 tlsf_block_size(void* ptr) {
+    return ptr ? (i64)tlsf_block_get_size(tlsf_block_from_ptr(ptr)) : 0;
+}
+
+void tlsf_free_all(Tlsf_Allocator* t) {
+    t->fl_bitmap = 0;
+    memset(t->sl_bitmap, 0, sizeof(t->sl_bitmap));
+    for( i32 i = 0; i < TLSF_FL_COUNT; i += 1 ) {
+        for( i32 j = 0; j < TLSF_SL_COUNT; j += 1 ) {
+            t->blocks[i][j] = &t->block_null;
+        }
+    }
+    for( Tlsf_Pool* pool = t->pools; pool != NULL; pool = pool->next ) {
+        AllocTraceEmit(ALLOC_TRACE_FREE_RANGE, ALLOC_TRACE_SOURCE_TLSF, pool, pool->size, 0);
+        tlsf_pool_reset(t, pool);
+    }
+}
+
+// ------------------------------------------------------------------------ //
+// Allocator_Proc implementations
+
+void* tlsf_allocator_proc(void* data, Allocator_Mode mode, i64 size, i64 alignment, void* old_memory, i64 old_size) {
+    Tlsf_Allocator* t = (Tlsf_Allocator*)data;
+
+    switch( mode ) {
+        case Alloc: {
+            void* p = tlsf_alloc(t, size, alignment);
+            return p ? memset(p, 0, (size_t)size) : NULL;
+        }
+        case Alloc_Non_Zeroed:
+            return tlsf_alloc(t, size, alignment);
+        case Free:
+            tlsf_free(t, old_memory);
+            return NULL;
+        case Free_All:
+            tlsf_free_all(t);
+            return NULL;
+        case Resize: {
+            u8* p = (u8*)tlsf_resize(t, old_memory, size, alignment);
+            if( p != NULL && size > old_size ) {
+                memset(p + old_size, 0, (size_t)(size - old_size));
+            }
+            return p;
+        }
+        case Resize_Non_Zeroed:
+            return tlsf_resize(t, old_memory, size, alignment);
+        default:
+            return NULL;
+    }
+}
+
+void* arena_allocator_proc(void* data, Allocator_Mode mode, i64 size, i64 alignment, void* old_memory, i64 old_size) {
+    Arena* arena = (Arena*)data;
+
+    switch( mode ) {
+        case Alloc:
+        case Alloc_Non_Zeroed:
+        case Resize:
+        case Resize_Non_Zeroed: {
+            if( (mode == Resize || mode == Resize_Non_Zeroed) && old_memory != NULL && size <= old_size ) {
+                return old_memory;
+            }
+
+            // ArenaPush aligns to max_align_t, pad for anything stricter
+            //
+            i64 pad = alignment > (i64)_Alignof(max_align_t) ? alignment - 1 : 0;
+            u8* p   = (u8*)ArenaPush(arena, (U64)(size + pad));
+            if( p == NULL ) {
+                return NULL;
+            }
+            if( pad ) {
+                p = (u8*)align_forward((uintptr_t)p, (size_t)alignment);
+            }
+
+            // Popped memory is handed out again as it was left
+            //
+            if( mode == Alloc || mode == Resize ) {
+                memset(p, 0, (size_t)size);
+            }
+            if( old_memory != NULL && (mode == Resize || mode == Resize_Non_Zeroed) ) {
+                memcpy(p, old_memory, (size_t)old_size);
+            }
+            return p;
+        }
+        case Free:
+            return NULL;
+        case Free_All:
+            ArenaClear(arena);
+            return NULL;
+        default:
+            return NULL;
+    }
+}
+
+void* stack_allocator_proc(void* data, Allocator_Mode mode, i64 size, i64 alignment, void* old_memory, i64 old_size) {
+    Stack_Allocator* s = (Stack_Allocator*)data;
+
+    switch( mode ) {
+        case Alloc:             return stack_alloc(s, size, alignment);
+        case Alloc_Non_Zeroed:  return stack_alloc_non_zeroed(s, size, alignment);
+        case Free:              return stack_free(s, old_memory);
+        case Free_All:          stack_free_all(s); return NULL;
+        case Resize:            return stack_resize(s, old_memory, old_size, size, alignment);
+        case Resize_Non_Zeroed: return stack_resize_non_zeroed(s, old_memory, old_size, size, alignment);
+        default:                return NULL;
+    }
+}
+
+void* buddy_allocator_proc(void* data, Allocator_Mode mode, i64 size, i64 alignment, void* old_memory, i64 old_size) {
+    Buddy_Allocator* b = (Buddy_Allocator*)data;
+    assert((size_t)alignment <= b->alignment && "buddy blocks are only aligned to the init alignment");
+
+    switch( mode ) {
+        case Alloc:
+        case Alloc_Non_Zeroed: {
+            void* p = buddy_allocator_alloc(b, (size_t)size);
+            if( p != NULL && mode == Alloc ) {
+                memset(p, 0, (size_t)size);
+            }
+            return p;
+        }
+        case Free:
+            buddy_allocator_free(b, old_memory);
+            return NULL;
+        case Free_All: {
+            size_t total = (size_t)((char*)b->tail - (char*)b->head);
+            AllocTraceEmit(ALLOC_TRACE_FREE_RANGE, ALLOC_TRACE_SOURCE_BUDDY, b->head, total, 0);
+            buddy_allocator_init(b, b->head, total, b->alignment);
+            return NULL;
+        }
+        case Resize:
+        case Resize_Non_Zeroed: {
+            if( old_memory != NULL ) {
+                Buddy_Block* block = (Buddy_Block*)((char*)old_memory - b->alignment);
+                if( (size_t)size <= block->size - b->alignment ) {
+                    if( mode == Resize && size > old_size ) {
+                        memset((u8*)old_memory + old_size, 0, (size_t)(size - old_size));
+                    }
+                    return old_memory;
+                }
+            }
+            void* p = buddy_allocator_alloc(b, (size_t)size);
+            if( p != NULL ) {
+                if( mode == Resize ) {
+                    memset(p, 0, (size_t)size);
+                }
+                if( old_memory != NULL ) {
+                    memcpy(p, old_memory, (size_t)old_size);
+                    buddy_allocator_free(b, old_memory);
+                }
+            }
+            return p;
+        }
+        default:
+            return NULL;
+    }
+}
+
+Allocator tlsf_allocator(Tlsf_Allocator* t) {
+    Allocator a = { tlsf_allocator_proc, t };
+    return a;
+}
+
+Allocator arena_allocator(Arena* arena) {
+    Allocator a = { arena_allocator_proc, arena };
+    return a;
+}
+
+Allocator stack_allocator(Stack_Allocator* s) {
+    Allocator a = { stack_allocator_proc, s };
+    return a;
+}
+
+Allocator buddy_allocator(Buddy_Allocator* b) {
+    Allocator a = { buddy_allocator_proc, b };
+    return a;
+}
+
+void* allocator_alloc(Allocator* a, i64 size, i64 alignment) {
+    return a->Allocator_Proc(a->data, Alloc, size, alignment, NULL, 0);
+}
+
+void* allocator_resize(Allocator* a, void* old_memory, i64 old_size, i64 size, i64 alignment) {
+    return a->Allocator_Proc(a->data, Resize, size, alignment, old_memory, old_size);
+}
+
+void allocator_free(Allocator* a, void* ptr) {
+    a->Allocator_Proc(a->data, Free, 0, 0, ptr, 0);
+}
+
+void allocator_free_all(Allocator* a) {
+    a->Allocator_Proc(a->data, Free_All, 0, 0, NULL, 0);
+}
+
 #endif
@@ -134,53 +134,65 @@ D_DrawText2D(draw_bucket_instance* Instance, rect_2d rect, U8_String* Text, Font
 	vec2 Pos = rect.Pos;
 	if( Text->data != NULL && Text->idx > 0 ) {
 		f32 txt_offset = 0;
-		// Use unsigned char pointer to avoid signedness issues
-		u8* p = Text->data;
 		float pen_x = (float)Pos.x;
 		float pen_y = (float)Pos.y; // baseline or top depending on your coordinate convention
-		for ( u32 _it = 0; *p && _it < Text->idx && pen_x; ++p, ++_it) {
-			// Skip UTF-8 continuation bytes (0b10xxxxxx)
-			if ( (*p & 0xC0) == 0x80 ) continue;
-
-			unsigned char ch = *p;
-
-			int gi             = (int)ch - 32;
-			FontCache* UI_Font = FC;
-			f_Glyph g          = UI_Font->glyph[gi];
-			vec2 BitmapOffset  = UI_Font->BitmapOffset;
-
-			// UVs: add half-texel offset to avoid bleeding when sampling with linear filter
-			float _u0 = (g.x + BitmapOffset.x);
-			float _v0 = (g.y + BitmapOffset.y);
-			float _u1 = (g.width);
-			float _v1 = (g.height);
-
-			float x0 = pen_x + g.x_off;
+		// Codepoints a span at a time. Invalid bytes come out as U+FFFD and
+		// anything the font does not cache as F_GLYPH_FALLBACK, one glyph per
+		// character either way. A NUL ends the text
+		//
+		u32 Codepoints[F_TEXT_DECODE_SPAN];
+		u32 Prev   = 0;
+		i64 Offset = 0;
+		while( Offset < Text->idx && pen_x ) {
+			i64 Used  = 0;
+			i64 Count = Utf8Decode(Text->data + Offset, Text->idx - Offset, Codepoints, F_TEXT_DECODE_SPAN, &Used);
+			Offset += Used;
+			for( i64 _it = 0; _it < Count && pen_x; ++_it ) {
+				u32 ch = Codepoints[_it];
+				if( ch == 0 ) {
+					return;
+				}
+
+				FontCache* UI_Font = FC;
+				if( Prev ) {
+					pen_x += (f32)(i32)F_GetKerningFromCodepoint( UI_Font, Prev, ch );
+				}
+				Prev = ch;
+
+				u32 gi             = F_GlyphIndex(UI_Font, ch);
+				f_Glyph g          = UI_Font->glyph[gi];
+				vec2 BitmapOffset  = UI_Font->BitmapOffset;
+
+				// UVs: add half-texel offset to avoid bleeding when sampling with linear filter
+				float _u0 = (g.x + BitmapOffset.x);
+				float _v0 = (g.y + BitmapOffset.y);
+				float _u1 = (g.width);
+				float _v1 = (g.height);
+
+				float x0 = pen_x + g.x_off;
 #ifdef USE_FREETYPE
-			float y0 = pen_y + (UI_Font->line_height + UI_Font->ascent + UI_Font->descent ) / 2.f - g.y_off;
+				float y0 = pen_y + (UI_Font->line_height + UI_Font->ascent + UI_Font->descent ) / 2.f - g.y_off;
 #else
-			float y0 = pen_y + g.y_off + UI_Font->line_height;
+				float y0 = pen_y + g.y_off + UI_Font->line_height;
 #endif
-			//y0 = floorf(y0);
-
-			vec4 ColorVec = {Color.r, Color.g, Color.b, Color.a};
-			// Create quad vertices in the same winding you use for indices
-			v_2d v1 = {};
-			v1.LeftCorner = { x0, y0 };
-			v1.Size = { g.width, g.height };
-			v1.UV = { _u0, _v0 };
-			v1.UVSize = { _u1, _v1 };
-			v1.Color = ColorVec;
-			v1.CornerRadius = 0;
-			v1.IconUvSize = Vec2Zero();
+				//y0 = floorf(y0);
+
+				vec4 ColorVec = {Color.r, Color.g, Color.b, Color.a};
+				// Create quad vertices in the same winding you use for indices
+				v_2d v1 = {};
+				v1.LeftCorner = { x0, y0 };
+				v1.Size = { g.width, g.height };
+				v1.UV = { _u0, _v0 };
+				v1.UVSize = { _u1, _v1 };
+				v1.Color = ColorVec;
+				v1.CornerRadius = 0;
+				v1.IconUvSize = Vec2Zero();
 			
 
-			VectorAppend(&Instance->Current2DBuffer, &v1);
+				VectorAppend(&Instance->Current2DBuffer, &v1);
 
-			// Advance pen by glyph advance (use xadvance from packing)
-			pen_x += g.advance;
-			if( _it < Text->idx - 1 ) {
-				pen_x += F_GetKerningFromCodepoint( UI_Font, (int)gi, (int)*(p + 1) - 32 );
+				// Advance pen by glyph advance (use xadvance from packing)
+				pen_x += g.advance;
 			}
 		}
 	}
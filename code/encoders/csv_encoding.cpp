@@ -13,9 +13,7 @@ fn_internal csv_encoder CSV_Init(const char* FilePath, u64 N_Columns, Arena* Are
   Csv.NColumns = N_Columns;
   Csv.NRows = MAX_CSV_ROWS;
 
-  Csv.Rows.data = PushArray(Arena, u8, gigabyte(4));
-  Csv.Rows.len = gigabyte(4);
-  Csv.Rows.idx = 0;
+  StringBuilderInit(&Csv.Rows, Arena, 0);
 
   Csv.Delimiter = ',';
 
@@ -32,16 +30,16 @@ fn_internal void CSV_SetTitleNames(csv_encoder* Csv, const char* names[]) {
   }
 
   for (u64 i = 0; i < Csv->NColumns; i++) {
-    StringAppend(&Csv->Rows, Csv->ColumnNames[i]);
+    StringBuilderAppend(&Csv->Rows, Csv->ColumnNames[i]);
 
 
     // Write delimiter only if it's NOT the last column
     if (i < Csv->NColumns - 1) {
-      StringAppend(&Csv->Rows, &Csv->Delimiter);
+      StringBuilderAppendChar(&Csv->Rows, Csv->Delimiter);
     }
   }
   // Write a newline after the headers
-  StringAppend(&Csv->Rows, "\n");
+  StringBuilderAppendChar(&Csv->Rows, '\n');
 }
 
 fn_internal void CSV_BeginRow(csv_encoder* Csv) {
@@ -53,23 +51,51 @@ fn_internal void CSV_EndRow(csv_encoder* Csv) {
     fprintf(stderr, "[ERROR] Appended too many columns to row: %d\n", Csv->CurrentRow);
   }
   // Write the newline at the end of the row
-  StringAppend(&Csv->Rows, "\n");
+  StringBuilderAppendChar(&Csv->Rows, '\n');
 
   Csv->CurrentRow += 1;
   Csv->CurrentColumn = 0;
 }
 
 fn_internal void CSV_PushValue(csv_encoder* Csv, const char* Value) {
-  StringAppend(&Csv->Rows, Value);
+  CSV_PushValueN(Csv, Value, CustomStrlen(Value));
+}
+
+fn_internal void CSV_EndValue(csv_encoder* Csv) {
   if (Csv->CurrentColumn < Csv->NColumns - 1) {
-    StringAppend(&Csv->Rows, &Csv->Delimiter);
+    StringBuilderAppendChar(&Csv->Rows, Csv->Delimiter);
   }
   Csv->CurrentColumn += 1;
 }
 
-fn_internal void CSV_WriteToFile(csv_encoder* Csv) {
+fn_internal void CSV_PushValueN(csv_encoder* Csv, const char* Value, u64 Len) {
+  StringBuilderAppendN(&Csv->Rows, Value, Len);
+  CSV_EndValue(Csv);
+}
+
+fn_internal void CSV_PushU64(csv_encoder* Csv, u64 Value) {
+  StringBuilderAppendU64(&Csv->Rows, Value);
+  CSV_EndValue(Csv);
+}
+
+fn_internal void CSV_PushI64(csv_encoder* Csv, i64 Value) {
+  StringBuilderAppendI64(&Csv->Rows, Value);
+  CSV_EndValue(Csv);
+}
+
+fn_internal void CSV_PushF64(csv_encoder* Csv, F64 Value) {
+  StringBuilderAppendF64(&Csv->Rows, Value);
+  CSV_EndValue(Csv);
+}
 
-  F_FileWrite(&Csv->File, Csv->Rows.data, Csv->Rows.idx);
+fn_internal void CSV_WriteToFile(csv_encoder* Csv) {
+  #ifdef __linux__
+  StringBuilderWriteFd(&Csv->Rows, Csv->File.Fd);
+  #else
+  for (string_chunk* Chunk = Csv->Rows.First; Chunk != NULL; Chunk = Chunk->Next) {
+    F_FileWrite(&Csv->File, Chunk->Data, Chunk->Used);
+  }
+  #endif
 }
 
 fn_internal void CSV_Destroy(csv_encoder* Csv) {
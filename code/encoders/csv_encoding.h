@@ -21,7 +21,10 @@ struct csv_encoder {
   // CSV handler
   //
   char ColumnNames[MAX_CSV_COLUMNS][CSV_COLUMN_NAME_SIZE];
-  U8_String Rows;
+  // Rows grow in chunks from Arena and get written with one writev, nothing
+  // is reserved up front
+  //
+  string_builder Rows;
 
   u64  CurrentRow;
   u64  CurrentColumn;
@@ -40,6 +43,17 @@ fn_internal void CSV_EndRow(csv_encoder* Csv);
 
 fn_internal void CSV_PushValue(csv_encoder* Csv, const char* Value);
 
+fn_internal void CSV_PushValueN(csv_encoder* Csv, const char* Value, u64 Len);
+
+// Numbers go through fmt_fast.h straight into the rows, floats with the
+// shortest digits that read back the same
+//
+fn_internal void CSV_PushU64(csv_encoder* Csv, u64 Value);
+
+fn_internal void CSV_PushI64(csv_encoder* Csv, i64 Value);
+
+fn_internal void CSV_PushF64(csv_encoder* Csv, F64 Value);
+
 fn_internal void CSV_Destroy(csv_encoder* Csv);
 
 fn_internal void CSV_WriteToFile(csv_encoder* Csv);
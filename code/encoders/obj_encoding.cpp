@@ -73,10 +73,13 @@ fn_internal obj_instance OBJ_InstanceInit(const char* path, obj_load_flags flags
 
   i32 LineIt = 0;
 
-  dyn_vector<vec4> 
+  dyn_vector<vec4> ObjVector
     = dyn_vector<vec4>::Init(arena, mebibyte(25));
 
-  u8* data = PushArray(arena, u8, FileLength);
+  // The raw file is only needed while parsing, keep it out of the caller arena
+  //
+  Temp Scratch = GetScratch(&arena, 1);
+  u8* data = PushArray(Scratch.arena, u8, FileLength);
   F_SetFileData(&ObjFile, data);
   F_FileRead(&ObjFile);
 
@@ -147,6 +150,7 @@ fn_internal obj_instance OBJ_InstanceInit(const char* path, obj_load_flags flags
   }
 
   F_CloseFile(&ObjFile);
+  ReleaseScratch(Scratch);
 
   Instance.Vec4Vertices = ObjVector;
   
@@ -0,0 +1,392 @@
+#ifndef _GAP_BUFFER_H_
+#define _GAP_BUFFER_H_
+
+#include "types.h"
+#include "memory.h"
+#include "strings.h"
+
+// Editable text for input widgets. The text lives in one array with a hole
+// (the gap) at the edit point:
+//
+//   [ text before | gap ...... | text after ]
+//   0         GapStart      GapEnd      Capacity
+//
+// Inserting or erasing at the gap only moves GapStart/GapEnd. Editing
+// somewhere else first moves the gap there, which copies the bytes in between,
+// so typing at a cursor is O(1) no matter how long the text is.
+//
+// Every buffer owns its arena and the text is the last thing pushed on it, so
+// growing pushes more bytes right after the array and only the text after the
+// gap moves. The reservation is virtual, pages commit as the text grows.
+//
+// Line starts (the offset after every '\n') are kept with the same layout.
+// The ones before the gap are offsets from the start of the text, the ones
+// after it are offsets from the end, so an edit at the gap doesn't have to
+// touch any of them.
+//
+#ifndef GAP_BUFFER_RESERVE
+#define GAP_BUFFER_RESERVE  gigabyte( (U64)1 )
+#endif
+#define GAP_BUFFER_MIN_GAP  256
+
+typedef struct gap_buffer gap_buffer;
+struct gap_buffer {
+    Arena* TextArena;
+    u8*    Data;
+    i64    Capacity;
+    i64    GapStart;
+    i64    GapEnd;
+
+    Arena* LineArena;
+    i64*   Lines;
+    i64    LineCapacity;
+    i64    LineGapStart;
+    i64    LineGapEnd;
+};
+
+/**
+ * @brief Reserves a buffer, the gap_buffer itself lives in its own arena
+ * @param Text initial contents, may be NULL
+ * @param Len  bytes of Text
+ * @return gap_buffer* NULL if the reservation failed
+ */
+gap_buffer* GapBufferAlloc(const u8* Text, i64 Len);
+void        GapBufferRelease(gap_buffer* Buffer);
+
+fn_internal i64 GapBufferLength(gap_buffer* Buffer) { return Buffer->Capacity - (Buffer->GapEnd - Buffer->GapStart); }
+fn_internal i64 GapBufferCursor(gap_buffer* Buffer) { return Buffer->GapStart; }
+
+// Min and Max from memory.h don't nest, positions get clamped with this
+//
+fn_internal i64 GapBufferClamp(i64 Value, i64 Lo, i64 Hi) { return Value < Lo ? Lo : (Value > Hi ? Hi : Value); }
+
+/**
+ * @brief Moves the gap to Pos, clamped to the text
+ */
+void GapBufferMoveTo(gap_buffer* Buffer, i64 Pos);
+
+/**
+ * @brief Inserts Len bytes at Pos
+ * @return bool false if the reservation is full, nothing is inserted then
+ */
+bool GapBufferInsert(gap_buffer* Buffer, i64 Pos, const u8* Text, i64 Len);
+
+/**
+ * @brief Removes [Pos, Pos + Len), clamped to the text
+ */
+void GapBufferErase(gap_buffer* Buffer, i64 Pos, i64 Len);
+void GapBufferClear(gap_buffer* Buffer);
+
+u8   GapBufferAt(gap_buffer* Buffer, i64 Pos);
+
+/**
+ * @brief Views over [Start, End) without copying, one before the gap and one
+ *        after it, for drawing
+ * @return u32 how many of Spans are filled, 0 to 2
+ */
+u32  GapBufferSpans(gap_buffer* Buffer, i64 Start, i64 End, U8_String Spans[2]);
+
+/**
+ * @brief Moves the gap to the end and returns the whole text as one string,
+ *        null terminated. Valid until the next edit.
+ */
+U8_String GapBufferView(gap_buffer* Buffer);
+
+/**
+ * @brief Index of the last byte of Set before End, -1 if there is none
+ */
+i64  GapBufferFindLastOf(gap_buffer* Buffer, i64 End, const char* Set);
+
+i64  GapBufferLineCount(gap_buffer* Buffer);
+/**
+ * @brief Offset where Line (from 0) starts
+ */
+i64  GapBufferLineStart(gap_buffer* Buffer, i64 Line);
+/**
+ * @brief Line (from 0) that holds the byte at Pos
+ */
+i64  GapBufferLineOf(gap_buffer* Buffer, i64 Pos);
+
+#endif // _GAP_BUFFER_H_
+
+#ifdef GAP_BUFFER_IMPL
+
+static i64 GapBufferAlign(i64 Size) {
+    return (Size + 15) & ~(i64)15;
+}
+
+gap_buffer* GapBufferAlloc(const u8* Text, i64 Len) {
+    Arena* TextArena = ArenaAlloc(GAP_BUFFER_RESERVE);
+    Arena* LineArena = ArenaAlloc(GAP_BUFFER_RESERVE);
+    if( TextArena == NULL || LineArena == NULL ) {
+        if( TextArena ) { ArenaRelease(TextArena); }
+        if( LineArena ) { ArenaRelease(LineArena); }
+        return NULL;
+    }
+
+    gap_buffer* Buffer = PushArray(TextArena, gap_buffer, 1);
+    Buffer->TextArena  = TextArena;
+    Buffer->Capacity   = GapBufferAlign(Len + GAP_BUFFER_MIN_GAP);
+    Buffer->Data       = PushArray(TextArena, u8, Buffer->Capacity);
+    Buffer->GapStart   = 0;
+    Buffer->GapEnd     = Buffer->Capacity;
+
+    Buffer->LineArena    = LineArena;
+    Buffer->LineCapacity = GAP_BUFFER_MIN_GAP / sizeof(i64);
+    Buffer->Lines        = PushArray(LineArena, i64, Buffer->LineCapacity);
+    Buffer->LineGapStart = 0;
+    Buffer->LineGapEnd   = Buffer->LineCapacity;
+
+    if( Text != NULL && Len > 0 ) {
+        GapBufferInsert(Buffer, 0, Text, Len);
+    }
+    return Buffer;
+}
+
+void GapBufferRelease(gap_buffer* Buffer) {
+    if( Buffer == NULL ) {
+        return;
+    }
+    ArenaRelease(Buffer->LineArena);
+    ArenaRelease(Buffer->TextArena);
+}
+
+// Grows a gap array to NewCapacity elements. Pushes are aligned to 16 bytes,
+// so with capacities kept at multiples of 16 bytes the new bytes land right
+// after the array and only the part after the gap moves. Otherwise (a chained
+// arena starting a new segment) the whole array is copied once.
+//
+static u8* GapBufferGrowArray(Arena* Arena, u8* Data, i64 Capacity, i64 GapEnd, i64 NewCapacity, i64 ElementSize) {
+    u64 Extra = (u64)(NewCapacity - Capacity) * ElementSize;
+    u8* More  = (u8*)ArenaPush(Arena, Extra);
+    if( More == NULL ) {
+        return NULL;
+    }
+
+    u64 Tail = (u64)(Capacity - GapEnd) * ElementSize;
+    if( More == Data + Capacity * ElementSize ) {
+        memmove(Data + GapEnd * ElementSize + Extra, Data + GapEnd * ElementSize, Tail);
+        return Data;
+    }
+
+    u8* NewData = (u8*)ArenaPush(Arena, NewCapacity * ElementSize);
+    if( NewData == NULL ) {
+        return NULL;
+    }
+    memcpy(NewData, Data, GapEnd * ElementSize);
+    memcpy(NewData + GapEnd * ElementSize + Extra, Data + GapEnd * ElementSize, Tail);
+    return NewData;
+}
+
+static bool GapBufferReserve(gap_buffer* Buffer, i64 Len) {
+    if( Buffer->GapEnd - Buffer->GapStart >= Len ) {
+        return true;
+    }
+
+    i64 Length      = GapBufferLength(Buffer);
+    i64 NewCapacity = GapBufferAlign(Max(Buffer->Capacity * 2, Length + Len + GAP_BUFFER_MIN_GAP));
+    u8* Data        = GapBufferGrowArray(Buffer->TextArena, Buffer->Data, Buffer->Capacity, Buffer->GapEnd, NewCapacity, 1);
+    if( Data == NULL ) {
+        return false;
+    }
+
+    Buffer->Data     = Data;
+    Buffer->GapEnd  += NewCapacity - Buffer->Capacity;
+    Buffer->Capacity = NewCapacity;
+    return true;
+}
+
+static bool GapBufferReserveLines(gap_buffer* Buffer, i64 Count) {
+    if( Buffer->LineGapEnd - Buffer->LineGapStart >= Count ) {
+        return true;
+    }
+
+    i64 Used        = Buffer->LineCapacity - (Buffer->LineGapEnd - Buffer->LineGapStart);
+    i64 NewCapacity = GapBufferAlign(Max(Buffer->LineCapacity * 2, Used + Count + 16));
+    u8* Lines       = GapBufferGrowArray(Buffer->LineArena, (u8*)Buffer->Lines, Buffer->LineCapacity, Buffer->LineGapEnd, NewCapacity, sizeof(i64));
+    if( Lines == NULL ) {
+        return false;
+    }
+
+    Buffer->Lines         = (i64*)Lines;
+    Buffer->LineGapEnd   += NewCapacity - Buffer->LineCapacity;
+    Buffer->LineCapacity  = NewCapacity;
+    return true;
+}
+
+void GapBufferMoveTo(gap_buffer* Buffer, i64 Pos) {
+    i64 Length = GapBufferLength(Buffer);
+    Pos = GapBufferClamp(Pos, 0, Length);
+
+    if( Pos < Buffer->GapStart ) {
+        i64 Count = Buffer->GapStart - Pos;
+        memmove(Buffer->Data + Buffer->GapEnd - Count, Buffer->Data + Pos, Count);
+        Buffer->GapStart  = Pos;
+        Buffer->GapEnd   -= Count;
+
+        // Line starts past the new gap switch to counting from the end
+        //
+        while( Buffer->LineGapStart > 0 && Buffer->Lines[Buffer->LineGapStart - 1] > Pos ) {
+            Buffer->LineGapStart -= 1;
+            Buffer->LineGapEnd   -= 1;
+            Buffer->Lines[Buffer->LineGapEnd] = Length - Buffer->Lines[Buffer->LineGapStart];
+        }
+    } else if( Pos > Buffer->GapStart ) {
+        i64 Count = Pos - Buffer->GapStart;
+        memmove(Buffer->Data + Buffer->GapStart, Buffer->Data + Buffer->GapEnd, Count);
+        Buffer->GapStart += Count;
+        Buffer->GapEnd   += Count;
+
+        while( Buffer->LineGapEnd < Buffer->LineCapacity && Length - Buffer->Lines[Buffer->LineGapEnd] <= Pos ) {
+            Buffer->Lines[Buffer->LineGapStart] = Length - Buffer->Lines[Buffer->LineGapEnd];
+            Buffer->LineGapStart += 1;
+            Buffer->LineGapEnd   += 1;
+        }
+    }
+}
+
+bool GapBufferInsert(gap_buffer* Buffer, i64 Pos, const u8* Text, i64 Len) {
+    if( Len <= 0 ) {
+        return true;
+    }
+
+    i64 NewLines = StringCountByte(Text, Len, '\n');
+    if( !GapBufferReserve(Buffer, Len) || !GapBufferReserveLines(Buffer, NewLines) ) {
+        return false;
+    }
+    GapBufferMoveTo(Buffer, Pos);
+
+    i64 Start = Buffer->GapStart;
+    memcpy(Buffer->Data + Start, Text, Len);
+    Buffer->GapStart += Len;
+
+    for( i64 i = StringFindByte(Text, Len, '\n'); i != -1; ) {
+        Buffer->Lines[Buffer->LineGapStart++] = Start + i + 1;
+
+        i64 Next = StringFindByte(Text + i + 1, Len - i - 1, '\n');
+        i = Next == -1 ? -1 : i + 1 + Next;
+    }
+    return true;
+}
+
+void GapBufferErase(gap_buffer* Buffer, i64 Pos, i64 Len) {
+    i64 Length = GapBufferLength(Buffer);
+    Pos = GapBufferClamp(Pos, 0, Length);
+    Len = GapBufferClamp(Len, 0, Length - Pos);
+    if( Len <= 0 ) {
+        return;
+    }
+
+    GapBufferMoveTo(Buffer, Pos + Len);
+    Buffer->GapStart = Pos;
+
+    while( Buffer->LineGapStart > 0 && Buffer->Lines[Buffer->LineGapStart - 1] > Pos ) {
+        Buffer->LineGapStart -= 1;
+    }
+}
+
+void GapBufferClear(gap_buffer* Buffer) {
+    Buffer->GapStart     = 0;
+    Buffer->GapEnd       = Buffer->Capacity;
+    Buffer->LineGapStart = 0;
+    Buffer->LineGapEnd   = Buffer->LineCapacity;
+}
+
+u8 GapBufferAt(gap_buffer* Buffer, i64 Pos) {
+    return Pos < Buffer->GapStart ? Buffer->Data[Pos] : Buffer->Data[Pos + (Buffer->GapEnd - Buffer->GapStart)];
+}
+
+u32 GapBufferSpans(gap_buffer* Buffer, i64 Start, i64 End, U8_String Spans[2]) {
+    i64 Length = GapBufferLength(Buffer);
+    Start = GapBufferClamp(Start, 0, Length);
+    End   = GapBufferClamp(End, Start, Length);
+
+    u32 Count = 0;
+    if( Start < Buffer->GapStart ) {
+        U8_String S = {};
+        S.data = Buffer->Data + Start;
+        S.len  = (End < Buffer->GapStart ? End : Buffer->GapStart) - Start;
+        S.idx  = S.len;
+        Spans[Count++] = S;
+    }
+    if( End > Buffer->GapStart ) {
+        i64 From = Max(Start, Buffer->GapStart);
+        U8_String S = {};
+        S.data = Buffer->Data + From + (Buffer->GapEnd - Buffer->GapStart);
+        S.len  = End - From;
+        S.idx  = S.len;
+        Spans[Count++] = S;
+    }
+    return Count;
+}
+
+U8_String GapBufferView(gap_buffer* Buffer) {
+    i64 Length = GapBufferLength(Buffer);
+    GapBufferMoveTo(Buffer, Length);
+    GapBufferReserve(Buffer, 1);
+    Buffer->Data[Length] = '\0';
+
+    U8_String S = {};
+    S.data = Buffer->Data;
+    S.len  = Length + 1;
+    S.idx  = Length;
+    return S;
+}
+
+i64 GapBufferFindLastOf(gap_buffer* Buffer, i64 End, const char* Set) {
+    byte_set Bytes = ByteSetMake(Set);
+    U8_String Spans[2];
+    u32 Count = GapBufferSpans(Buffer, 0, End, Spans);
+
+    i64 Offset = 0;
+    for( u32 i = 0; i + 1 < Count; i += 1 ) {
+        Offset += Spans[i].idx;
+    }
+    for( i64 i = (i64)Count - 1; i >= 0; i -= 1 ) {
+        i64 Found = StringFindLastAnyByte(Spans[i].data, Spans[i].idx, &Bytes);
+        if( Found != -1 ) {
+            return Offset + Found;
+        }
+        if( i > 0 ) {
+            Offset -= Spans[i - 1].idx;
+        }
+    }
+    return -1;
+}
+
+i64 GapBufferLineCount(gap_buffer* Buffer) {
+    return 1 + Buffer->LineGapStart + (Buffer->LineCapacity - Buffer->LineGapEnd);
+}
+
+i64 GapBufferLineStart(gap_buffer* Buffer, i64 Line) {
+    if( Line <= 0 ) {
+        return 0;
+    }
+    i64 Idx = Line - 1;
+    if( Idx < Buffer->LineGapStart ) {
+        return Buffer->Lines[Idx];
+    }
+    Idx += Buffer->LineGapEnd - Buffer->LineGapStart;
+    if( Idx >= Buffer->LineCapacity ) {
+        return GapBufferLength(Buffer);
+    }
+    return GapBufferLength(Buffer) - Buffer->Lines[Idx];
+}
+
+i64 GapBufferLineOf(gap_buffer* Buffer, i64 Pos) {
+    // Last line whose start is <= Pos, line starts only grow
+    //
+    i64 Low  = 0;
+    i64 High = GapBufferLineCount(Buffer) - 1;
+    while( Low < High ) {
+        i64 Mid = Low + (High - Low + 1) / 2;
+        if( GapBufferLineStart(Buffer, Mid) <= Pos ) {
+            Low = Mid;
+        } else {
+            High = Mid - 1;
+        }
+    }
+    return Low;
+}
+
+#endif // GAP_BUFFER_IMPL
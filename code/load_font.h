@@ -1,6 +1,20 @@
 #ifndef _LOAD_FONT_H_
 #define _LOAD_FONT_H_
 
+// Glyphs cached per font: printable ASCII (32..127) then Latin-1 (160..255),
+// which covers most european file names and still packs in a 2100x60 strip.
+// Any other codepoint is drawn as F_GLYPH_FALLBACK
+//
+#define F_GLYPH_ASCII_FIRST  32
+#define F_GLYPH_LATIN1_FIRST 160
+#define F_GLYPH_RANGE        96
+#define F_GLYPH_COUNT        (2 * F_GLYPH_RANGE)
+#define F_GLYPH_FALLBACK     '?'
+
+// Codepoints decoded per Utf8Decode call when measuring/drawing text
+//
+#define F_TEXT_DECODE_SPAN   64
+
 typedef struct f_Glyph f_Glyph;
 struct f_Glyph {
 	u32 glyph   ;
@@ -22,7 +36,7 @@ struct f_kerning {
 
 typedef struct FontCache FontCache;
 struct FontCache {
-    f_Glyph    glyph[96];
+    f_Glyph    glyph[F_GLYPH_COUNT];
     f32        FontSize;
     u8*        BitmapArray;
     u32        BitmapWidth;
@@ -40,6 +54,9 @@ fn_internal FontCache F_BuildFont(f32 FontSize, u32 Width, u32 Height, u8* Bitma
 
 fn_internal u32 F_GetKerningFromCodepoint(FontCache* fc, u32 g1, u32 g2);
 
+fn_internal u32 F_GlyphIndex(FontCache* fc, u32 Codepoint);
+fn_internal u32 F_GlyphCodepoint(u32 Index);
+
 fn_internal u32 F_GetGlyphFromIdx(FontCache* fc, u64 idx);
 fn_internal f32 F_GetWidthFromIdx(FontCache* fc, u64 idx);
 fn_internal f32 F_GetHeightFromIdx(FontCache* fc, u64 idx);
@@ -101,35 +118,23 @@ F_BuildFont(f32 FontSize, u32 Width, u32 Height, u8* BitmapArray, const char* pa
     stbtt_GetFontVMetrics(&info, &fc.ascent, &fc.descent, &line_gap);
     fc.line_height = (f32)(fc.ascent - fc.descent + line_gap) * fc.scale;
 
-    u8* codepoint = (u8*)malloc(96);
-    codepoint[0] = 32;
-    for( u32 i = 0; i < 95; i += 1 ) {
-        codepoint[i+1] = i + 32;
-    }
-
-    stbtt_packedchar* char_data_range = (stbtt_packedchar*)malloc(96 * sizeof(stbtt_packedchar));
-#if 0
-    stbtt_pack_range range = {0};
-    range.font_size                        = (f32)FontSize;
-    range.first_unicode_codepoint_in_range = 0;
-    range.array_of_unicode_codepoints      = codepoint;
-    range.num_chars                        = 96;
-    range.chardata_for_range               = char_data_range;
-#else
-    stbtt_pack_range range = {0};
-    range.font_size  = FontSize;
-    range.first_unicode_codepoint_in_range = 32; // printable ASCII start
-    range.num_chars  = 96; // 32..126 inclusive -> 126-32+1 = 95
-    range.chardata_for_range = char_data_range;
-    range.array_of_unicode_codepoints = NULL;
-#endif
-    if (!stbtt_PackFontRanges(&ctx, data, 0, &range, 1)) {
+    stbtt_packedchar* char_data_range = (stbtt_packedchar*)malloc(F_GLYPH_COUNT * sizeof(stbtt_packedchar));
+    stbtt_pack_range range[2] = {};
+    range[0].font_size                        = FontSize;
+    range[0].first_unicode_codepoint_in_range = F_GLYPH_ASCII_FIRST;
+    range[0].num_chars                        = F_GLYPH_RANGE;
+    range[0].chardata_for_range               = char_data_range;
+    range[1].font_size                        = FontSize;
+    range[1].first_unicode_codepoint_in_range = F_GLYPH_LATIN1_FIRST;
+    range[1].num_chars                        = F_GLYPH_RANGE;
+    range[1].chardata_for_range               = char_data_range + F_GLYPH_RANGE;
+    if (!stbtt_PackFontRanges(&ctx, data, 0, range, 2)) {
         fprintf(stderr, "[ERROR] Failed to pack font ranges for %s\n", path);
     }
 
-    for(u32 i = 0; i < 96; i += 1) {
+    for(u32 i = 0; i < F_GLYPH_COUNT; i += 1) {
         stbtt_packedchar q  = char_data_range[i];
-        fc.glyph[i].glyph   = (u32)i + 32;
+        fc.glyph[i].glyph   = F_GlyphCodepoint(i);
 		fc.glyph[i].x_off   = q.xoff;
 		fc.glyph[i].y_off   = q.yoff;
 		fc.glyph[i].x       = (f32)q.x0;
@@ -139,22 +144,38 @@ F_BuildFont(f32 FontSize, u32 Width, u32 Height, u8* BitmapArray, const char* pa
 		fc.glyph[i].advance = q.xadvance;
     }
 
-    int table_len   = stbtt_GetKerningTableLength(&info);
-    fc.kerning_size = (u32)table_len;
-    fc.kerning      = (f_kerning*)malloc(sizeof(f_kerning) * table_len);
-    stbtt_kerningentry* table = (stbtt_kerningentry*)malloc(sizeof(stbtt_kerningentry) * table_len);
-
-    stbtt_GetKerningTable(&info, table, table_len);
+    // The kern table and GPOS are keyed by glyph ids, lookups are by codepoint.
+    // Every pair of cached codepoints is asked once here, kern table and GPOS
+    // both, and kept in pixels when it moves the pen. The entries come out
+    // sorted by (first, second) as F_GlyphCodepoint grows with the index
+    //
+    int glyph_ids[F_GLYPH_COUNT];
+    for( u32 i = 0; i < F_GLYPH_COUNT; i += 1 ) {
+        glyph_ids[i] = stbtt_FindGlyphIndex(&info, (int)F_GlyphCodepoint(i));
+    }
 
-    for( u32 i = 0; i < table_len; i += 1) {
-        stbtt_kerningentry k = table[i];
-		fc.kerning[i].first = (u32)k.glyph1;
-		fc.kerning[i].second = (u32)k.glyph2;
-		fc.kerning[i].amount = (u32)k.advance;
+    u32 kerning_cap = 0;
+    fc.kerning      = NULL;
+    fc.kerning_size = 0;
+    for( u32 i = 0; i < F_GLYPH_COUNT; i += 1 ) {
+        if( glyph_ids[i] == 0 ) continue;
+        for( u32 j = 0; j < F_GLYPH_COUNT; j += 1 ) {
+            if( glyph_ids[j] == 0 ) continue;
+            int advance = stbtt_GetGlyphKernAdvance(&info, glyph_ids[i], glyph_ids[j]);
+            i32 amount  = (i32)roundf((f32)advance * fc.scale);
+            if( amount == 0 ) continue;
+
+            if( fc.kerning_size == kerning_cap ) {
+                kerning_cap = kerning_cap ? kerning_cap * 2 : 64;
+                fc.kerning  = (f_kerning*)realloc(fc.kerning, sizeof(f_kerning) * kerning_cap);
+            }
+            f_kerning* k = &fc.kerning[fc.kerning_size++];
+            k->first  = F_GlyphCodepoint(i);
+            k->second = F_GlyphCodepoint(j);
+            k->amount = (u32)amount;
+        }
     }
 
-    free(table);
-    free(codepoint);
     free(char_data_range);
     #if __linux__
     munmap(data, FileSize);
@@ -167,16 +188,43 @@ F_BuildFont(f32 FontSize, u32 Width, u32 Height, u8* BitmapArray, const char* pa
     return fc;
 }
 
+// Binary search over the sorted pairs. The amount is signed pixels stored in a
+// u32, read it back through i32
+//
 fn_internal u32
 F_GetKerningFromCodepoint(FontCache* fc, u32 g1, u32 g2) {
-    for( u32 i = 0; i < fc->kerning_size; i += 1 ) {
-		if( fc->kerning[i].first == g1 && fc->kerning[i].second == g2) {
-			return fc->kerning[i].amount;
-		}
-	}
+    u64 Key = ((u64)g1 << 32) | g2;
+    u32 Lo  = 0;
+    u32 Hi  = fc->kerning_size;
+    while( Lo < Hi ) {
+        u32 Mid = Lo + (Hi - Lo) / 2;
+        u64 At  = ((u64)fc->kerning[Mid].first << 32) | fc->kerning[Mid].second;
+        if( At == Key ) {
+            return fc->kerning[Mid].amount;
+        }
+        if( At < Key ) {
+            Lo = Mid + 1;
+        } else {
+            Hi = Mid;
+        }
+    }
     return 0;
 }
 
+fn_internal u32 F_GlyphIndex(FontCache* fc, u32 Codepoint) {
+    if( Codepoint >= F_GLYPH_ASCII_FIRST && Codepoint < F_GLYPH_ASCII_FIRST + F_GLYPH_RANGE ) {
+        return Codepoint - F_GLYPH_ASCII_FIRST;
+    }
+    if( Codepoint >= F_GLYPH_LATIN1_FIRST && Codepoint < F_GLYPH_LATIN1_FIRST + F_GLYPH_RANGE ) {
+        return Codepoint - F_GLYPH_LATIN1_FIRST + F_GLYPH_RANGE;
+    }
+    return F_GLYPH_FALLBACK - F_GLYPH_ASCII_FIRST;
+}
+
+fn_internal u32 F_GlyphCodepoint(u32 Index) {
+    return Index < F_GLYPH_RANGE ? Index + F_GLYPH_ASCII_FIRST : Index - F_GLYPH_RANGE + F_GLYPH_LATIN1_FIRST;
+}
+
 fn_internal u32 F_GetGlyphFromIdx(FontCache* fc, u64 idx) {
     return fc->glyph[idx].glyph;
 }
@@ -202,17 +250,22 @@ F_TextWidth(FontCache* fc, const char* str, int str_len) {
     if (!fc || !str) return 0;
     if (str_len < 0) str_len = (int)strlen(str);
 
+    // Same walk as D_DrawText2D: codepoints a span at a time, a NUL ends the text
+    //
+    u32 Codepoints[F_TEXT_DECODE_SPAN];
+    u32 Prev  = 0;
     f32 width = 0;
-    for (int i = 0; i < str_len; ++i) {
-        unsigned char ch = (unsigned char)str[i];
-        if ( (ch & 0xC0) == 0x80 ) continue;
-        int g_idx = (int)ch - 32;
-        f_Glyph glyph = fc->glyph[g_idx];
-        // Use advance (xadvance) to advance pen, not bitmap width
-        width += glyph.advance;
-        if( i < str_len - 1 ) {
-           u32 kern = F_GetKerningFromCodepoint( fc, (int)g_idx, (int) str[i+1] - 32 );
-            width += kern;
+    i64 Pos   = 0;
+    while (Pos < str_len) {
+        i64 Used  = 0;
+        i64 Count = Utf8Decode((const u8*)str + Pos, str_len - Pos, Codepoints, F_TEXT_DECODE_SPAN, &Used);
+        Pos += Used;
+        for (i64 i = 0; i < Count; ++i) {
+            if (Codepoints[i] == 0) return width;
+            if (Prev) width += (f32)(i32)F_GetKerningFromCodepoint(fc, Prev, Codepoints[i]);
+            // Use advance (xadvance) to advance pen, not bitmap width
+            width += fc->glyph[F_GlyphIndex(fc, Codepoints[i])].advance;
+            Prev = Codepoints[i];
         }
     }
     return width;
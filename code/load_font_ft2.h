@@ -14,6 +14,20 @@ static int FtLibrary_initialized = 0;
 
 global FT_Library FtLibrary;
 
+// Glyphs cached per font: printable ASCII (32..127) then Latin-1 (160..255),
+// which covers most european file names. Any other codepoint, or one the font
+// has no glyph for, is drawn as F_GLYPH_FALLBACK
+//
+#define F_GLYPH_ASCII_FIRST  32
+#define F_GLYPH_LATIN1_FIRST 160
+#define F_GLYPH_RANGE        96
+#define F_GLYPH_COUNT        (2 * F_GLYPH_RANGE)
+#define F_GLYPH_FALLBACK     '?'
+
+// Codepoints decoded per Utf8Decode call when measuring/drawing text
+//
+#define F_TEXT_DECODE_SPAN   64
+
 typedef struct f_Glyph f_Glyph;
 struct f_Glyph {
 	u32 glyph   ;
@@ -35,7 +49,7 @@ struct f_kerning {
 
 typedef struct FontCache FontCache;
 struct FontCache {
-    f_Glyph    glyph[96];
+    f_Glyph    glyph[F_GLYPH_COUNT];
     f32        FontSize;
     u8*        BitmapArray;
     u32        BitmapWidth;
@@ -53,6 +67,9 @@ fn_internal FontCache F_BuildFont(f32 FontSize, u32 Width, u32 Height, u8* Bitma
 
 fn_internal u32 F_GetKerningFromCodepoint(FontCache* fc, u32 g1, u32 g2);
 
+fn_internal u32 F_GlyphIndex(FontCache* fc, u32 Codepoint);
+fn_internal u32 F_GlyphCodepoint(u32 Index);
+
 fn_internal u32 F_GetGlyphFromIdx(FontCache* fc, u64 idx);
 fn_internal f32 F_GetWidthFromIdx(FontCache* fc, u64 idx);
 fn_internal f32 F_GetHeightFromIdx(FontCache* fc, u64 idx);
@@ -216,13 +233,9 @@ fn_internal FontCache F_BuildFont(f32 FontSize, u32 Width, u32 Height, u8* Bitma
     ShelfPacker packer;
     shelf_init(&packer, Width, Height);
 
-    // glyph loop for codepoints 32..127 exclusive? We pack 96 glyphs (your FontCache has glyph[96])
-    const u32 start_cp = 32;
-    const u32 glyphs_total = 96; // matches your FontCache array length
-
-    // iterate and render each glyph, pack it
-    for (u32 i = 0; i < glyphs_total; ++i) {
-        u32 cp = start_cp + i;
+    // iterate and render each glyph of the cached ranges, pack it
+    for (u32 i = 0; i < F_GLYPH_COUNT; ++i) {
+        u32 cp = F_GlyphCodepoint(i);
         FT_UInt gindex = FT_Get_Char_Index(face, (FT_ULong)cp);
         fc.glyph[i].glyph = cp; // store codepoint in glyph field
 
@@ -338,14 +351,27 @@ fn_internal u32 F_GetKerningFromCodepoint(FontCache* fc, u32 g1, u32 g2) {
     return 0;
 }
 
-// Get glyph array index from codepoint idx (assume idx is codepoint, e.g. 'A' or integer); returns index into fc->glyph or 0 if missing.
-// We assume cached range is 32..(32+96-1)
+// Index into fc->glyph for a codepoint. Glyphs the font lacks were left with
+// no advance, those go to the fallback too
+fn_internal u32 F_GlyphIndex(FontCache* fc, u32 Codepoint) {
+    u32 i = F_GLYPH_FALLBACK - F_GLYPH_ASCII_FIRST;
+    if (Codepoint >= F_GLYPH_ASCII_FIRST && Codepoint < F_GLYPH_ASCII_FIRST + F_GLYPH_RANGE) {
+        i = Codepoint - F_GLYPH_ASCII_FIRST;
+    } else if (Codepoint >= F_GLYPH_LATIN1_FIRST && Codepoint < F_GLYPH_LATIN1_FIRST + F_GLYPH_RANGE) {
+        i = Codepoint - F_GLYPH_LATIN1_FIRST + F_GLYPH_RANGE;
+    }
+    if (fc && fc->glyph[i].advance == 0) return F_GLYPH_FALLBACK - F_GLYPH_ASCII_FIRST;
+    return i;
+}
+
+fn_internal u32 F_GlyphCodepoint(u32 Index) {
+    return Index < F_GLYPH_RANGE ? Index + F_GLYPH_ASCII_FIRST : Index - F_GLYPH_RANGE + F_GLYPH_LATIN1_FIRST;
+}
+
+// Get glyph array index from codepoint idx (assume idx is codepoint, e.g. 'A' or integer)
 fn_internal u32 F_GetGlyphFromIdx(FontCache* fc, u64 idx) {
     if (!fc) return 0;
-    u64 cp = idx;
-    if (cp < 32 || cp >= 32 + 96) return 0;
-    u32 i = (u32)(cp - 32);
-    return i;
+    return F_GlyphIndex(fc, idx > 0xFFFFFFFFu ? 0 : (u32)idx);
 }
 
 fn_internal f32 F_GetWidthFromIdx(FontCache* fc, u64 idx) {
@@ -371,22 +397,24 @@ fn_internal f32 F_GetPosYInBitmapFromIdx(FontCache* fc, u64 idx) {
 
 fn_internal f32 F_TextWidth(FontCache* fc, const char* str, int str_len) {
     if (!fc || !str) return 0.0f;
-    // simple ASCII loop; you may want to decode UTF-8 into codepoints and use that instead.
+    // Same walk as D_DrawText2D: codepoints a span at a time, a NUL ends the text
+    u32 Codepoints[F_TEXT_DECODE_SPAN];
     f32 w = 0.0f;
     u32 prev_cp = 0;
-    for (int i = 0; i < str_len && str[i] != '\0'; ++i) {
-        unsigned char c = (unsigned char)str[i];
-        if (c < 32 || c >= 32 + 96) {
-            // if outside cached range, treat as space
-            c = ' ';
+    i64 pos = 0;
+    while (pos < str_len) {
+        i64 used  = 0;
+        i64 count = Utf8Decode((const u8*)str + pos, str_len - pos, Codepoints, F_TEXT_DECODE_SPAN, &used);
+        pos += used;
+        for (i64 i = 0; i < count; ++i) {
+            u32 c = Codepoints[i];
+            if (c == 0) return w;
+            u32 kerning = 0;
+            if (prev_cp) kerning = F_GetKerningFromCodepoint(fc, prev_cp, c);
+            w += (f32)kerning;
+            w += fc->glyph[F_GlyphIndex(fc, c)].advance;
+            prev_cp = c;
         }
-        u32 gi = F_GetGlyphFromIdx(fc, c);
-        if (gi >= 96) continue;
-        u32 kerning = 0;
-        if (prev_cp) kerning = F_GetKerningFromCodepoint(fc, prev_cp, (u32)c);
-        w += (f32)kerning;
-        w += fc->glyph[gi].advance;
-        prev_cp = (u32)c;
     }
     return w;
 }
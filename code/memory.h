@@ -23,8 +23,14 @@ that we are easing the work for the os in terms of memory managment.
 #include <sys/utsname.h>
 
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #endif
 
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+
 #ifdef __cplusplus
 
 #include <cstddef>
@@ -44,10 +50,80 @@ that we are easing the work for the os in terms of memory managment.
 #define DEFAULT_COMMIT   PAGE_SIZE
 #define DEFAULT_DECOMMIT PAGE_SIZE
 #define ARENA_DECOMMIT_THRESHOLD mebibyte(64)
+#define HUGE_PAGE_SIZE   mebibyte( 2 )
+
+// Reserve used for every segment of a chained arena, and what an arena falls
+// back to when its full reservation is refused (vm.overcommit_memory=2, ulimit -v).
+//
+#ifndef ARENA_SEGMENT_RESERVE
+#define ARENA_SEGMENT_RESERVE mebibyte( 64 )
+#endif
 
 #define Max( a, b ) a > b ? a : b
 #define Min( a, b ) a < b ? a : b
 
+// Scratch arenas handed out per thread by GetScratch. Two is enough for the
+// usual "caller arena + callee scratch" nesting, raise it if you nest deeper.
+//
+#ifndef SCRATCH_ARENA_COUNT
+#define SCRATCH_ARENA_COUNT   2
+#endif
+#ifndef SCRATCH_ARENA_RESERVE
+#define SCRATCH_ARENA_RESERVE gigabyte( 1 )
+#endif
+
+#if defined(__cplusplus)
+#define thread_static static thread_local
+#elif defined(_MSC_VER)
+#define thread_static static __declspec(thread)
+#else
+#define thread_static static _Thread_local
+#endif
+
+// Opt-in allocation tracing. Built with -DALLOC_TRACE every push, pop and free
+// of the arenas and of the allocator.h allocators is reported to AllocTraceHook,
+// alloc_trace.h installs a hook that records them to a file. Without the define
+// AllocTraceEmit compiles to nothing.
+//
+// ALLOC_TRACE_FREE_RANGE releases every allocation inside [Ptr, Ptr + Size),
+// that is what an arena pop or a stack_free_all looks like.
+//
+// An allocator built on top of another one (the pool getting its chunks from a
+// stack or an arena, a Stack_Allocator given a buffer pushed from an arena)
+// reports its own allocations and the backing one is muted between
+// AllocTraceMute and AllocTraceUnmute, so nothing is counted twice.
+//
+enum {
+    ALLOC_TRACE_ALLOC,
+    ALLOC_TRACE_FREE,
+    ALLOC_TRACE_FREE_RANGE,
+};
+
+enum {
+    ALLOC_TRACE_SOURCE_ARENA,
+    ALLOC_TRACE_SOURCE_STACK,
+    ALLOC_TRACE_SOURCE_POOL,
+    ALLOC_TRACE_SOURCE_BUDDY,
+    ALLOC_TRACE_SOURCE_TLSF,
+    ALLOC_TRACE_SOURCE_COUNT
+};
+
+#ifdef ALLOC_TRACE
+typedef void (*alloc_trace_hook)( U32 Event, U32 Source, void* Ptr, U64 Size, U64 Align );
+
+static alloc_trace_hook AllocTraceHook;
+thread_static U32 AllocTraceMuted;
+
+#define AllocTraceEmit( Event, Source, Ptr, Size, Align ) \
+    do { if( AllocTraceHook && !AllocTraceMuted ) AllocTraceHook( Event, Source, (void*)(Ptr), (U64)(Size), (U64)(Align) ); } while( 0 )
+#define AllocTraceMute()   (AllocTraceMuted += 1)
+#define AllocTraceUnmute() (AllocTraceMuted -= 1)
+#else
+#define AllocTraceEmit( Event, Source, Ptr, Size, Align ) ((void)0)
+#define AllocTraceMute()   ((void)0)
+#define AllocTraceUnmute() ((void)0)
+#endif
+
 typedef struct free_block free_block;
 struct free_block {
   void* Data;
@@ -57,14 +133,105 @@ struct free_block {
   free_block* Prev;
 } free_block;
 
+// Decommit through MADV_FREE (MEM_RESET on Windows) instead of MADV_DONTNEED.
+// Pages stay mapped and are reclaimed lazily by the OS, so pushing over them
+// again costs no syscall.
+//
+#define ARENA_POLICY_LAZY_FREE (1 << 0)
+
+// Flags for ArenaAllocEx. Both make the arena commit in HUGE_PAGE_SIZE steps and
+// align its base to HUGE_PAGE_SIZE, so every commit covers whole huge pages.
+//
+// ARENA_FLAG_HUGE_HINT     asks for transparent huge pages (madvise MADV_HUGEPAGE).
+// ARENA_FLAG_HUGE_EXPLICIT maps from the hugetlbfs pool (MAP_HUGETLB / MEM_LARGE_PAGES).
+//                          The pool pages are reserved up front for the whole size, so
+//                          keep the reserve small. If the pool can't hold it we fall back
+//                          to ARENA_FLAG_HUGE_HINT, check arena->flags for what you got.
+//
+#define ARENA_FLAG_HUGE_HINT     (1 << 0)
+#define ARENA_FLAG_HUGE_EXPLICIT (1 << 1)
+
+// The arena is a linked chain of smaller reservations. When a push doesn't fit
+// in the current segment a new one is reserved, positions keep growing across
+// segments so TempBegin/TempEnd and ArenaPopTo work over the whole chain.
+// ArenaAllocEx sets it by itself when the reservation it was asked for fails.
+//
+#define ARENA_FLAG_CHAINED       (1 << 2)
+
+// The reservation is a MAP_SHARED mapping of a file (see ArenaAllocFile). The
+// whole mapping is usable from the start and never decommitted, pointers stored
+// in it have to be arena_offset so they survive being mapped somewhere else.
+//
+#define ARENA_FLAG_FILE          (1 << 3)
+
+// Tells a file we wrote apart from garbage. sizeof(Arena) is added in so a
+// file written by a build with a different Arena layout is started over.
+//
+#define ARENA_FILE_MAGIC         0x454C494641524E41ull
+
+// Flag for ArenaPrefault / ArenaPrefaultRange, pins the range with mlock
+// (VirtualLock on Windows) on top of faulting it in.
+//
+#define ARENA_PREFAULT_LOCK      (1 << 0)
+
+typedef struct arena_policy arena_policy;
+struct arena_policy
+{
+    U64 CommitMin;         // first commit step, snapped to the page size
+    U64 CommitMax;         // commit steps never grow past this
+    U32 CommitGrowth;      // each commit step is the last one times this (1 = linear)
+    U32 DecommitDelay;     // frames (pops without ArenaFrameBegin) with unused slack needed before we decommit
+    U64 DecommitThreshold; // committed slack kept above the high water mark
+    U32 Flags;             // ARENA_POLICY_*
+};
+
+typedef struct arena_stats arena_stats;
+struct arena_stats
+{
+    U64 CommitCalls;
+    U64 DecommitCalls;
+    U64 CommitsAvoided;    // page boundaries crossed without having to commit
+    U64 DecommitsAvoided;  // pops that kept their slack committed
+    U64 CommitPeak;
+    U64 CommitFailures;    // commits the OS refused, the push moved on or failed
+};
+
 typedef struct Arena Arena;
 struct Arena
 {
     U64 size;
     U64 pos;
     U64 commit_pos;
+    U64 reserved;         // bytes actually mapped, size snapped up by the reserve
+    U64 page_size;        // commit granularity, HUGE_PAGE_SIZE for huge arenas
+    U32 flags;            // ARENA_FLAG_* the arena really got
+
+    Arena* current;       // segment pushes go to, the arena itself unless chained
+    Arena* prev;          // segment below this one in the chain
+    Arena* spare;         // last popped segment, kept to not re-reserve at a boundary
+    U64 base_pos;         // chain position where this segment starts
+    U64 segment_size;     // reserve for new segments, 0 unless chained
+
+    arena_policy policy;
+    arena_stats  stats;
+    U64 commit_step;      // next geometric commit step
+    U64 high_water;       // highest pos since the last pop
+    U64 lazy_free_pos;    // [lazy_free_pos, commit_pos) was already given back lazily
+    U32 decommit_pending; // consecutive frames (or pops) that left slack unused
+    U64 decommit_frame;   // ArenaFrameIndex decommit_pending was last counted in
+    U64 prefault_pos;     // [0, prefault_pos) was prefaulted, decommit never goes below it
+
+    U64 file_magic;       // ARENA_FILE_MAGIC + sizeof(Arena) once a file arena is set up
+    U64 file_handle;      // fd (HANDLE on Windows) of the mapped file
+    U64 file_mapping;     // file mapping HANDLE on Windows, unused elsewhere
+    U64 root;             // arena_offset of the user's root object, file arenas
 };
 
+// Relocatable pointer: byte offset from the start of the arena. Offset 0 is the
+// arena header, so it doubles as NULL.
+//
+typedef U64 arena_offset;
+
 typedef struct Temp Temp;
 struct Temp
 {
@@ -72,23 +239,173 @@ struct Temp
  U64 pos;
 };
 
+// Bytes every thread carves out of a ConcurrentArena at once. Pushes up to an
+// eighth of it are served from the thread's chunk without touching shared state.
+//
+#ifndef CONCURRENT_ARENA_CHUNK
+#define CONCURRENT_ARENA_CHUNK kibibyte( 64 )
+#endif
+#define CONCURRENT_ARENA_THREAD_SLOTS 4
+
+// Arena many threads can push into at once. pos is claimed with an atomic
+// fetch-add and commit_pos only moves forward through a CAS once the pages
+// under it are committed, so a push never waits on another one. pos and
+// commit_pos sit on their own cache lines.
+//
+typedef struct ConcurrentArena ConcurrentArena;
+struct ConcurrentArena
+{
+    U8* base;
+    U64 reserved;
+    U64 commit_step;
+    U64 chunk_size;      // 0 pushes straight to the shared pos
+    U64 generation;      // unique per arena and per clear, old thread chunks are dropped
+    U8  pad0[24];
+
+    volatile U64 pos;
+    U8  pad1[56];
+
+    volatile U64 commit_pos;
+    U8  pad2[56];
+};
+
+fn_internal U64    ArenaImplPageSize( void );
 fn_internal void*  ArenaImplReserve ( U64 size );
-fn_internal void   ArenaImplCommit  ( void* ptr, U64 size );
+fn_internal void*  ArenaImplReserveEx( U64 size, U32* Flags, U64* Reserved );
+fn_internal bool   ArenaImplCommit  ( void* ptr, U64 size );
 fn_internal void   ArenaImplDecommit( void* ptr, U64 size );
+fn_internal void   ArenaImplLazyFree( void* ptr, U64 size );
 fn_internal void   ArenaImplRelease ( void* ptr, U64 size );
+fn_internal void   ArenaImplPrefault( void* ptr, U64 size );
+fn_internal U32    ArenaImplLock    ( void* ptr, U64 size );
+fn_internal void*  ArenaImplMapFile ( const char* Path, U64 size, U64* Mapped, U64* Handle, U64* Mapping );
+fn_internal void   ArenaImplUnmapFile( void* ptr, U64 size, U64 Handle, U64 Mapping );
 
-fn_internal void ArenaImplCommitWithFlags(void* ptr, U64 size, U64 MemFlags, U64 PageFlags);
+fn_internal bool ArenaImplCommitWithFlags(void* ptr, U64 size, U64 MemFlags, U64 PageFlags);
 
 fn_internal Arena* ArenaAlloc( U64 size );
 fn_internal Arena* ArenaAllocDefault( void );
+
+/**
+ * @brief Same as ArenaAlloc but lets you ask for huge page backing.
+ * @param size  Bytes to reserve
+ * @param Flags ARENA_FLAG_* combination, 0 behaves like ArenaAlloc
+ */
+fn_internal Arena* ArenaAllocEx( U64 size, U32 Flags );
+
+/**
+ * @brief Current position of the arena. For chained arenas it counts across
+ * segments, this is the value TempBegin records and ArenaPopTo expects.
+ */
+fn_internal U64    ArenaPos( Arena* arena );
 fn_internal void*  ArenaPush( Arena* arena, U64 size );
 fn_internal void   ArenaPop ( Arena* arena, U64 erase  );
 
 fn_internal void* ArenaPushWithFlags(Arena* arena, U64 size, U64 MemFlags, U64 PageFlags);
 
+fn_internal void   ArenaPopTo  ( Arena* arena, U64 pos );
 fn_internal void   ArenaRelease( Arena* arena );
 fn_internal void   ArenaClear  ( Arena* arena );
 
+/**
+ * @brief Marks the start of a frame for every arena. Decommit delays count
+ * frames, so a frame that pops a scratch arena a hundred times moves them one
+ * step. A program that never calls it counts pops instead.
+ */
+fn_internal void   ArenaFrameBegin( void );
+
+/**
+ * @brief Policy every arena starts with: geometric commits from DEFAULT_COMMIT up to
+ * 64 MiB, and slack above ARENA_DECOMMIT_THRESHOLD only given back after it has
+ * gone unused for 60 frames (one second at 60 fps).
+ */
+fn_internal arena_policy ArenaDefaultPolicy( void );
+fn_internal void         ArenaSetPolicy( Arena* arena, arena_policy Policy );
+fn_internal arena_stats  ArenaGetStats( Arena* arena );
+fn_internal void         ArenaResetStats( Arena* arena );
+
+/**
+ * @brief Commits and faults in the next bytes of the arena, so the pushes that
+ * land there later don't page fault in the middle of a frame. The range is
+ * never decommitted afterwards. It can run on a background thread as long as
+ * nobody pushes into the arena meanwhile. For chained arenas only the current
+ * segment is prefaulted.
+ * @param Flags 0 or ARENA_PREFAULT_LOCK
+ * @return 0 if ARENA_PREFAULT_LOCK was refused (RLIMIT_MEMLOCK) even after
+ * raising the soft limit, the range is still prefaulted and the first refusal
+ * is logged to stderr
+ */
+fn_internal U32    ArenaPrefault( Arena* arena, U64 bytes, U32 Flags );
+
+/**
+ * @brief Same as ArenaPrefault for memory already pushed, e.g. the buffer
+ * behind a Stack_Allocator.
+ */
+fn_internal U32    ArenaPrefaultRange( void* ptr, U64 size, U32 Flags );
+
+/**
+ * @brief Maps Path as the arena's reservation. If the file holds an arena written
+ * by this same build, pos and the root object come back as they were left, so
+ * state pushed in a previous run is there without rebuilding it. Otherwise the
+ * file is grown to size and started empty.
+ * @param Path File to map, created when missing
+ * @param size Bytes to map, the file is sparse so only what is pushed takes disk
+ * @return NULL if the file can't be opened or mapped
+ */
+fn_internal Arena* ArenaAllocFile( const char* Path, U64 size );
+
+/** @brief Writes the dirty pages of a file arena back to disk and waits for it. */
+fn_internal void   ArenaFlush( Arena* arena );
+
+fn_internal arena_offset ArenaOffset( Arena* arena, void* ptr );
+fn_internal void*        ArenaFromOffset( Arena* arena, arena_offset offset );
+
+/**
+ * @brief Root object of a file arena, the entry point to everything stored in it.
+ * ArenaGetRoot returns NULL on a cold start.
+ */
+fn_internal void   ArenaSetRoot( Arena* arena, void* ptr );
+fn_internal void*  ArenaGetRoot( Arena* arena );
+
+#define ArenaPtr( arena, type, offset ) ((type*)ArenaFromOffset( arena, offset ))
+
+fn_internal Temp   TempBegin( Arena* arena );
+fn_internal void   TempEnd  ( Temp temp );
+
+/**
+ * @brief Returns a scratch arena from the calling thread's pool that is not any of
+ * the arenas in Conflicts. The pool is reserved lazily the first time a thread asks.
+ * @param Conflicts     Arenas the caller already holds (usually the one it returns data in)
+ * @param ConflictCount Number of entries in Conflicts, may be 0
+ * @return Temp to give back with ReleaseScratch
+ */
+fn_internal Temp   GetScratch( Arena** Conflicts, U64 ConflictCount );
+fn_internal void   ScratchPoolRelease( void );
+fn_internal arena_stats ScratchPoolGetStats( void );
+
+#define ReleaseScratch( temp ) TempEnd( temp )
+
+/**
+ * @brief Reserves a ConcurrentArena.
+ * @param size      Bytes to reserve
+ * @param ChunkSize Per-thread chunk, 0 to make every push claim from the
+ *                  shared pos, CONCURRENT_ARENA_CHUNK is a good default
+ */
+fn_internal ConcurrentArena* ConcurrentArenaAlloc( U64 size, U64 ChunkSize );
+
+/** @brief Thread safe, lock free. NULL once the reservation is used up. */
+fn_internal void*            ConcurrentArenaPush( ConcurrentArena* arena, U64 size );
+
+/** @brief Bytes claimed so far, thread chunks count whole. */
+fn_internal U64              ConcurrentArenaPos( ConcurrentArena* arena );
+
+/**
+ * @brief Empties the arena. Not thread safe: nobody can be pushing and nothing
+ * pushed before can be used afterwards.
+ */
+fn_internal void             ConcurrentArenaClear( ConcurrentArena* arena );
+fn_internal void             ConcurrentArenaRelease( ConcurrentArena* arena );
+
 #define PushArray( arena, type, count ) (type*)ArenaPush( arena, sizeof( type ) * count )
 #define PopArray( arena, type, count )  ArenaPop( arena, sizeof( type ) * count )
 
@@ -97,63 +414,153 @@ fn_internal void   ArenaClear  ( Arena* arena );
 
 #ifdef MEMORY_IMPL
 
+// Page size never changes while running, ask the OS once
+//
+static U64 ArenaCachedPageSize = 0;
+
+fn_internal U64
+ArenaImplPageSize( void )
+{
+    if( ArenaCachedPageSize == 0 ) {
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo( &info );
+        ArenaCachedPageSize = info.dwPageSize;
+#else
+        ArenaCachedPageSize = (U64)sysconf(_SC_PAGE_SIZE);
+#endif
+    }
+    return ArenaCachedPageSize;
+}
+
+// Big reservations are snapped to whole gigabytes, small ones (chain segments)
+// only to huge pages so reserving small really stays small.
+//
+fn_internal U64
+ArenaImplReserveSize( U64 size )
+{
+    U64 Granularity = size >= gigabyte(1) ? gigabyte(1) : HUGE_PAGE_SIZE;
+    U64 snapped_size = size + Granularity - 1;
+    snapped_size    -= snapped_size % Granularity;
+    return snapped_size;
+}
+
 fn_internal void*
 ArenaImplReserve( U64 size )
 {
-    U64 gb_snapped_size = size;
-    gb_snapped_size += gigabyte(1) - 1;
-    gb_snapped_size -= gb_snapped_size%gigabyte(1);
+    U64 snapped_size = ArenaImplReserveSize( size );
 
 #ifdef _WIN32
-    void *ptr = VirtualAlloc( 0, gb_snapped_size, MEM_RESERVE, PAGE_NOACCESS );
+    void *ptr = VirtualAlloc( 0, snapped_size, MEM_RESERVE, PAGE_NOACCESS );
 #else
-    void *ptr = mmap( NULL, gb_snapped_size, PROT_NONE, MAP_PRIVATE | MAP_ANON, -1, 0 );
+    void *ptr = mmap( NULL, snapped_size, PROT_NONE, MAP_PRIVATE | MAP_ANON, -1, 0 );
+    if( ptr == MAP_FAILED ) {
+        ptr = NULL;
+    }
 #endif
 
     return ptr;
 }
 
-fn_internal void
-ArenaImplCommit( void* ptr, U64 size )
+fn_internal void*
+ArenaImplReserveEx( U64 size, U32* Flags, U64* Reserved )
 {
-#ifdef _WIN32
-    SYSTEM_INFO info;
-    GetSystemInfo( &info );
-    U64 PageSize = info.dwPageSize;
+    U64 snapped_size = ArenaImplReserveSize( size );
 
-    U64 page_snapped_size = size;
-    page_snapped_size += PageSize - 1;
-    page_snapped_size -= page_snapped_size % PageSize;
+    if( (*Flags & (ARENA_FLAG_HUGE_HINT | ARENA_FLAG_HUGE_EXPLICIT)) == 0 ) {
+        *Reserved = snapped_size;
+        return ArenaImplReserve( size );
+    }
 
-    VirtualAlloc( ptr, page_snapped_size, MEM_COMMIT, PAGE_READWRITE );
+    if( *Flags & ARENA_FLAG_HUGE_EXPLICIT ) {
+#ifdef _WIN32
+        U64 LargePage = GetLargePageMinimum();
+        if( LargePage != 0 ) {
+            U64 large_snapped_size = size + LargePage - 1;
+            large_snapped_size    -= large_snapped_size % LargePage;
+            // Large pages can't be reserved on their own, they come committed
+            //
+            void* ptr = VirtualAlloc( 0, large_snapped_size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE );
+            if( ptr != NULL ) {
+                *Reserved = large_snapped_size;
+                return ptr;
+            }
+        }
+#elif defined(MAP_HUGETLB)
+        U64 huge_snapped_size = size + HUGE_PAGE_SIZE - 1;
+        huge_snapped_size    -= huge_snapped_size % HUGE_PAGE_SIZE;
+        void* ptr = mmap( NULL, huge_snapped_size, PROT_NONE, MAP_PRIVATE | MAP_ANON | MAP_HUGETLB, -1, 0 );
+        if( ptr != MAP_FAILED ) {
+            *Reserved = huge_snapped_size;
+            return ptr;
+        }
+#endif
+        *Flags &= ~ARENA_FLAG_HUGE_EXPLICIT;
+        *Flags |= ARENA_FLAG_HUGE_HINT;
+    }
+
+#ifdef _WIN32
+    // No transparent huge pages on Windows, we only keep the commit granularity
+    //
+    *Reserved = snapped_size;
+    return ArenaImplReserve( size );
 #else
-    U32 PageSize = sysconf(_SC_PAGE_SIZE);
+    // Over-reserve one huge page and trim both ends so the base lands on a
+    // HUGE_PAGE_SIZE boundary, otherwise the kernel can't back the first and
+    // last 2 MiB of every commit with a huge page.
+    //
+    U64 map_size = snapped_size + HUGE_PAGE_SIZE;
+    U8* map      = (U8*)mmap( NULL, map_size, PROT_NONE, MAP_PRIVATE | MAP_ANON, -1, 0 );
+    if( map == (U8*)MAP_FAILED ) {
+        return NULL;
+    }
+
+    U8* ptr  = (U8*)(((uintptr_t)map + HUGE_PAGE_SIZE - 1) & ~((uintptr_t)HUGE_PAGE_SIZE - 1));
+    U64 head = (U64)(ptr - map);
+    U64 tail = map_size - head - snapped_size;
+    if( head > 0 ) {
+        munmap( map, head );
+    }
+    if( tail > 0 ) {
+        munmap( ptr + snapped_size, tail );
+    }
+
+#ifdef MADV_HUGEPAGE
+    madvise( ptr, snapped_size, MADV_HUGEPAGE );
+#endif
+
+    *Reserved = snapped_size;
+    return ptr;
+#endif
+}
+
+// False when the OS refuses to back the range, e.g. the commit limit is hit
+// with overcommit off or RLIMIT_AS is reached. Nothing is usable then.
+//
+fn_internal bool
+ArenaImplCommit( void* ptr, U64 size )
+{
+    U64 PageSize = ArenaImplPageSize();
     U64 page_snapped_size = size;
     page_snapped_size += PageSize - 1;
     page_snapped_size -= page_snapped_size % PageSize;
-    mprotect( ptr, page_snapped_size, PROT_READ | PROT_WRITE);
+#ifdef _WIN32
+    return VirtualAlloc( ptr, page_snapped_size, MEM_COMMIT, PAGE_READWRITE ) != NULL;
+#else
+    return mprotect( ptr, page_snapped_size, PROT_READ | PROT_WRITE) == 0;
 #endif
 }
 
-fn_internal void
+fn_internal bool
 ArenaImplCommitWithFlags(void* ptr, U64 size, U64 MemFlags, U64 PageFlags) {
-#ifdef _WIN32
-  SYSTEM_INFO info;
-  GetSystemInfo( &info );
-  U64 PageSize = info.dwPageSize;
-
+  U64 PageSize = ArenaImplPageSize();
   U64 page_snapped_size = size;
   page_snapped_size += PageSize - 1;
   page_snapped_size -= page_snapped_size % PageSize;
-
-  VirtualAlloc( ptr, page_snapped_size, MemFlags, PageFlags );
+#ifdef _WIN32
+  return VirtualAlloc( ptr, page_snapped_size, MemFlags, PageFlags ) != NULL;
 #else
-  U32 PageSize = sysconf(_SC_PAGE_SIZE);
-  U64 page_snapped_size = size;
-  page_snapped_size += PageSize - 1;
-  page_snapped_size -= page_snapped_size % PageSize;
-  mprotect( ptr, page_snapped_size, MemFlags);
-
+  return mprotect( ptr, page_snapped_size, MemFlags) == 0;
 #endif
 }
 
@@ -168,6 +575,18 @@ ArenaImplDecommit( void* ptr, U64 size )
 #endif
 }
 
+fn_internal void
+ArenaImplLazyFree( void* ptr, U64 size )
+{
+#ifdef _WIN32
+    VirtualAlloc( ptr, size, MEM_RESET, PAGE_READWRITE );
+#elif defined(MADV_FREE)
+    madvise(ptr, size, MADV_FREE);
+#else
+    madvise(ptr, size, MADV_DONTNEED);
+#endif
+}
+
 fn_internal void
 ArenaImplRelease( void* ptr, U64 size )
 {
@@ -178,34 +597,443 @@ ArenaImplRelease( void* ptr, U64 size )
 #endif
 }
 
+// Faults the pages in without waiting for the first write. MADV_POPULATE_WRITE
+// does it in one syscall on Linux 5.14+, otherwise we hint with MADV_WILLNEED
+// and touch every page ourselves.
+//
+fn_internal void
+ArenaImplPrefault( void* ptr, U64 size )
+{
+#if !defined(_WIN32) && defined(MADV_POPULATE_WRITE)
+    if( madvise( ptr, size, MADV_POPULATE_WRITE ) == 0 ) {
+        return;
+    }
+#endif
+#ifndef _WIN32
+    madvise( ptr, size, MADV_WILLNEED );
+#endif
+    U64 PageSize = ArenaImplPageSize();
+    volatile U8* page = (volatile U8*)ptr;
+    for( U64 offset = 0; offset < size; offset += PageSize ) {
+        page[offset] = page[offset];
+    }
+}
+
+// Locks are capped per process, RLIMIT_MEMLOCK on Linux (often 8 MiB) and the
+// minimum working set on Windows. A refused lock raises the cap as far as an
+// unprivileged process can and tries once more.
+//
+fn_internal U32
+ArenaImplLock( void* ptr, U64 size )
+{
+#ifdef _WIN32
+    if( VirtualLock( ptr, size ) ) {
+        return 1;
+    }
+    SIZE_T Min     = 0;
+    SIZE_T Max     = 0;
+    HANDLE Process = GetCurrentProcess();
+    if( GetProcessWorkingSetSize( Process, &Min, &Max ) && SetProcessWorkingSetSize( Process, Min + size, Max + size ) ) {
+        return VirtualLock( ptr, size ) ? 1 : 0;
+    }
+    return 0;
+#else
+    if( mlock( ptr, size ) == 0 ) {
+        return 1;
+    }
+    struct rlimit Limit;
+    if( getrlimit( RLIMIT_MEMLOCK, &Limit ) == 0 && Limit.rlim_cur < Limit.rlim_max ) {
+        Limit.rlim_cur = Limit.rlim_max;
+        if( setrlimit( RLIMIT_MEMLOCK, &Limit ) == 0 ) {
+            return mlock( ptr, size ) == 0 ? 1 : 0;
+        }
+    }
+    return 0;
+#endif
+}
+
+fn_internal void*
+ArenaImplMapFile( const char* Path, U64 size, U64* Mapped, U64* Handle, U64* Mapping )
+{
+#ifdef _WIN32
+    HANDLE File = CreateFileA( Path, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+    if( File == INVALID_HANDLE_VALUE ) {
+        return NULL;
+    }
+
+    LARGE_INTEGER FileSize;
+    GetFileSizeEx( File, &FileSize );
+    if( (U64)FileSize.QuadPart > size ) {
+        size = (U64)FileSize.QuadPart;
+    }
+
+    // Creating the mapping grows the file to size
+    //
+    HANDLE FileMapping = CreateFileMappingA( File, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)(size & 0xFFFFFFFF), NULL );
+    if( FileMapping == NULL ) {
+        CloseHandle( File );
+        return NULL;
+    }
+
+    void* ptr = MapViewOfFile( FileMapping, FILE_MAP_ALL_ACCESS, 0, 0, size );
+    if( ptr == NULL ) {
+        CloseHandle( FileMapping );
+        CloseHandle( File );
+        return NULL;
+    }
+
+    *Mapped  = size;
+    *Handle  = (U64)File;
+    *Mapping = (U64)FileMapping;
+    return ptr;
+#else
+    int Fd = open( Path, O_RDWR | O_CREAT, 0644 );
+    if( Fd < 0 ) {
+        return NULL;
+    }
+
+    struct stat FileStat;
+    if( fstat( Fd, &FileStat ) != 0 ) {
+        close( Fd );
+        return NULL;
+    }
+
+    U64 PageSize = ArenaImplPageSize();
+    if( (U64)FileStat.st_size > size ) {
+        size = (U64)FileStat.st_size;
+    }
+    size += PageSize - 1;
+    size -= size % PageSize;
+
+    // The file stays sparse, blocks are only allocated for the pages we write
+    //
+    if( (U64)FileStat.st_size < size && ftruncate( Fd, (off_t)size ) != 0 ) {
+        close( Fd );
+        return NULL;
+    }
+
+    void* ptr = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0 );
+    if( ptr == MAP_FAILED ) {
+        close( Fd );
+        return NULL;
+    }
+
+    *Mapped  = size;
+    *Handle  = (U64)Fd;
+    *Mapping = 0;
+    return ptr;
+#endif
+}
+
+fn_internal void
+ArenaImplUnmapFile( void* ptr, U64 size, U64 Handle, U64 Mapping )
+{
+#ifdef _WIN32
+    UnmapViewOfFile( ptr );
+    CloseHandle( (HANDLE)Mapping );
+    CloseHandle( (HANDLE)Handle );
+#else
+    munmap( ptr, size );
+    close( (int)Handle );
+#endif
+}
+
+fn_internal arena_policy
+ArenaDefaultPolicy( void )
+{
+    arena_policy Policy      = {0};
+    Policy.CommitMin         = DEFAULT_COMMIT;
+    Policy.CommitMax         = mebibyte(64);
+    Policy.CommitGrowth      = 2;
+    Policy.DecommitDelay     = 60;
+    Policy.DecommitThreshold = ARENA_DECOMMIT_THRESHOLD;
+    Policy.Flags             = 0;
+    return Policy;
+}
+
+fn_internal void
+ArenaSetPolicy( Arena* arena, arena_policy Policy )
+{
+    U64 PageSize = arena->page_size;
+    if( Policy.CommitMin < PageSize ) {
+        Policy.CommitMin = PageSize;
+    }
+    if( Policy.CommitMax < Policy.CommitMin ) {
+        Policy.CommitMax = Policy.CommitMin;
+    }
+    if( Policy.CommitGrowth == 0 ) {
+        Policy.CommitGrowth = 1;
+    }
+    for( Arena* segment = arena->current; segment != NULL; segment = segment->prev ) {
+        segment->policy           = Policy;
+        segment->commit_step      = Policy.CommitMin;
+        segment->decommit_pending = 0;
+    }
+}
+
+fn_internal arena_stats
+ArenaGetStats( Arena* arena )
+{
+    arena_stats Total = {0};
+    for( Arena* segment = arena->current; segment != NULL; segment = segment->prev ) {
+        Total.CommitCalls      += segment->stats.CommitCalls;
+        Total.DecommitCalls    += segment->stats.DecommitCalls;
+        Total.CommitsAvoided   += segment->stats.CommitsAvoided;
+        Total.DecommitsAvoided += segment->stats.DecommitsAvoided;
+        Total.CommitPeak       += segment->stats.CommitPeak;
+        Total.CommitFailures   += segment->stats.CommitFailures;
+    }
+    return Total;
+}
+
+fn_internal void
+ArenaResetStats( Arena* arena )
+{
+    for( Arena* segment = arena->current; segment != NULL; segment = segment->prev ) {
+        U64 CommitPeak = segment->stats.CommitPeak;
+        memset( &segment->stats, 0, sizeof(arena_stats) );
+        segment->stats.CommitPeak = CommitPeak;
+    }
+}
+
 fn_internal Arena*
 ArenaAlloc( U64 size )
 {
-    void* block = ArenaImplReserve( size );
-    ArenaImplCommit( block, DEFAULT_COMMIT );
+    return ArenaAllocEx( size, 0 );
+}
+
+// Reserves and sets up a single segment, NULL if the OS refuses the reservation
+//
+fn_internal Arena*
+ArenaAllocSegment( U64 size, U32 Flags )
+{
+    U64   Reserved = 0;
+    void* block    = ArenaImplReserveEx( size, &Flags, &Reserved );
+    if( block == NULL ) {
+        return NULL;
+    }
+
+    U64 PageSize = DEFAULT_COMMIT;
+    if( Flags & (ARENA_FLAG_HUGE_HINT | ARENA_FLAG_HUGE_EXPLICIT) ) {
+        PageSize = HUGE_PAGE_SIZE;
+    }
+
+    if( !ArenaImplCommit( block, PageSize ) ) {
+        ArenaImplRelease( block, Reserved );
+        return NULL;
+    }
     Arena* arena      = (Arena*)block;
     arena->pos        = sizeof( Arena );
-    arena->commit_pos = DEFAULT_COMMIT;
+    arena->commit_pos = PageSize;
     arena->size       = size;
+    arena->reserved   = Reserved;
+    arena->page_size  = PageSize;
+    arena->flags      = Flags;
+    arena->current    = arena;
+    arena->high_water    = arena->pos;
+    arena->lazy_free_pos = arena->commit_pos;
+    ArenaSetPolicy( arena, ArenaDefaultPolicy() );
+    arena->stats.CommitCalls = 1;
+    arena->stats.CommitPeak  = arena->commit_pos;
 
     return arena;
 }
 
 fn_internal Arena*
-ArenaAllocDefault( void )
+ArenaAllocEx( U64 size, U32 Flags )
 {
-    void* block = ArenaImplReserve( DEFAULT_RESERVE );
-    ArenaImplCommit( block, DEFAULT_COMMIT );
-    Arena* arena      = (Arena*)block;
-    arena->pos        = sizeof( Arena );
-    arena->commit_pos = DEFAULT_COMMIT;
-    arena->size       = DEFAULT_RESERVE;
+    U32 SegmentFlags = Flags & ~ARENA_FLAG_CHAINED;
+
+    if( (Flags & ARENA_FLAG_CHAINED) == 0 ) {
+        Arena* arena = ArenaAllocSegment( size, SegmentFlags );
+        if( arena != NULL ) {
+            return arena;
+        }
+        // Couldn't reserve it in one piece, reserve small and grow on demand
+        //
+        if( size > ARENA_SEGMENT_RESERVE ) {
+            size = ARENA_SEGMENT_RESERVE;
+        }
+    }
 
+    Arena* arena = ArenaAllocSegment( size, SegmentFlags );
+    if( arena != NULL ) {
+        arena->flags       |= ARENA_FLAG_CHAINED;
+        arena->segment_size = size;
+    }
     return arena;
 }
 
+fn_internal Arena*
+ArenaAllocFile( const char* Path, U64 size )
+{
+    U64   Mapped  = 0;
+    U64   Handle  = 0;
+    U64   Mapping = 0;
+    void* block   = ArenaImplMapFile( Path, size, &Mapped, &Handle, &Mapping );
+    if( block == NULL ) {
+        return NULL;
+    }
+
+    Arena* arena = (Arena*)block;
+    if( arena->file_magic != ARENA_FILE_MAGIC + sizeof(Arena) || arena->pos < sizeof(Arena) || arena->pos > Mapped ) {
+        memset( arena, 0, sizeof(Arena) );
+        arena->pos        = sizeof( Arena );
+        arena->file_magic = ARENA_FILE_MAGIC + sizeof(Arena);
+        arena->policy     = ArenaDefaultPolicy();
+    }
+
+    // Everything that holds an address is from the run that wrote the file
+    //
+    arena->current      = arena;
+    arena->prev         = NULL;
+    arena->spare        = NULL;
+    arena->base_pos     = 0;
+    arena->segment_size = 0;
+
+    arena->size          = Mapped;
+    arena->reserved      = Mapped;
+    arena->page_size     = ArenaImplPageSize();
+    arena->commit_pos    = Mapped;
+    arena->lazy_free_pos = Mapped;
+    arena->high_water    = arena->pos;
+    arena->flags         = ARENA_FLAG_FILE;
+    arena->file_handle   = Handle;
+    arena->file_mapping  = Mapping;
+    memset( &arena->stats, 0, sizeof(arena_stats) );
+
+    return arena;
+}
+
+fn_internal void
+ArenaFlush( Arena* arena )
+{
+    if( arena->flags & ARENA_FLAG_FILE ) {
+#ifdef _WIN32
+        FlushViewOfFile( arena, arena->pos );
+        FlushFileBuffers( (HANDLE)arena->file_handle );
+#else
+        msync( arena, arena->pos, MS_SYNC );
+#endif
+    }
+}
+
+fn_internal arena_offset
+ArenaOffset( Arena* arena, void* ptr )
+{
+    if( ptr == NULL ) {
+        return 0;
+    }
+    return (arena_offset)((U8*)ptr - (U8*)arena);
+}
+
 fn_internal void*
-ArenaPush( Arena* arena, U64 size )
+ArenaFromOffset( Arena* arena, arena_offset offset )
+{
+    if( offset == 0 ) {
+        return NULL;
+    }
+    // Offsets only point at what was pushed, anything past pos is a stale or
+    // corrupt offset read back from the file
+    //
+    assert( offset < arena->pos && "Arena offset past the end of the arena" );
+    return (U8*)arena + offset;
+}
+
+fn_internal void
+ArenaSetRoot( Arena* arena, void* ptr )
+{
+    arena->root = ArenaOffset( arena, ptr );
+}
+
+fn_internal void*
+ArenaGetRoot( Arena* arena )
+{
+    return ArenaFromOffset( arena, arena->root );
+}
+
+fn_internal U64
+ArenaPos( Arena* arena )
+{
+    Arena* current = arena->current;
+    return current->base_pos + current->pos;
+}
+
+fn_internal Arena*
+ArenaAllocDefault( void )
+{
+    return ArenaAlloc( DEFAULT_RESERVE );
+}
+
+// Makes sure [0, new_pos) is committed. Commits grow geometrically following the
+// arena policy so a steadily growing arena does O(log n) commits instead of one
+// per page. When the OS refuses the whole step only what new_pos needs is tried
+// again, false if even that fails and commit_pos is left where it was.
+//
+fn_internal bool
+ArenaCommitUpTo( Arena* arena, U64 old_pos, U64 new_pos, U32 UseFlags, U64 MemFlags, U64 PageFlags )
+{
+    U8* base     = (U8*)arena;
+    U64 PageSize = arena->page_size;
+
+    if( new_pos <= arena->commit_pos ) {
+        // Count the pages the old 4 KiB scheme would have had to commit again
+        //
+        if( (new_pos + PageSize - 1) / PageSize > (old_pos + PageSize - 1) / PageSize ) {
+            arena->stats.CommitsAvoided += 1;
+        }
+        if( new_pos > arena->lazy_free_pos ) {
+            arena->lazy_free_pos = new_pos;
+        }
+        return true;
+    }
+
+    U64 to_commit = new_pos - arena->commit_pos;
+    if( to_commit < arena->commit_step ) {
+        to_commit = arena->commit_step;
+    }
+    to_commit += PageSize - 1;
+    to_commit -= to_commit % PageSize;
+
+    U64 size_snapped = arena->size + PageSize - 1;
+    size_snapped    -= size_snapped % PageSize;
+    if( arena->commit_pos + to_commit > size_snapped ) {
+        to_commit = size_snapped - arena->commit_pos;
+    }
+
+    U64 needed = new_pos - arena->commit_pos + PageSize - 1;
+    needed    -= needed % PageSize;
+
+    bool Committed = false;
+    for( ;; ) {
+        if( UseFlags ) {
+            Committed = ArenaImplCommitWithFlags( base + arena->commit_pos, to_commit, MemFlags, PageFlags );
+        } else {
+            Committed = ArenaImplCommit( base + arena->commit_pos, to_commit );
+        }
+        if( Committed || to_commit <= needed ) {
+            break;
+        }
+        to_commit = needed;
+    }
+    if( !Committed ) {
+        arena->stats.CommitFailures += 1;
+        return false;
+    }
+    arena->commit_pos   += to_commit;
+    arena->lazy_free_pos = arena->commit_pos;
+    arena->stats.CommitCalls += 1;
+    if( arena->commit_pos > arena->stats.CommitPeak ) {
+        arena->stats.CommitPeak = arena->commit_pos;
+    }
+
+    U64 next_step = arena->commit_step * arena->policy.CommitGrowth;
+    arena->commit_step = next_step > arena->policy.CommitMax ? arena->policy.CommitMax : next_step;
+    return true;
+}
+
+fn_internal void*
+ArenaPushLocal( Arena* arena, U64 size, U32 UseFlags, U64 MemFlags, U64 PageFlags )
 {
     uint8_t *base = (uint8_t *)arena;
 
@@ -215,105 +1043,297 @@ ArenaPush( Arena* arena, U64 size )
     if (aligned_pos + size > arena->size)
         return NULL;                    // out of memory
 
+    U64 old_pos      = arena->pos;
     void *result     = base + aligned_pos;
+
+    // Reserved but not committable, handled like running out of space so a
+    // chained arena moves to a new segment
+    //
+    if( !ArenaCommitUpTo( arena, old_pos, aligned_pos + size, UseFlags, MemFlags, PageFlags ) ) {
+        return NULL;
+    }
     arena->pos       = aligned_pos + size;
 
-    /* commit pages as you already do … */
-    if (arena->commit_pos < arena->pos) {
-        U64 to_commit = arena->pos - arena->commit_pos;
-        to_commit    += DEFAULT_COMMIT - 1;
-        to_commit    -= to_commit % DEFAULT_COMMIT;
-        ArenaImplCommit(base + arena->commit_pos, to_commit);
-        arena->commit_pos += to_commit;
+    if( arena->pos > arena->high_water ) {
+        arena->high_water = arena->pos;
+    }
+
+    return result;
+}
+
+// Puts a segment big enough for a push of size on top of the chain. Reuses the
+// spare segment when it fits.
+//
+fn_internal Arena*
+ArenaGrowChain( Arena* arena, U64 size )
+{
+    U64 needed = size + sizeof( Arena ) + _Alignof(max_align_t);
+
+    Arena* segment = arena->spare;
+    if( segment != NULL && segment->size >= needed ) {
+        arena->spare = NULL;
+    } else {
+        U64 reserve = arena->segment_size > needed ? arena->segment_size : needed;
+        segment = ArenaAllocSegment( reserve, arena->flags & ~ARENA_FLAG_CHAINED );
+        if( segment == NULL ) {
+            return NULL;
+        }
+        segment->policy      = arena->policy;
+        segment->commit_step = arena->policy.CommitMin;
+    }
+
+    segment->base_pos = arena->current->base_pos + arena->current->size;
+    segment->prev     = arena->current;
+    arena->current    = segment;
+
+    return segment;
+}
+
+fn_internal void*
+ArenaPushImpl( Arena* arena, U64 size, U32 UseFlags, U64 MemFlags, U64 PageFlags )
+{
+    void* result = ArenaPushLocal( arena->current, size, UseFlags, MemFlags, PageFlags );
+
+    if( result == NULL && (arena->flags & ARENA_FLAG_CHAINED) ) {
+        Arena* segment = ArenaGrowChain( arena, size );
+        if( segment != NULL ) {
+            result = ArenaPushLocal( segment, size, UseFlags, MemFlags, PageFlags );
+        }
+    }
+
+    if( result != NULL ) {
+        AllocTraceEmit( ALLOC_TRACE_ALLOC, ALLOC_TRACE_SOURCE_ARENA, result, size, _Alignof(max_align_t) );
     }
 
     return result;
 }
 
+fn_internal void*
+ArenaPush( Arena* arena, U64 size )
+{
+    return ArenaPushImpl( arena, size, 0, 0, 0 );
+}
+
 fn_internal void*
 ArenaPushWithFlags( Arena* arena, U64 size, U64 MemFlags, U64 PageFlags )
 {
-  uint8_t *base = (uint8_t *)arena;
+    return ArenaPushImpl( arena, size, 1, MemFlags, PageFlags );
+}
+
+// Only the first refused lock is reported, every caller falls back the same way
+//
+static bool ArenaLockRefused;
+
+fn_internal U32
+ArenaPrefaultRange( void* ptr, U64 size, U32 Flags )
+{
+    U64 PageSize = ArenaImplPageSize();
+    U8* start    = (U8*)((uintptr_t)ptr & ~((uintptr_t)PageSize - 1));
+    size        += (U64)((U8*)ptr - start);
+
+    if( Flags & ARENA_PREFAULT_LOCK ) {
+        // mlock faults the pages in by itself
+        //
+        if( ArenaImplLock( start, size ) ) {
+            return 1;
+        }
+        // Still faulted in, only no longer safe from being paged out
+        //
+        if( !ArenaLockRefused ) {
+            ArenaLockRefused = true;
+            fprintf( stderr, "[WARNING] Could not lock %llu KiB, the memory is only prefaulted (raise the limit with ulimit -l)\n",
+                     (unsigned long long)(size >> 10) );
+        }
+        ArenaImplPrefault( start, size );
+        return 0;
+    }
+
+    ArenaImplPrefault( start, size );
+    return 1;
+}
+
+fn_internal U32
+ArenaPrefault( Arena* arena, U64 bytes, U32 Flags )
+{
+    Arena* current = arena->current;
+    U64 start      = current->pos;
+    U64 end        = start + bytes;
+    if( end > current->size ) {
+        end = current->size;
+    }
+    if( end <= start ) {
+        return 1;
+    }
+
+    // A refused commit leaves less to prefault, only what is committed is touched
+    //
+    ArenaCommitUpTo( current, start, end, 0, 0, 0 );
+
+    U64 PageSize = current->page_size;
+    end += PageSize - 1;
+    end -= end % PageSize;
+    if( end > current->commit_pos ) {
+        end = current->commit_pos;
+    }
+    if( end <= start ) {
+        return 1;
+    }
+    if( end > current->prefault_pos ) {
+        current->prefault_pos = end;
+    }
+
+    return ArenaPrefaultRange( (U8*)current + start, end - start, Flags );
+}
+
+static volatile U64 ArenaFrameIndex;
+
+fn_internal void
+ArenaFrameBegin( void )
+{
+    ArenaFrameIndex += 1;
+}
 
-  /* align pos up to max_align_t boundary */
-  U64 aligned_pos = (arena->pos + _Alignof(max_align_t) - 1) & ~(_Alignof(max_align_t) - 1);
+// Decides whether the committed slack above pos is given back. Slack that the
+// last push/pop cycle reached again counts as in use, so frame-sized cycles
+// never decommit. Slack that stays unused for DecommitDelay frames is released
+// down to high water + DecommitThreshold. Only the first pop of a frame that
+// leaves it unused counts, the small scratches a frame pops after one big
+// cycle would otherwise use up the delay in a single frame.
+//
+fn_internal void
+ArenaDecommitPolicy( Arena* arena )
+{
+    U64 PageSize = arena->page_size;
+    U64 keep_pos = (arena->high_water > arena->pos ? arena->high_water : arena->pos);
+    keep_pos    += arena->policy.DecommitThreshold + PageSize - 1;
+    keep_pos    -= keep_pos % PageSize;
+    if( keep_pos < arena->prefault_pos ) {
+        keep_pos = arena->prefault_pos;
+    }
 
-  if (aligned_pos + size > arena->size)
-    return NULL;                    // out of memory
+    U64 slack_end = arena->commit_pos;
+    if( arena->policy.Flags & ARENA_POLICY_LAZY_FREE ) {
+        slack_end = arena->lazy_free_pos;
+    }
+
+    if( keep_pos >= slack_end ) {
+        // Everything committed is within the reused range
+        //
+        if( arena->commit_pos - arena->pos >= PageSize ) {
+            arena->stats.DecommitsAvoided += 1;
+        }
+        arena->decommit_pending = 0;
+        arena->high_water       = arena->pos;
+        return;
+    }
 
-  void *result     = base + aligned_pos;
-  arena->pos       = aligned_pos + size;
+    U64 Frame = ArenaFrameIndex;
+    if( Frame == 0 || arena->decommit_frame != Frame ) {
+        arena->decommit_pending += 1;
+        arena->decommit_frame    = Frame;
+    }
+    if( arena->decommit_pending < arena->policy.DecommitDelay ) {
+        arena->stats.DecommitsAvoided += 1;
+        arena->high_water = arena->pos;
+        return;
+    }
 
-  /* commit pages as you already do … */
-  if (arena->commit_pos < arena->pos) {
-    U64 to_commit = arena->pos - arena->commit_pos;
-    to_commit    += DEFAULT_COMMIT - 1;
-    to_commit    -= to_commit % DEFAULT_COMMIT;
-    ArenaImplCommitWithFlags(base + arena->commit_pos, to_commit, MemFlags, PageFlags);
-    arena->commit_pos += to_commit;
-  }
+    // Dropping pages of a shared file mapping would only make us read them back
+    //
+    if( arena->flags & ARENA_FLAG_FILE ) {
+        arena->decommit_pending = 0;
+        arena->high_water       = arena->pos;
+        return;
+    }
 
-  return result;
+    U8* base = (U8*)arena;
+    if( arena->policy.Flags & ARENA_POLICY_LAZY_FREE ) {
+        ArenaImplLazyFree( base + keep_pos, slack_end - keep_pos );
+        arena->lazy_free_pos = keep_pos;
+    } else {
+        ArenaImplDecommit( base + keep_pos, arena->commit_pos - keep_pos );
+        arena->commit_pos    = keep_pos;
+        arena->lazy_free_pos = keep_pos;
+        arena->commit_step   = arena->policy.CommitMin;
+    }
+    arena->stats.DecommitCalls += 1;
+    arena->decommit_pending     = 0;
+    arena->high_water           = arena->pos;
 }
 
 fn_internal void
-ArenaPopTo(Arena *arena, U64 pos)
+ArenaPopToLocal(Arena *arena, U64 pos)
 {
- U64 min_pos = sizeof(Arena);
- U64 new_pos = Max(min_pos, pos);
- arena->pos = new_pos;
- U64 pos_aligned_to_commit_chunks = arena->pos + DEFAULT_COMMIT-1;
- pos_aligned_to_commit_chunks -= pos_aligned_to_commit_chunks%DEFAULT_COMMIT;
- if(pos_aligned_to_commit_chunks + ARENA_DECOMMIT_THRESHOLD <= arena->commit_pos)
- {
-  U8 *base = (U8 *)arena;
-  U64 size_to_decommit = arena->commit_pos-pos_aligned_to_commit_chunks;
-  ArenaImplDecommit(base + pos_aligned_to_commit_chunks, size_to_decommit);
-  arena->commit_pos -= size_to_decommit;
- }
+    U64 min_pos = sizeof(Arena);
+    U64 new_pos = Max(min_pos, pos);
+    if( new_pos < arena->pos ) {
+        AllocTraceEmit( ALLOC_TRACE_FREE_RANGE, ALLOC_TRACE_SOURCE_ARENA, (U8*)arena + new_pos, arena->pos - new_pos, 0 );
+    }
+    arena->pos  = new_pos;
+    ArenaDecommitPolicy(arena);
 }
 
+fn_internal void
+ArenaPopTo(Arena *arena, U64 pos)
+{
+    // Drop every segment that starts above pos, the lowest one dropped is kept
+    // as spare so a frame that keeps crossing the same boundary doesn't
+    // reserve and release a segment every time.
+    //
+    Arena* current = arena->current;
+    while( current->prev != NULL && pos < current->base_pos + sizeof(Arena) ) {
+        Arena* prev = current->prev;
+        if( arena->spare != NULL ) {
+            ArenaImplRelease( arena->spare, arena->spare->reserved );
+        }
+        ArenaPopToLocal( current, sizeof(Arena) );
+        current->prev = NULL;
+        arena->spare  = current;
+        current       = prev;
+    }
+    arena->current = current;
+
+    U64 local_pos = pos > current->base_pos ? pos - current->base_pos : 0;
+    ArenaPopToLocal( current, local_pos );
+}
 
 fn_internal void
 ArenaPop( Arena* arena, U64 erase  )
 {
-    /*
     U64 min_pos = sizeof( Arena );
-    U64 to_pop  = Min( erase, arena->pos );
-    U64 new_pos = arena->pos - to_pop;
-    new_pos     = Max( min_pos, erase );
-
-    arena->pos -= new_pos;
-    */
-
-    arena->pos -= erase;
-
-    U64 decommit_file_size = erase;
-    decommit_file_size += DEFAULT_DECOMMIT;
-    decommit_file_size  -= decommit_file_size % DEFAULT_DECOMMIT;
-    decommit_file_size  -= DEFAULT_DECOMMIT;
-    // Now we have that we are going to decommit the proportional part
-    // in page sizes. However, if the erasing size given by the user
-    // is not n * DEFAULT_COMMIT, we will not be able to decommit everything,
-    // because if we do it, we will be erasing other data that we still want
-    // to use in that page
-    //
-    arena->commit_pos -= decommit_file_size;
-    // NOTE: Maybe we want to put a threshold different to 4 Kib when we want
-    // to decommit. I have to research.
-    ArenaImplDecommit( (char*)arena + arena->commit_pos, decommit_file_size );
+    U64 pos     = ArenaPos( arena );
+    U64 to_pop  = pos - min_pos;
+    if( erase < to_pop ) {
+        to_pop = erase;
+    }
+    ArenaPopTo( arena, pos - to_pop );
 }
 
 fn_internal void
 ArenaRelease( Arena* arena )
 {
-    ArenaImplRelease( arena, arena->size );
+    Arena* segment = arena->current;
+    while( segment != arena ) {
+        Arena* prev = segment->prev;
+        AllocTraceEmit( ALLOC_TRACE_FREE_RANGE, ALLOC_TRACE_SOURCE_ARENA, segment, segment->pos, 0 );
+        ArenaImplRelease( segment, segment->reserved );
+        segment = prev;
+    }
+    if( arena->spare != NULL ) {
+        ArenaImplRelease( arena->spare, arena->spare->reserved );
+    }
+    AllocTraceEmit( ALLOC_TRACE_FREE_RANGE, ALLOC_TRACE_SOURCE_ARENA, arena, arena->pos, 0 );
+    if( arena->flags & ARENA_FLAG_FILE ) {
+        ArenaImplUnmapFile( arena, arena->reserved, arena->file_handle, arena->file_mapping );
+        return;
+    }
+    ArenaImplRelease( arena, arena->reserved );
 }
 
 fn_internal void
 ArenaClear( Arena* arena )
 {
-    ArenaPop( arena, arena->pos );
+    ArenaPopTo( arena, sizeof( Arena ) );
 }
 
 
@@ -322,7 +1342,7 @@ TempBegin(Arena *arena)
 {
  Temp temp  = {0};
  temp.arena = arena;
- temp.pos   = arena->pos;
+ temp.pos   = ArenaPos(arena);
  return temp;
 }
 
@@ -332,4 +1352,264 @@ TempEnd(Temp temp)
  ArenaPopTo(temp.arena, temp.pos);
 }
 
+typedef struct scratch_pool scratch_pool;
+struct scratch_pool
+{
+    Arena* Arenas[SCRATCH_ARENA_COUNT];
+};
+
+// Every thread owns its own pool, so GetScratch never needs a lock
+//
+thread_static scratch_pool ScratchPool;
+
+fn_internal Temp
+GetScratch( Arena** Conflicts, U64 ConflictCount )
+{
+    Temp Scratch = {0};
+
+    if( ScratchPool.Arenas[0] == NULL ) {
+        for( U32 i = 0; i < SCRATCH_ARENA_COUNT; i += 1 ) {
+            ScratchPool.Arenas[i] = ArenaAlloc( SCRATCH_ARENA_RESERVE );
+        }
+    }
+
+    for( U32 i = 0; i < SCRATCH_ARENA_COUNT; i += 1 ) {
+        Arena* Candidate = ScratchPool.Arenas[i];
+        U32 IsConflict = 0;
+        for( U64 c = 0; c < ConflictCount; c += 1 ) {
+            if( Conflicts[c] == Candidate ) {
+                IsConflict = 1;
+                break;
+            }
+        }
+        if( !IsConflict ) {
+            Scratch = TempBegin( Candidate );
+            break;
+        }
+    }
+
+    assert( Scratch.arena != NULL && "Every scratch arena is in use, raise SCRATCH_ARENA_COUNT" );
+
+    return Scratch;
+}
+
+fn_internal arena_stats
+ScratchPoolGetStats( void )
+{
+    arena_stats Total = {0};
+    for( U32 i = 0; i < SCRATCH_ARENA_COUNT; i += 1 ) {
+        if( ScratchPool.Arenas[i] != NULL ) {
+            arena_stats Stats = ArenaGetStats( ScratchPool.Arenas[i] );
+            Total.CommitCalls      += Stats.CommitCalls;
+            Total.DecommitCalls    += Stats.DecommitCalls;
+            Total.CommitsAvoided   += Stats.CommitsAvoided;
+            Total.DecommitsAvoided += Stats.DecommitsAvoided;
+            Total.CommitPeak       += Stats.CommitPeak;
+        }
+    }
+    return Total;
+}
+
+fn_internal void
+ScratchPoolRelease( void )
+{
+    for( U32 i = 0; i < SCRATCH_ARENA_COUNT; i += 1 ) {
+        if( ScratchPool.Arenas[i] != NULL ) {
+            ArenaRelease( ScratchPool.Arenas[i] );
+            ScratchPool.Arenas[i] = NULL;
+        }
+    }
+}
+
+// ------------------------------------------------------------------------ //
+// Concurrent arena
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+fn_internal U64
+ArenaAtomicAdd( volatile U64* Value, U64 Add )
+{
+#ifdef _MSC_VER
+    return (U64)_InterlockedExchangeAdd64( (volatile long long*)Value, (long long)Add );
+#else
+    return __atomic_fetch_add( Value, Add, __ATOMIC_RELAXED );
+#endif
+}
+
+fn_internal U64
+ArenaAtomicLoad( volatile U64* Value )
+{
+#ifdef _MSC_VER
+    return (U64)_InterlockedOr64( (volatile long long*)Value, 0 );
+#else
+    return __atomic_load_n( Value, __ATOMIC_ACQUIRE );
+#endif
+}
+
+// On failure Expected gets the current value
+//
+fn_internal U32
+ArenaAtomicCas( volatile U64* Value, U64* Expected, U64 Desired )
+{
+#ifdef _MSC_VER
+    U64 Old = (U64)_InterlockedCompareExchange64( (volatile long long*)Value, (long long)Desired, (long long)*Expected );
+    if( Old == *Expected ) {
+        return 1;
+    }
+    *Expected = Old;
+    return 0;
+#else
+    return __atomic_compare_exchange_n( Value, Expected, Desired, 0, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE );
+#endif
+}
+
+static volatile U64 ConcurrentArenaGenerations = 0;
+
+typedef struct concurrent_arena_chunk concurrent_arena_chunk;
+struct concurrent_arena_chunk
+{
+    ConcurrentArena* arena;
+    U64              generation;
+    U64              pos;
+    U64              end;
+};
+
+thread_static concurrent_arena_chunk ConcurrentArenaChunks[CONCURRENT_ARENA_THREAD_SLOTS];
+thread_static U32                    ConcurrentArenaNextSlot;
+
+fn_internal ConcurrentArena*
+ConcurrentArenaAlloc( U64 size, U64 ChunkSize )
+{
+    U64 Reserved = ArenaImplReserveSize( size );
+    U8* base     = (U8*)ArenaImplReserve( size );
+    if( base == NULL ) {
+        return NULL;
+    }
+
+    U64 PageSize = ArenaImplPageSize();
+    U64 header   = (sizeof( ConcurrentArena ) + PageSize - 1) & ~(PageSize - 1);
+    if( !ArenaImplCommit( base, header ) ) {
+        ArenaImplRelease( base, Reserved );
+        return NULL;
+    }
+
+    ConcurrentArena* arena = (ConcurrentArena*)base;
+    memset( arena, 0, sizeof( ConcurrentArena ) );
+    arena->base        = base;
+    arena->reserved    = Reserved;
+    arena->commit_step = ChunkSize * CONCURRENT_ARENA_THREAD_SLOTS > kibibyte( 64 ) ? ChunkSize * CONCURRENT_ARENA_THREAD_SLOTS : kibibyte( 64 );
+    arena->chunk_size  = (ChunkSize + _Alignof(max_align_t) - 1) & ~(U64)(_Alignof(max_align_t) - 1);
+    arena->generation  = ArenaAtomicAdd( &ConcurrentArenaGenerations, 1 ) + 1;
+    arena->pos         = sizeof( ConcurrentArena );
+    arena->commit_pos  = header;
+
+    return arena;
+}
+
+// Commits may overlap when two threads cross commit_pos together, committing a
+// committed page is harmless. What matters is that commit_pos is only published
+// after the pages below it are usable. False when the OS refuses the pages.
+//
+fn_internal bool
+ConcurrentArenaCommitTo( ConcurrentArena* arena, U64 end )
+{
+    U64 committed = ArenaAtomicLoad( &arena->commit_pos );
+    while( end > committed ) {
+        U64 target = end + arena->commit_step - 1;
+        target    -= target % arena->commit_step;
+        if( target > arena->reserved ) {
+            target = arena->reserved;
+        }
+        if( !ArenaImplCommit( arena->base + committed, target - committed ) ) {
+            return false;
+        }
+        if( ArenaAtomicCas( &arena->commit_pos, &committed, target ) ) {
+            break;
+        }
+    }
+    return true;
+}
+
+// Returns the offset of size fresh bytes, 0 when the reservation is exhausted
+// or its pages can't be committed
+//
+fn_internal U64
+ConcurrentArenaClaim( ConcurrentArena* arena, U64 size )
+{
+    U64 start = ArenaAtomicAdd( &arena->pos, size );
+    U64 end   = start + size;
+    if( end > arena->reserved || !ConcurrentArenaCommitTo( arena, end ) ) {
+        return 0;
+    }
+    return start;
+}
+
+fn_internal concurrent_arena_chunk*
+ConcurrentArenaThreadChunk( ConcurrentArena* arena )
+{
+    U64 generation = ArenaAtomicLoad( &arena->generation );
+    for( U32 i = 0; i < CONCURRENT_ARENA_THREAD_SLOTS; i += 1 ) {
+        concurrent_arena_chunk* chunk = &ConcurrentArenaChunks[i];
+        if( chunk->arena == arena && chunk->generation == generation ) {
+            return chunk;
+        }
+    }
+
+    // Take a slot round robin, the rest of whatever chunk was there is lost
+    //
+    concurrent_arena_chunk* chunk = &ConcurrentArenaChunks[ConcurrentArenaNextSlot];
+    ConcurrentArenaNextSlot = (ConcurrentArenaNextSlot + 1) % CONCURRENT_ARENA_THREAD_SLOTS;
+    chunk->arena      = arena;
+    chunk->generation = generation;
+    chunk->pos        = 0;
+    chunk->end        = 0;
+    return chunk;
+}
+
+fn_internal void*
+ConcurrentArenaPush( ConcurrentArena* arena, U64 size )
+{
+    size = (size + _Alignof(max_align_t) - 1) & ~(U64)(_Alignof(max_align_t) - 1);
+
+    if( arena->chunk_size != 0 && size <= arena->chunk_size / 8 ) {
+        concurrent_arena_chunk* chunk = ConcurrentArenaThreadChunk( arena );
+        if( chunk->pos + size > chunk->end ) {
+            U64 start = ConcurrentArenaClaim( arena, arena->chunk_size );
+            if( start == 0 ) {
+                return NULL;
+            }
+            chunk->pos = start;
+            chunk->end = start + arena->chunk_size;
+        }
+        void* result = arena->base + chunk->pos;
+        chunk->pos  += size;
+        return result;
+    }
+
+    U64 start = ConcurrentArenaClaim( arena, size );
+    return start ? arena->base + start : NULL;
+}
+
+fn_internal U64
+ConcurrentArenaPos( ConcurrentArena* arena )
+{
+    U64 pos = ArenaAtomicLoad( &arena->pos );
+    return pos < arena->reserved ? pos : arena->reserved;
+}
+
+fn_internal void
+ConcurrentArenaClear( ConcurrentArena* arena )
+{
+    arena->generation = ArenaAtomicAdd( &ConcurrentArenaGenerations, 1 ) + 1;
+    arena->pos        = sizeof( ConcurrentArena );
+}
+
+fn_internal void
+ConcurrentArenaRelease( ConcurrentArena* arena )
+{
+    ArenaImplRelease( arena->base, arena->reserved );
+}
+
 #endif
@@ -43,6 +43,42 @@
 #define MAX_STACK_SIZE  64
 #define MAX_LAYOUT_SIZE 256
 
+// Tags for widgets that only exist once per parent, combined with the parent id
+//
+#define UI_ID_SCROLLBAR_VIEW 0x5343524F4C4C5649ull // "SCROLLVI"
+#define UI_ID_SCROLLBAR_END  0x5343524F4C4C454Eull // "SCROLLEN"
+
+// Head of the temp allocator that UI_Init pins in memory. The temp allocator is
+// reset every frame, so this is the part every frame touches.
+//
+#ifndef UI_TEMP_LOCKED_SIZE
+#define UI_TEMP_LOCKED_SIZE mebibyte(16)
+#endif
+
+// ui_objects the object pool grows by at a time
+//
+#ifndef UI_OBJECT_POOL_CHUNK
+#define UI_OBJECT_POOL_CHUNK 512
+#endif
+
+// Frames an object can go without being built before UI_Begin gives it back to
+// the object pool. Objects with UI_SetPosPersistent are kept forever
+//
+#ifndef UI_OBJECT_RETIRE_FRAMES
+#define UI_OBJECT_RETIRE_FRAMES 120
+#endif
+
+// Address space for the heap of long labels that change, and what it commits
+// at a time
+//
+#ifndef UI_TEXT_HEAP_RESERVE
+#define UI_TEXT_HEAP_RESERVE gigabyte(1)
+#endif
+
+#ifndef UI_TEXT_HEAP_POOL
+#define UI_TEXT_HEAP_POOL kibibyte(256)
+#endif
+
 typedef enum ui_lay_opt {
     UI_AlignRight  = (1 << 0),
     UI_AlignCenter = (1 << 1),
@@ -179,7 +215,16 @@ struct ui_object {
     union {
         struct {
             rect_2d   Rect;
-            U8_String Text;
+            // Short labels are inline, longer ones borrow their text from
+            // ui_context's Strings or from OwnedText
+            //
+            sso_string Text;
+            // Contents of a UI_InputText while it has focus. Losing focus
+            // copies them back into Text and releases the buffer, Edited
+            // keeps the label from being copied over them after that
+            //
+            gap_buffer* Input;
+            bool      Edited;
             vec2      Pos;
             vec2      Size;
             i32       TextCursorIdx;
@@ -208,6 +253,17 @@ struct ui_object {
     ui_object* Right;
     ui_object* FirstSon;
     ui_object* Last;
+
+    // Every object taken from ui_context's ObjectPool, and the last frame
+    // this one was built in
+    //
+    ui_object* NextPooled;
+    u64        BuiltFrame;
+
+    // Long text that changed after the first one, from ui_context's
+    // TextHeap. Reused while it fits and freed when the object retires
+    //
+    u8* OwnedText;
 };
 
 ui_object UI_NULL_OBJECT;
@@ -233,6 +289,16 @@ struct ui_theme_stack {
     object_theme Items[MAX_STACK_SIZE];
 };
 
+// Ids pushed with UI_PushId. Every entry is already combined with the one
+// below it, so the front is the only one a widget needs.
+//
+typedef struct ui_id_stack ui_id_stack;
+struct ui_id_stack {
+    u32 N;
+    u32 Current;
+    u64 Items[MAX_STACK_SIZE];
+};
+
 typedef struct ui_layout_stack ui_layout_stack;
 struct ui_layout_stack {
     u32 N;
@@ -247,6 +313,7 @@ struct ui_context {
     ui_layout_stack Layouts;
     ui_object       FreeList;
     ui_theme_stack  Themes;
+    ui_id_stack     Ids;
 
 	ui_object RootObject;
     ui_object* CurrentParent;
@@ -269,11 +336,27 @@ struct ui_context {
     ui_input CursorAction;
 
     U8_String TextInput;
+    // Clipboard text pasted this frame, it goes straight into the focused
+    // input so it isn't bound by TextInput's size
+    //
+    const char* PasteText;
 
     ui_input LastInput;
 
     Stack_Allocator* Allocator;
     Stack_Allocator* TempAllocator;
+    Pool_Allocator   ObjectPool;
+    ui_object*       Pooled;
+    u64              Frame;
+
+    // Text of the labels that do not fit inline, each distinct one stored
+    // once. Only the first text of an object is interned, later changes go
+    // to its OwnedText in TextHeap so a label that changes every frame does
+    // not add a string per frame
+    //
+    intern_pool    Strings;
+    Arena*         TextArena;
+    Tlsf_Allocator TextHeap;
 
 	vec4 IconsUvCoords[Icon_Details + 1];
 };
@@ -302,15 +385,46 @@ fn_internal ui_object* UI_BuildObjectWithParent(
 	ui_object* Parent
 );
 
+// Same as UI_BuildObjectWithParent with the id already hashed, see UI_Id
+//
+fn_internal ui_object* UI_BuildObjectWithId(
+	ui_context* Context,
+	hash_key Key,
+	const u8* Text,
+	rect_2d Rect,
+	ui_lay_opt Options,
+	ui_object* Parent
+);
+
+// Widget ids are the key hashed with the parent id as seed, plus whatever is
+// on the id stack. Keys that are not strings (loop indices, pointers, tags)
+// go through UI_IdFromU64 and are only a combine of two u64.
+//
+fn_internal u64      UI_IdSeed(ui_context* Context, ui_object* Parent);
+fn_internal hash_key UI_Id(ui_context* Context, const char* Key, u64 Len, ui_object* Parent);
+fn_internal hash_key UI_IdFromU64(ui_context* Context, u64 Value, ui_object* Parent);
+fn_internal void     UI_PushId(ui_context* Context, u64 Value);
+fn_internal void     UI_PushIdString(ui_context* Context, const char* Value);
+fn_internal void     UI_PopId(ui_context* Context);
+
 #define UI_BuildObject(ctx, key, txt, rect, opts) UI_BuildObjectWithParent(ctx, key, txt, rect, opts, ctx->CurrentParent);
 
 fn_internal ui_input UI_ConsumeEvents(ui_context* Context, ui_object* Object);
-// Widgets
+// Widgets. The plain ones are keyed by their text, which costs a strlen and a
+// hash of it every frame. The WithId ones take a u64 the caller already has
+// (a row, an index, a tag) and only combine it with the parent, like
+// UI_IdFromU64. Ids only have to differ among the children of one parent, push
+// an id around loops that share one. Text boxes stay keyed by text, that is
+// the key UI_GetTextFromBox finds them by.
+//
 fn_internal ui_input UI_Button(ui_context* Context, const char* text);
+fn_internal ui_input UI_ButtonWithId(ui_context* Context, u64 Id, const char* text);
 fn_internal ui_input UI_Label(ui_context* Context, const char* text);
+fn_internal ui_input UI_LabelWithId(ui_context* Context, u64 Id, const char* text);
 fn_internal ui_input UI_LabelWithKey(ui_context* Context, const char* key, const char* text);
 fn_internal ui_input UI_TextBox(ui_context* Context, const char* text);
 fn_internal ui_input UI_BeginTreeNode(ui_context* Context, const char* text);
+fn_internal ui_input UI_BeginTreeNodeWithId(ui_context* Context, u64 Id, const char* text);
 fn_internal void     UI_EndTreeNode(ui_context* Context);
 
 fn_internal void UI_PushNextLayoutIcon(ui_context* Context, icon_type Type);
@@ -330,7 +444,17 @@ fn_internal void UI_PushLayoutSpacer(ui_context* Context, vec2 Spacer);
 
 fn_internal void UI_Spacer(ui_context* Context, vec2 Spacer);
 
-fn_internal U8_String*  UI_GetTextFromBox(ui_context* Context, const char* Key);
+fn_internal U8_String  UI_GetTextFromBox(ui_context* Context, const char* Key);
+
+fn_internal u32 UI_GetTextSpans(ui_object* Object, i64 Start, i64 End, U8_String Spans[2]);
+fn_internal i64 UI_GetTextLength(ui_object* Object);
+fn_internal f32 UI_GetTextWidth(ui_object* Object, i64 Start, i64 End);
+fn_internal i64 UI_GetTextVisibleEnd(ui_object* Object);
+fn_internal void UI_ScrollToCursor(ui_object* Object);
+
+fn_internal void UI_StoreText(ui_context* Context, ui_object* Object, const char* Text, i64 Len);
+fn_internal void UI_ReleaseInput(ui_context* Context, ui_object* Object);
+fn_internal void UI_RetireObjects(ui_context* Context);
 
 fn_internal vec2 UI_UpdateObjectSize(ui_context* Context, ui_object* Object);
 
@@ -358,7 +482,7 @@ fn_internal void UI_EndScrollbarView(ui_context* Context);
 
 fn_internal bool IsCursorOnRect(ui_context* Context, rect_2d Rect);
 
-fn_internal void UI_SortWindowByDepth(ui_win_stack* window, Stack_Allocator* Allocator );
+fn_internal void UI_SortWindowByDepth(ui_win_stack* window, Arena* Scratch );
 
 #endif // _SP_UI_H_
 
@@ -378,6 +502,14 @@ fn_internal void
 					   );
 	Context->Allocator = Allocator;
     Context->TempAllocator = TempAllocator;
+    pool_init_type(&Context->ObjectPool, Allocator, ui_object, UI_OBJECT_POOL_CHUNK);
+    Context->Pooled = NULL;
+    Context->Frame  = 0;
+
+    // Over RLIMIT_MEMLOCK the head is only prefaulted, see ArenaPrefaultRange
+    //
+    u64 LockedSize = TempAllocator->buf_len < UI_TEMP_LOCKED_SIZE ? TempAllocator->buf_len : UI_TEMP_LOCKED_SIZE;
+    ArenaPrefaultRange(TempAllocator->data, LockedSize, ARENA_PREFAULT_LOCK);
 
 	UI_NULL_OBJECT.HashId   = 0;
 	UI_NULL_OBJECT.DepthIdx = 0;
@@ -390,6 +522,7 @@ fn_internal void
     Context->Themes.N  = MAX_STACK_SIZE;
     Context->Layouts.N = MAX_LAYOUT_SIZE;
     Context->Windows.N = MAX_STACK_SIZE;
+    Context->Ids.N     = MAX_STACK_SIZE;
 
     Context->TextInput = StringCreate(2048, Allocator);
     Context->FocusObject = &UI_NULL_OBJECT;
@@ -400,6 +533,9 @@ fn_internal void
 	Context->IsOnResize = false;
 
     HashTableInit(&Context->TableObject, Allocator, 4096, UI_CustomXXHash);
+    InternPoolInit(&Context->Strings, UI_CustomXXHash);
+    Context->TextArena = ArenaAlloc(UI_TEXT_HEAP_RESERVE);
+    tlsf_init(&Context->TextHeap, Context->TextArena, UI_TEXT_HEAP_POOL);
 
 	spall_buffer_end(&spall_ctx, &spall_buffer, get_time_in_nanos() // timestamp in nanoseconds -- end of your timing block
 					 );
@@ -413,12 +549,17 @@ fn_internal void
     Context->LastInput    = Input_None;
 
     Context->TextInput.idx = 0;
+    Context->PasteText     = NULL;
 
 	TreeInit(&Context->RootObject, &UI_NULL_OBJECT);
 
     StackClear(&Context->Windows);
     StackClear(&Context->Layouts);
     StackClear(&Context->Themes);
+    StackClear(&Context->Ids);
+
+    UI_RetireObjects(Context);
+    Context->Frame += 1;
 }
 
 fn_internal void UI_End(ui_context* UI_Context, draw_bucket_instance* DrawInstance) {
@@ -427,8 +568,10 @@ fn_internal void UI_End(ui_context* UI_Context, draw_bucket_instance* DrawInstan
 					   sizeof(__FUNCTION__) - 1, // name len minus the null terminator
 					   get_time_in_nanos()      // timestamp in nanoseconds -- start of your timing block
 					   );
-    Stack_Allocator* TempAllocator = UI_Context->TempAllocator;
-    Stack_Allocator* Allocator     = UI_Context->Allocator;
+    // Everything allocated here dies at the end of the function, so it goes
+    // to this thread's scratch arena instead of the shared TempAllocator
+    //
+    Temp Scratch = GetScratch(NULL, 0);
     // Stack to iterate over the tree object
     //
     typedef struct {
@@ -440,9 +583,9 @@ fn_internal void UI_End(ui_context* UI_Context, draw_bucket_instance* DrawInstan
     ObjectStack Stack = {};
     Stack.N = 8 << 20;
     Stack.Current = 0;
-    Stack.Items = stack_push(TempAllocator, ui_object*, 8 << 20);
+    Stack.Items = PushArray(Scratch.arena, ui_object*, 8 << 20);
 
-    UI_SortWindowByDepth(&UI_Context->Windows, UI_Context->TempAllocator);
+    UI_SortWindowByDepth(&UI_Context->Windows, Scratch.arena);
 
     i32 N_Windows = UI_Context->Windows.Current;
 
@@ -529,24 +672,28 @@ fn_internal void UI_End(ui_context* UI_Context, draw_bucket_instance* DrawInstan
                 }
             }
 
-            if( Object->Text.data != NULL && Object->Text.idx > 0 && Object->Option & UI_DrawText) {
-
-				U8_String S = StringNew(
-					(const char*)(Object->Text.data + Object->TextStartIdx),
-					Object->Text.idx - Object->TextStartIdx,
-					UI_Context->TempAllocator
-				);
-
-				D_DrawText2D(
-					DrawInstance,
-					NewRect2D(Object->Pos.x, Object->Pos.y, Object->Size.x, Object->Size.y),
-					&S,
-					Object->Theme.Font,
-					Vec4New(Color.r, Color.g, Color.b, Color.a)
-				);
+            i64 TextLength = UI_GetTextLength(Object);
+            if( TextLength > 0 && Object->Option & UI_DrawText) {
+
+                i64 Start = Max(0, Object->TextStartIdx);
+                i64 End   = Object->Type == UI_InputText ? UI_GetTextVisibleEnd(Object) : TextLength;
+
+                U8_String Spans[2];
+                u32 SpanCount = UI_GetTextSpans(Object, Start, End, Spans);
+                f32 PenX      = Object->Pos.x;
+                for( u32 i = 0; i < SpanCount; i += 1 ) {
+                    D_DrawText2D(
+                        DrawInstance,
+                        NewRect2D(PenX, Object->Pos.y, Object->Size.x, Object->Size.y),
+                        &Spans[i],
+                        Object->Theme.Font,
+                        Vec4New(Color.r, Color.g, Color.b, Color.a)
+                    );
+                    PenX += F_TextWidth(Object->Theme.Font, (const char*)Spans[i].data, (int)Spans[i].idx);
+                }
 
                 if( Object->TextCursorIdx >= 0 && Object->TextStartIdx >= 0 && Object->Type == UI_InputText) {
-                    float Start = Object->Pos.x + F_TextWidth(Object->Theme.Font, (const char*)Object->Text.data, Object->TextCursorIdx - Object->TextStartIdx);
+                    float Start = Object->Pos.x + UI_GetTextWidth(Object, Object->TextStartIdx, Object->TextCursorIdx);
 					float CursorSize = F_TextWidth(Object->Theme.Font, "H", 1);
 					D_DrawRect2D(
 						DrawInstance,
@@ -556,8 +703,8 @@ fn_internal void UI_End(ui_context* UI_Context, draw_bucket_instance* DrawInstan
 						Vec4New(Color.r, Color.g, Color.b, Color.a * 0.5)
 					);
                 }
-            } else if( Object->Text.idx == 0 && Object->Type == UI_InputText && Object->Option & UI_DrawText ) {
-                float Start = Object->Pos.x + F_TextWidth(Object->Theme.Font, (const char*)Object->Text.data, Object->TextCursorIdx);
+            } else if( TextLength == 0 && Object->Type == UI_InputText && Object->Option & UI_DrawText ) {
+                float Start = Object->Pos.x;
 				float CursorSize = F_TextWidth(Object->Theme.Font, "H", 1);
 				D_DrawRect2D(
 					DrawInstance,
@@ -584,6 +731,7 @@ fn_internal void UI_End(ui_context* UI_Context, draw_bucket_instance* DrawInstan
 			}
         }
     }
+    ReleaseScratch(Scratch);
 	spall_buffer_end(&spall_ctx, &spall_buffer, get_time_in_nanos() // timestamp in nanoseconds -- end of your timing block
 					 );
 }
@@ -621,9 +769,9 @@ fn_internal void
 }
 
 fn_internal void
-	UI_SortWindowByDepth(ui_win_stack* window, Stack_Allocator* Alloc ) {
+	UI_SortWindowByDepth(ui_win_stack* window, Arena* Scratch ) {
 
-	ui_window** WorkBuffer = stack_push(Alloc, ui_window*, window->Current);
+	ui_window** WorkBuffer = PushArray(Scratch, ui_window*, window->Current);
 	for (u32 i = 0; i < window->Current; i += 1) {
 		WorkBuffer[i] = (window->Items[i]);
 	}
@@ -721,21 +869,183 @@ fn_internal void UI_WindowEnd(ui_context* Context) {
     }
 }
 
-fn_internal U8_String* UI_GetTextFromBox(ui_context* Context, const char* Key) {
+fn_internal U8_String UI_GetTextFromBox(ui_context* Context, const char* Key) {
     spall_buffer_begin(&spall_ctx, &spall_buffer,
 					  __FUNCTION__,             // name of your function
 					  sizeof(__FUNCTION__) - 1, // name len minus the null terminator
 					  get_time_in_nanos()      // timestamp in nanoseconds -- start of your timing block
 					  );
 	ui_object* parent = Context->CurrentParent;
-    if( HashTableContains(&Context->TableObject, Key, parent->HashId) ) {
-        entry* StoredWindowEntry = HashTableFindPointer(&Context->TableObject, Key, parent->HashId);
+    entry* StoredWindowEntry = HashTableFindHashed(&Context->TableObject, UI_Id(Context, Key, UCF_Strlen(Key), parent).Hash);
+    if( StoredWindowEntry != NULL ) {
         ui_object* Value = (ui_object*)StoredWindowEntry->Value;
-        return &Value->Text;
+        U8_String  Text  = SsoStringView(&Value->Text);
+        if( Value->Type == UI_InputText && Value->Input != NULL ) {
+            Text = GapBufferView(Value->Input);
+        }
+        spall_buffer_end(&spall_ctx, &spall_buffer, get_time_in_nanos());
+        return Text;
     }
 	spall_buffer_end(&spall_ctx, &spall_buffer, get_time_in_nanos() // timestamp in nanoseconds -- end of your timing block
 					 );
-    return NULL;
+    U8_String Empty = {};
+    return Empty;
+}
+
+// Short text is inline. The first long text of an object is interned, labels
+// mostly never change after that. Long text that replaces other text goes to
+// the object's own buffer, which only grows, so a counter or a typed line
+// reuses it instead of interning every value it takes
+//
+fn_internal void UI_StoreText(ui_context* Context, ui_object* Object, const char* Text, i64 Len) {
+    if( Len <= SSO_STRING_INLINE ) {
+        SsoStringCpy(&Object->Text, Text, Len, NULL);
+        return;
+    }
+
+    if( Object->OwnedText == NULL && SsoStringLength(&Object->Text) == 0 ) {
+        str_id Id = InternN(&Context->Strings, Text, Len);
+        Object->Text = SsoStringRef((const u8*)InternCString(&Context->Strings, Id), InternLength(&Context->Strings, Id));
+        return;
+    }
+
+    u8* Owned = Object->OwnedText;
+    if( Owned == NULL || tlsf_block_size(Owned) < Len ) {
+        i64 Capacity = Owned != NULL ? tlsf_block_size(Owned) * 2 : 0;
+        Owned = (u8*)tlsf_alloc(&Context->TextHeap, Capacity > Len ? Capacity : Len, 1);
+        if( Owned == NULL ) {
+            return;
+        }
+        memcpy(Owned, Text, Len);
+        if( Object->OwnedText != NULL ) {
+            tlsf_free(&Context->TextHeap, Object->OwnedText);
+        }
+        Object->OwnedText = Owned;
+    } else {
+        // Text can be part of the buffer itself
+        //
+        memmove(Owned, Text, Len);
+    }
+    Object->Text = SsoStringRef(Owned, Len);
+}
+
+// The box lost focus, what was typed stays in Text and the gap buffer's arenas
+// are given back
+//
+fn_internal void UI_ReleaseInput(ui_context* Context, ui_object* Object) {
+    if( Object->Input == NULL ) {
+        return;
+    }
+    U8_String Typed = GapBufferView(Object->Input);
+    UI_StoreText(Context, Object, (const char*)Typed.data, Typed.idx);
+    GapBufferRelease(Object->Input);
+    Object->Input  = NULL;
+    Object->Edited = true;
+}
+
+// Objects that were not built for UI_OBJECT_RETIRE_FRAMES frames leave the
+// table and go back to the pool, a label that changes every frame would grow
+// the pool forever otherwise
+//
+fn_internal void UI_RetireObjects(ui_context* Context) {
+    ui_object** Link = &Context->Pooled;
+    while( *Link != NULL ) {
+        ui_object* Object = *Link;
+        bool Keep = (Object->Option & UI_SetPosPersistent) || Object == Context->FocusObject ||
+                    Context->Frame - Object->BuiltFrame < UI_OBJECT_RETIRE_FRAMES;
+        if( Keep ) {
+            Link = &Object->NextPooled;
+            continue;
+        }
+        *Link = Object->NextPooled;
+        HashTableRemoveHashed(&Context->TableObject, Object->HashId);
+        if( Object->Input != NULL ) {
+            GapBufferRelease(Object->Input);
+        }
+        if( Object->OwnedText != NULL ) {
+            tlsf_free(&Context->TextHeap, Object->OwnedText);
+        }
+        pool_free(&Context->ObjectPool, Object);
+    }
+}
+
+// Text of an object as at most two spans, input boxes keep theirs in a gap
+// buffer while they have focus
+//
+fn_internal u32 UI_GetTextSpans(ui_object* Object, i64 Start, i64 End, U8_String Spans[2]) {
+    if( Object->Type == UI_InputText && Object->Input != NULL ) {
+        return GapBufferSpans(Object->Input, Start, End, Spans);
+    }
+
+    i64 Length = SsoStringLength(&Object->Text);
+    Start = GapBufferClamp(Start, 0, Length);
+    End   = GapBufferClamp(End, Start, Length);
+    if( Start == End ) {
+        return 0;
+    }
+    Spans[0].data = (u8*)SsoStringData(&Object->Text) + Start;
+    Spans[0].len  = End - Start;
+    Spans[0].idx  = End - Start;
+    return 1;
+}
+
+fn_internal i64 UI_GetTextLength(ui_object* Object) {
+    if( Object->Type == UI_InputText && Object->Input != NULL ) {
+        return GapBufferLength(Object->Input);
+    }
+    return SsoStringLength(&Object->Text);
+}
+
+fn_internal f32 UI_GetTextWidth(ui_object* Object, i64 Start, i64 End) {
+    U8_String Spans[2];
+    u32 Count = UI_GetTextSpans(Object, Start, End, Spans);
+
+    f32 Width = 0;
+    for( u32 i = 0; i < Count; i += 1 ) {
+        Width += F_TextWidth(Object->Theme.Font, (const char*)Spans[i].data, (int)Spans[i].idx);
+    }
+    return Width;
+}
+
+// End of the text that still fits in the box starting at TextStartIdx. It
+// walks one character at a time and stops at the border, so only what is
+// visible gets measured.
+//
+fn_internal i64 UI_GetTextVisibleEnd(ui_object* Object) {
+    i64 Length = UI_GetTextLength(Object);
+    i64 End    = Max(0, Object->TextStartIdx);
+    f32 Used   = 0;
+    while( End < Length ) {
+        f32 Char = UI_GetTextWidth(Object, End, End + 1);
+        if( Used + Char > Object->Rect.Size.x ) {
+            break;
+        }
+        Used += Char;
+        End  += 1;
+    }
+    return End;
+}
+
+// Moves TextStartIdx so the cursor is inside the box, measuring back from
+// the cursor only until the box is full
+//
+fn_internal void UI_ScrollToCursor(ui_object* Object) {
+    i64 Cursor = GapBufferClamp(Object->TextCursorIdx, 0, UI_GetTextLength(Object));
+    i64 Start  = GapBufferClamp(Object->TextStartIdx, 0, Cursor);
+
+    f32 Width  = Object->Rect.Size.x - F_TextWidth(Object->Theme.Font, "H", 1);
+    f32 Used   = 0;
+    i64 First  = Cursor;
+    while( First > Start ) {
+        f32 Char = UI_GetTextWidth(Object, First - 1, First);
+        if( Used + Char > Width ) {
+            Start = First;
+            break;
+        }
+        Used  += Char;
+        First -= 1;
+    }
+    Object->TextStartIdx = (i32)Start;
 }
 
 fn_internal void UI_DrawRect2D(ui_context* Context, rect_2d Rect, vec4 color, vec4 color_border, f32 border, f32 radius) {
@@ -774,9 +1084,8 @@ fn_internal void UI_DrawText2D(ui_context* Context, rect_2d Rect, U8_String* Str
 	Object->Pos = Rect.Pos;
 	Object->Size = Vec2New(F_TextWidth(Font, (const char*)String->data, String->idx), F_TextHeight(Font));
 	Object->Theme.Foreground = color;
-	Object->Text = StringCreate(String->len, Context->TempAllocator);
+	Object->Text = SsoStringNew((const char*)String->data, String->idx, Context->TempAllocator);
 	Object->Theme.Font = Font;
-	StringCpyStr(&Object->Text, String);
 
 	Object->Option = UI_DrawText;
 
@@ -786,7 +1095,42 @@ fn_internal void UI_DrawText2D(ui_context* Context, rect_2d Rect, U8_String* Str
 					 );
 }
 
+fn_internal u64 UI_IdSeed(ui_context* Context, ui_object* Parent) {
+    if( StackIsEmpty(&Context->Ids) ) {
+        return Parent->HashId;
+    }
+    return HashTableCombine(Parent->HashId, StackGetFront(&Context->Ids));
+}
+
+fn_internal hash_key UI_Id(ui_context* Context, const char* Key, u64 Len, ui_object* Parent) {
+    return HashTableKey(&Context->TableObject, Key, Len, UI_IdSeed(Context, Parent));
+}
+
+fn_internal hash_key UI_IdFromU64(ui_context* Context, u64 Value, ui_object* Parent) {
+    hash_key Key = {};
+    Key.Hash = HashTableCombine(UI_IdSeed(Context, Parent), Value);
+    return Key;
+}
+
+fn_internal void UI_PushId(ui_context* Context, u64 Value) {
+    u64 Below = StackIsEmpty(&Context->Ids) ? 0 : StackGetFront(&Context->Ids);
+    StackPush(&Context->Ids, HashTableCombine(Below, Value));
+}
+
+fn_internal void UI_PushIdString(ui_context* Context, const char* Value) {
+    UI_PushId(Context, UI_CustomXXHash((const u8*)Value, UCF_Strlen(Value), 0));
+}
+
+fn_internal void UI_PopId(ui_context* Context) {
+    StackPop(&Context->Ids);
+}
+
 fn_internal ui_object* UI_BuildObjectWithParent(ui_context* Context, const u8* Key, const u8* Text, rect_2d Rect, ui_lay_opt Options, ui_object* Parent )
+{
+    return UI_BuildObjectWithId(Context, UI_Id(Context, (const char*)Key, UCF_Strlen((const char*)Key), Parent), Text, Rect, Options, Parent);
+}
+
+fn_internal ui_object* UI_BuildObjectWithId(ui_context* Context, hash_key Key, const u8* Text, rect_2d Rect, ui_lay_opt Options, ui_object* Parent )
 {
 	spall_buffer_begin(&spall_ctx, &spall_buffer,
 					   __FUNCTION__,             // name of your function
@@ -795,21 +1139,22 @@ fn_internal ui_object* UI_BuildObjectWithParent(ui_context* Context, const u8* K
 					   );
     ui_object* Object = &UI_NULL_OBJECT;
 
-    ui_object* IdParent = Context->CurrentParent;
-	entry* StoredEntry = HashTableFindPointer(&Context->TableObject, (const char*)Key, Parent->HashId);
+	entry* StoredEntry = HashTableFindHashed(&Context->TableObject, Key.Hash);
 
     if( StoredEntry != NULL ) {
 
 		Object = (ui_object*)StoredEntry->Value;
     } else {
-        Object = stack_push(Context->Allocator, ui_object, 1);
-        memset(Object, 0, sizeof(ui_object));
-        StoredEntry = HashTableAdd(&Context->TableObject, (const char*)Key, Object, Parent->HashId);
+        Object = pool_push(&Context->ObjectPool, ui_object);
+        StoredEntry = HashTableAddHashed(&Context->TableObject, Key, Object);
         Object->HashId = StoredEntry->HashId;
+        Object->NextPooled = Context->Pooled;
+        Context->Pooled    = Object;
         Object->TextCursorIdx = -1;
         Object->Rect   = Rect;
         Object->Option = Options;
     }
+    Object->BuiltFrame = Context->Frame;
     // As these are dragable, we do not want the to have the fixed rect size
     //
     if( !(Options & UI_SetPosPersistent) ) {
@@ -868,82 +1213,64 @@ fn_internal ui_object* UI_BuildObjectWithParent(ui_context* Context, const u8* K
 
     if( Options & UI_DrawText ) {
         u32 Len = CustomStrlen((const char*)Text);
-        if( Object->Text.data == NULL ) {
-            Object->Text = StringNew((const char*)Text, Len, Context->Allocator);
-        } else if( Object->Type != UI_InputText ) {
-            // If it is Input text we do not want to copy again the title text, as
-            // it already stores input information from the user
-            StringCpy(&Object->Text, (const char*)Text);
+        // If it is Input text the user typed in we do not want to copy again
+        // the title text, as it already stores input information from the
+        // user. Same text as the last frame is the common case and copies nothing
+        //
+        if( Object->Type == UI_InputText && Object != Context->FocusObject ) {
+            UI_ReleaseInput(Context, Object);
+        }
+        if( (Object->Type != UI_InputText || (Object->Input == NULL && !Object->Edited)) && !SsoStringEq(&Object->Text, (const char*)Text, Len) ) {
+            UI_StoreText(Context, Object, (const char*)Text, Len);
         }
         if( Object->Type == UI_InputText && Object == Context->FocusObject ) {
-            Object->TextCursorIdx = Max(0, Object->TextCursorIdx);
-            if( Context->TextInput.len > Object->Text.len ) {
-                Object->Text = StringCreate(Context->TextInput.len, Context->Allocator);
-            }
-            if( Context->TextInput.idx > 0 && !(Context->LastInput & Input_Backspace) && !(Context->LastInput & DeleteWord) ) {
-                //StringAppndStr(&Object->Text, &Context->TextInput);
-                //Object->Text.data[Object->Text.idx] = '\0';
-                StringInsertStr(&Object->Text, Object->TextCursorIdx, &Context->TextInput);
-                Object->TextCursorIdx += Context->TextInput.idx;
+            if( Object->Input == NULL ) {
+                Object->Input = GapBufferAlloc(SsoStringData(&Object->Text), SsoStringLength(&Object->Text));
             }
-            if( Context->LastInput & DeleteWord ) {
-                i32 LastSlash      = GetLastOcurrence(&Object->Text, '/');
-                i32 LastUnderScore = GetLastOcurrence(&Object->Text, '_');
-                i32 LastSpace      = GetLastOcurrence(&Object->Text, ' ');
-                // This is done so that it does not remove the actual character
-                // hello/asdf --> hello/
-                // instead of
-                // hello/asdf --> hello
-                //
-                if( LastSlash != -1 ) {
-                    LastSlash += 1;
-                }
-                if( LastUnderScore != -1 ) {
-                    LastUnderScore += 1;
-                }
-                if( LastSpace != -1 ) {
-                    LastSpace += 1;
-                }
+            gap_buffer* Input = Object->Input;
+            if( Input != NULL ) {
+                Object->TextCursorIdx = (i32)GapBufferClamp(Object->TextCursorIdx, 0, GapBufferLength(Input));
 
-                if( LastSlash > LastUnderScore ) {
-                    if( LastSlash < LastSpace && LastSpace > 0 ) {
-                        Object->TextCursorIdx = LastSpace;
-                        StringEraseUntil(&Object->Text, LastSpace);
-                        StringEraseUntil(&Context->TextInput, LastSpace);
-                    } else if( LastSlash > 0) {
-                        Object->TextCursorIdx = LastSlash;
-                        StringEraseUntil(&Object->Text, LastSlash);
-                        StringEraseUntil(&Context->TextInput, LastSlash);
-                    }
-                } else if( LastUnderScore > 0 ) {
-                    if( LastUnderScore < LastSpace ) {
-                        Object->TextCursorIdx = LastSpace;
-                        StringEraseUntil(&Object->Text, LastSpace);
-                        StringEraseUntil(&Context->TextInput, LastSpace);
-                    } else {
-                        Object->TextCursorIdx = LastUnderScore;
-                        StringEraseUntil(&Object->Text, LastUnderScore);
-                        StringEraseUntil(&Context->TextInput, LastUnderScore);
+                if( Context->TextInput.idx > 0 && !(Context->LastInput & Input_Backspace) && !(Context->LastInput & DeleteWord) ) {
+                    GapBufferInsert(Input, Object->TextCursorIdx, Context->TextInput.data, Context->TextInput.idx);
+                    Object->TextCursorIdx += Context->TextInput.idx;
+                }
+                if( Context->PasteText != NULL ) {
+                    i64 Len = CustomStrlen(Context->PasteText);
+                    if( GapBufferInsert(Input, Object->TextCursorIdx, (const u8*)Context->PasteText, Len) ) {
+                        Object->TextCursorIdx += (i32)Len;
                     }
-                } else if( LastSpace > 0 ) {
-                    Object->TextCursorIdx = LastSpace;
-                    StringEraseUntil(&Object->Text, LastSpace);
-                    StringEraseUntil(&Context->TextInput, LastSpace);
-                } else {
-                    StringEraseUntil(&Object->Text, 0);
-                    StringEraseUntil(&Context->TextInput, 0);
-					Object->TextCursorIdx = 0;
                 }
-
-            } else if( Context->LastInput & Input_Backspace ) {
-                //Object->Text.idx = Object->Text.idx > 0 ? Object->Text.idx - 1 : 0;
-                StringErase(&Object->Text, Object->TextCursorIdx);
+                if( Context->LastInput & DeleteWord ) {
+                    // Cut right after the last separator before the cursor so it stays
+                    // hello/asdf --> hello/
+                    // instead of
+                    // hello/asdf --> hello
+                    //
+                    i64 Cut = GapBufferFindLastOf(Input, Object->TextCursorIdx, "/_ ") + 1;
+
+                    GapBufferErase(Input, Cut, Object->TextCursorIdx - Cut);
+                    Object->TextCursorIdx = (i32)Cut;
+                } else if( Context->LastInput & Input_Backspace ) {
+                    GapBufferErase(Input, Object->TextCursorIdx, 1);
+                }
             }
         }
 
+        // Input boxes only measure what fits in the box, the text behind
+        // them can be any size
+        //
+        f32 Width = 0;
+        if( Object->Type == UI_InputText ) {
+            UI_ScrollToCursor(Object);
+            Width = UI_GetTextWidth(Object, Object->TextStartIdx, UI_GetTextVisibleEnd(Object));
+        } else {
+            Width = F_TextWidth(Object->Theme.Font, (const char*)SsoStringData(&Object->Text), (int)SsoStringLength(&Object->Text));
+        }
+
         Object->Pos  = Object->Rect.Pos;
         Object->Size = vec2{
-            (f32)F_TextWidth(Object->Theme.Font, (const char*)Object->Text.data, Object->Text.idx),
+            Width,
             (f32)F_TextHeight(Object->Theme.Font)
         };
 
@@ -959,11 +1286,11 @@ fn_internal ui_object* UI_BuildObjectWithParent(ui_context* Context, const u8* K
 			// Average size of a character given the size of the string and the number of
 			// characters is composed of
 			//
-			f32 C_Avg  = Object->Size.x / Object->Text.idx;
+			f32 C_Avg  = Object->Size.x / UI_GetTextLength(Object);
 
 			u32 N_Chars = (u32) ceilf(Offset / C_Avg);
 
-			if (N_Chars <= Object->Text.idx) {
+			if (N_Chars <= UI_GetTextLength(Object)) {
 				// @todo This would affect text boxes
 				// Object->Text.idx -= N_Chars;
 			}
@@ -1042,8 +1369,7 @@ fn_internal ui_input UI_ConsumeEvents(ui_context* Context, ui_object* Object) {
     return Input_None;
 }
 
-fn_internal ui_input UI_Button(ui_context* Context, const char* Title) {
-
+fn_internal ui_input UI_ButtonFromKey(ui_context* Context, hash_key Key, const char* Title) {
     ui_object* Parent = Context->CurrentParent;
 
     ui_layout Layout = StackGetFront(&Context->Layouts);
@@ -1054,7 +1380,7 @@ fn_internal ui_input UI_Button(ui_context* Context, const char* Title) {
     ui_lay_opt Options = static_cast<ui_lay_opt>(UI_DrawRect | UI_DrawBorder | UI_DrawText | UI_AlignVertical | UI_AlignCenter | UI_Interact | UI_Select);
 
     UI_SetNextTheme( Context, Context->DefaultTheme.Button );
-    ui_object* Button = UI_BuildObjectWithParent(Context, (const u8*)Title, (const u8*)Title, Rect, Options, Parent);
+    ui_object* Button = UI_BuildObjectWithId(Context, Key, (const u8*)Title, Rect, Options, Parent);
 
     ui_input Input = UI_ConsumeEvents(Context, Button);
     Button->LastInputSet = Input;
@@ -1079,7 +1405,15 @@ fn_internal ui_input UI_Button(ui_context* Context, const char* Title) {
     return Input;
 }
 
-fn_internal ui_input UI_Label(ui_context* Context, const char* text) {
+fn_internal ui_input UI_Button(ui_context* Context, const char* Title) {
+    return UI_ButtonFromKey(Context, UI_Id(Context, Title, UCF_Strlen(Title), Context->CurrentParent), Title);
+}
+
+fn_internal ui_input UI_ButtonWithId(ui_context* Context, u64 Id, const char* Title) {
+    return UI_ButtonFromKey(Context, UI_IdFromU64(Context, Id, Context->CurrentParent), Title);
+}
+
+fn_internal ui_input UI_LabelFromKey(ui_context* Context, hash_key Key, const char* text) {
     ui_object* Parent = Context->CurrentParent;
 
     ui_layout Layout = StackGetFront(&Context->Layouts);
@@ -1089,7 +1423,7 @@ fn_internal ui_input UI_Label(ui_context* Context, const char* text) {
 
     ui_lay_opt Options = static_cast<ui_lay_opt>(UI_DrawText | UI_AlignVertical | UI_Interact | UI_Select | Layout.Option);
     UI_SetNextTheme( Context, Context->DefaultTheme.Label );
-    ui_object* Label = UI_BuildObjectWithParent(Context, (const u8*)text, (const u8*)text, Rect, Options, Parent);
+    ui_object* Label = UI_BuildObjectWithId(Context, Key, (const u8*)text, Rect, Options, Parent);
 
 	StackPop(&Context->Themes);
     ui_input Input = UI_ConsumeEvents(Context, Label);
@@ -1099,6 +1433,14 @@ fn_internal ui_input UI_Label(ui_context* Context, const char* text) {
     return Input;
 }
 
+fn_internal ui_input UI_Label(ui_context* Context, const char* text) {
+    return UI_LabelFromKey(Context, UI_Id(Context, text, UCF_Strlen(text), Context->CurrentParent), text);
+}
+
+fn_internal ui_input UI_LabelWithId(ui_context* Context, u64 Id, const char* text) {
+    return UI_LabelFromKey(Context, UI_IdFromU64(Context, Id, Context->CurrentParent), text);
+}
+
 fn_internal ui_input UI_LabelWithKey(ui_context* Context, const char* Key, const char* text) {
     ui_object* Parent = Context->CurrentParent;
 
@@ -1144,28 +1486,6 @@ fn_internal ui_input UI_TextBox(ui_context* Context, const char* text) {
 		Input |= Context->LastInput;
     }
 
-	if ( Input & Input_KeyChar || Input & Input_KeyPressed ) {
-		if (TextBox->Size.x > TextBox->Rect.Size.x) {
-			// How much text is outside the render box
-			//
-			f32 Offset = TextBox->Size.x - TextBox->Rect.Size.x;
-			// Average size of a character given the size of the string and the number of
-			// characters is composed of
-			//
-			f32 C_Avg  = TextBox->Size.x / TextBox->Text.idx;
-
-			u32 N_Chars = (u32) ceilf(Offset / C_Avg);
-
-			if (TextBox->TextCursorIdx >= N_Chars && (Input & Input_Backspace || Input & Input_Left ) ) {
-				TextBox->TextStartIdx = Max(0, TextBox->TextStartIdx - 1);
-			} else if (TextBox->TextCursorIdx >= N_Chars) {
-				TextBox->TextStartIdx = Min(TextBox->TextCursorIdx, TextBox->TextStartIdx + 1);
-			}
-		} else {
-			TextBox->TextStartIdx = 0;
-		}
-	}
-
     if( TextBox->LastInputSet & Input_CursorHover ) {
 		TextBox->Theme.Background.b += 0.2;
     }
@@ -1174,7 +1494,7 @@ fn_internal ui_input UI_TextBox(ui_context* Context, const char* text) {
 }
 
 
-fn_internal ui_input UI_BeginTreeNode(ui_context* Context, const char* text) {
+fn_internal ui_input UI_BeginTreeNodeFromKey(ui_context* Context, hash_key Key, const char* text) {
     ui_object* Parent = Context->CurrentParent;
 
     ui_layout Layout = StackGetFront(&Context->Layouts);
@@ -1184,7 +1504,7 @@ fn_internal ui_input UI_BeginTreeNode(ui_context* Context, const char* text) {
 
     ui_lay_opt Options = static_cast<ui_lay_opt>(UI_DrawBorder | UI_DrawRect | UI_DrawText | UI_AlignVertical | UI_AlignCenter | UI_Interact | UI_Select);
     UI_SetNextTheme( Context, Context->DefaultTheme.Panel );
-    ui_object* TreeNode = UI_BuildObjectWithParent(Context, (const u8*)text, (const u8*)text, Rect, Options, Parent);
+    ui_object* TreeNode = UI_BuildObjectWithId(Context, Key, (const u8*)text, Rect, Options, Parent);
 	StackPop(&Context->Themes);
     ui_input Input = UI_ConsumeEvents(Context, TreeNode);
     ui_input IsActive = TreeNode->LastInputSet & ActiveObject;
@@ -1215,6 +1535,14 @@ fn_internal ui_input UI_BeginTreeNode(ui_context* Context, const char* text) {
     return TreeNode->LastInputSet;
 }
 
+fn_internal ui_input UI_BeginTreeNode(ui_context* Context, const char* text) {
+    return UI_BeginTreeNodeFromKey(Context, UI_Id(Context, text, UCF_Strlen(text), Context->CurrentParent), text);
+}
+
+fn_internal ui_input UI_BeginTreeNodeWithId(ui_context* Context, u64 Id, const char* text) {
+    return UI_BeginTreeNodeFromKey(Context, UI_IdFromU64(Context, Id, Context->CurrentParent), text);
+}
+
 fn_internal void UI_EndTreeNode(ui_context* Context) {
 	UI_PopLastParent(Context);
 }
@@ -1240,14 +1568,16 @@ fn_internal ui_input UI_SetIcon(ui_context* Context, const char* Name, icon_type
 
 	Layout.AxisDirection = 0;
 
-	char KeyName[126];
-	snprintf(KeyName, 126, "%s_%p", Name, Parent->Last);
+	// The name plus the object it follows, without formatting a key
+	//
+	hash_key Key = UI_Id(Context, Name, UCF_Strlen(Name), Parent);
+	Key.Hash     = HashTableCombine(Key.Hash, (u64)(uintptr_t)Parent->Last);
 
     vec2 BoxSize = Layout.BoxSize;
     //UI_PushNextLayoutBoxSize(Context, Rect.Size);
 
 	ui_lay_opt Options = static_cast<ui_lay_opt>(UI_DrawIcon | UI_HintSize);
-	ui_object* Icon  = UI_BuildObjectWithParent(Context, (const u8*)KeyName, (const u8*)Name, Rect, Options, Parent);
+	ui_object* Icon  = UI_BuildObjectWithId(Context, Key, (const u8*)Name, Rect, Options, Parent);
 	Icon->Type = static_cast<object_type>(Type);
 
 	//UI_PushNextLayoutBoxSize(Context, BoxSize);
@@ -1287,9 +1617,6 @@ fn_internal void UI_BeginScrollbarViewEx(ui_context* Context, vec2 Size) {
 					   get_time_in_nanos()      // timestamp in nanoseconds -- start of your timing block
 					   );
 
-    char name[64];
-    snprintf(name, 64, "ScrollBarView_%p", Context->CurrentParent);
-
     ui_layout *Layout = &StackGetFront(&Context->Layouts);
 
     ui_object* Parent = Context->CurrentParent;
@@ -1307,9 +1634,9 @@ fn_internal void UI_BeginScrollbarViewEx(ui_context* Context, vec2 Size) {
 
 	//UI_DrawRect2D(Context, Rect, Context->DefaultTheme.Scrollbar.Background, Context->DefaultTheme.Scrollbar.Background, 1, 4);
 
-    ui_object* Scroll = UI_BuildObjectWithParent(
+    ui_object* Scroll = UI_BuildObjectWithId(
                             Context,
-                            (const u8*)name, NULL,
+                            UI_IdFromU64(Context, UI_ID_SCROLLBAR_VIEW, Parent), NULL,
                             Rect,
                             static_cast<ui_lay_opt>(UI_DrawRect | UI_HintSize), Parent
                         );
@@ -1339,10 +1666,6 @@ fn_internal void UI_EndScrollbarView(ui_context* Context) {
 	f32 ScrollRatio = Scrollbar->ContentSize.y / ViewportContent;
     ScrollableSize.Size.y  = Max(ScrollableSize.Size.y, 20.0f);
 
-    char buf[64];
-
-    snprintf(buf, 64, "EndOfScroll_%p", Scrollbar);
-
     assert(!StackIsEmpty(&Context->Layouts));
 
     ui_layout* Layout = &StackGetFront(&Context->Layouts);
@@ -1357,7 +1680,7 @@ fn_internal void UI_EndScrollbarView(ui_context* Context) {
 	Layout->ContentSize.y = 0;
 
     UI_SetNextTheme( Context, Context->DefaultTheme.Scrollbar );
-    ui_object* Scrollable = UI_BuildObjectWithParent(Context, (const u8*)buf, NULL, ScrollableSize, static_cast<ui_lay_opt>(UI_DrawRect | UI_DrawBorder | UI_Select | UI_Interact), Scrollbar);
+    ui_object* Scrollable = UI_BuildObjectWithId(Context, UI_IdFromU64(Context, UI_ID_SCROLLBAR_END, Scrollbar), NULL, ScrollableSize, static_cast<ui_lay_opt>(UI_DrawRect | UI_DrawBorder | UI_Select | UI_Interact), Scrollbar);
     StackPop(&Context->Themes);
 	Scrollable->Type = UI_ScrollbarTypeButton;
     Scrollable->Theme = Context->DefaultTheme.Scrollbar;
@@ -1671,7 +1994,7 @@ fn_internal ui_input UI_LastEvent(ui_context* Context, api_window* Window) {
         //gfx->base->FramebufferResized = true;
     }
     if( Input & ClipboardPaste ) {
-        StringAppend(&Context->TextInput, (const char*)&Window->ClipboardContent);
+        Context->PasteText = GetClipboard(Window);
     }
     if( Input & Input_MiddleMouseUp ) {
         Context->CursorDelta.y += 6;
@@ -1692,7 +2015,7 @@ fn_internal ui_input UI_LastEvent(ui_context* Context, api_window* Window) {
 		//Context->FocusObject->TextCursorIdx -= 1;
 	}
     if( Input & Input_Right ) {
-        Context->FocusObject->TextCursorIdx = Min(Context->FocusObject->Text.idx, Context->FocusObject->TextCursorIdx + 1);
+        Context->FocusObject->TextCursorIdx = Min(UI_GetTextLength(Context->FocusObject), Context->FocusObject->TextCursorIdx + 1);
 	}
     if( Input & DeleteWord ) {
 
@@ -1700,9 +2023,6 @@ fn_internal ui_input UI_LastEvent(ui_context* Context, api_window* Window) {
         Context->FocusObject->TextCursorIdx = Max(0, Context->FocusObject->TextCursorIdx - 1 );
         Context->TextInput.idx = Max(0, Context->TextInput.idx - 1);
     }
-    if( Input & ClipboardPaste ) {
-        StringAppend(&Context->TextInput, GetClipboard(Window));
-    }
     if( Input & Input_KeyChar ) {
         Context->KeyPressed |= Window->KeyPressed;
         Context->KeyDown    |= Window->KeyPressed;
@@ -11,9 +11,221 @@ R_FormatToVkFormat(r_format format) {
     }
 }
 
+// Table hash for resource names, has to be R_HashString so R_ID matches
+//
 fn_internal u64
-CustomXXHash( const u8* buffer, u64 len, u64 seed ) {
-    return XXH3_64bits_withSeed(buffer, len, seed);
+R_HashBytes( const u8* buffer, u64 len, u64 seed ) {
+    return R_HashString((const char*)buffer, len, seed);
+}
+
+fn_internal r_id
+R_IdFromString( const char* Name ) {
+	r_id Id;
+	Id.Str  = Name;
+	Id.Len  = UCF_Strlen(Name);
+	Id.Hash = R_HashString(Name, Id.Len, 0);
+	return Id;
+}
+
+// --- Resource Slots ---
+
+fn_internal u64
+R_AtomicLoad( volatile u64* Value ) {
+#if defined(_MSC_VER)
+	return (u64)_InterlockedOr64((volatile long long*)Value, 0);
+#else
+	return __atomic_load_n(Value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+fn_internal void
+R_AtomicStore( volatile u64* Value, u64 New ) {
+#if defined(_MSC_VER)
+	_InterlockedExchange64((volatile long long*)Value, (long long)New);
+#else
+	__atomic_store_n(Value, New, __ATOMIC_RELEASE);
+#endif
+}
+
+fn_internal void
+R_SpinLock( volatile long* Lock ) {
+#if defined(_MSC_VER)
+	while (_InterlockedExchange(Lock, 1) != 0) {}
+#else
+	while (__atomic_exchange_n(Lock, 1, __ATOMIC_ACQUIRE) != 0) {}
+#endif
+}
+
+fn_internal void
+R_SpinUnlock( volatile long* Lock ) {
+#if defined(_MSC_VER)
+	_InterlockedExchange(Lock, 0);
+#else
+	__atomic_store_n(Lock, 0, __ATOMIC_RELEASE);
+#endif
+}
+
+fn_internal void
+R_SlotMapLock( r_slot_map* Map ) {
+	R_SpinLock(&Map->Lock);
+}
+
+fn_internal void
+R_SlotMapUnlock( r_slot_map* Map ) {
+	R_SpinUnlock(&Map->Lock);
+}
+
+fn_internal void
+R_SlotMapInit(r_slot_map* Map, Stack_Allocator* Allocator, u32 Capacity) {
+	memset(Map, 0, sizeof(r_slot_map));
+	Map->Slots     = stack_push(Allocator, r_slot, Capacity);
+	Map->Allocator = Allocator;
+	Map->Capacity  = Capacity;
+	assert(Map->Slots != NULL && "Not enough memory for the resource slots");
+	memset(Map->Slots, 0, sizeof(r_slot) * Capacity);
+
+	ConcurrentHashTableInit(&Map->Names, Capacity, R_HashBytes);
+}
+
+fn_internal void*
+R_SlotMapGet(r_slot_map* Map, R_Handle Handle) {
+	u32 Index = R_HANDLE_INDEX(Handle);
+	if (Handle == R_HANDLE_INVALID || Index >= Map->Capacity) {
+		return NULL;
+	}
+
+	// The value only counts if the generation is the handle's one before and
+	// after reading it, a destroy or reuse in between bumps it
+	//
+	r_slot* Slot       = &Map->Slots[Index];
+	u64     Generation = R_AtomicLoad(&Slot->Generation);
+	if ((u32)Generation != R_HANDLE_GENERATION(Handle)) {
+		return NULL;
+	}
+	u64 Value = R_AtomicLoad(&Slot->Value);
+	if (R_AtomicLoad(&Slot->Generation) != Generation) {
+		return NULL;
+	}
+	return (void*)(uintptr_t)Value;
+}
+
+// Names are keyed by hash, the slot keeps the text so a different name with
+// the same hash is never taken for this one
+//
+fn_internal bool
+R_SlotNameIs(r_slot* Slot, r_id Name) {
+	return Name.Str == NULL || SsoStringEq(&Slot->NameText, Name.Str, Name.Len);
+}
+
+fn_internal R_Handle
+R_SlotMapFind(r_slot_map* Map, r_id Name) {
+	R_Handle Handle = (R_Handle)(uintptr_t)ConcurrentHashTableGet(&Map->Names, Name.Hash);
+	if (Handle == R_HANDLE_INVALID || Name.Str == NULL) {
+		return Handle;
+	}
+
+	// Same generation check as R_SlotMapGet, the name of a slot destroyed or
+	// reused while it was compared does not count
+	//
+	r_slot* Slot       = &Map->Slots[R_HANDLE_INDEX(Handle)];
+	u64     Generation = R_AtomicLoad(&Slot->Generation);
+	if ((u32)Generation != R_HANDLE_GENERATION(Handle) || !R_SlotNameIs(Slot, Name) ||
+		R_AtomicLoad(&Slot->Generation) != Generation) {
+		return R_HANDLE_INVALID;
+	}
+	return Handle;
+}
+
+fn_internal bool
+R_SlotMapTryInsert(r_slot_map* Map, r_id Name, void* Value, R_Handle* Out) {
+	R_SlotMapLock(Map);
+
+	R_Handle Handle = (R_Handle)(uintptr_t)ConcurrentHashTableGet(&Map->Names, Name.Hash);
+	if (Handle != R_HANDLE_INVALID) {
+		r_slot* Taken = &Map->Slots[R_HANDLE_INDEX(Handle)];
+		if (!R_SlotNameIs(Taken, Name)) {
+			U8_String Other = SsoStringView(&Taken->NameText);
+			R_SlotMapUnlock(Map);
+			fprintf(stderr, "[ERROR] Resource names \"%.*s\" and \"%.*s\" have the same hash, rename one\n",
+					(int)Name.Len, Name.Str, (int)Other.len, (const char*)Other.data);
+			assert(!"Resource name hash collision");
+			*Out = R_HANDLE_INVALID;
+			return false;
+		}
+		R_SlotMapUnlock(Map);
+		*Out = Handle;
+		return false;
+	}
+
+	u32 Index = 0;
+	if (Map->FreeHead != 0) {
+		Index         = Map->FreeHead - 1;
+		Map->FreeHead = Map->Slots[Index].NextFree;
+	} else if (Map->Used < Map->Capacity) {
+		Index = Map->Used++;
+	} else {
+		R_SlotMapUnlock(Map);
+		fprintf(stderr, "[ERROR] Resource slot map is full (%u slots), raise R_MAX_RESOURCES\n", Map->Capacity);
+		assert(!"Resource slot map is full");
+		*Out = R_HANDLE_INVALID;
+		return false;
+	}
+
+	// Value first, the odd generation is what makes it visible
+	//
+	r_slot* Slot       = &Map->Slots[Index];
+	u64     Generation = Slot->Generation + 1;
+	Slot->Name = Name.Hash;
+	if (Name.Str != NULL) {
+		SsoStringCpy(&Slot->NameText, Name.Str, Name.Len, Map->Allocator);
+	} else {
+		SsoStringClear(&Slot->NameText);
+	}
+	R_AtomicStore(&Slot->Value, (u64)(uintptr_t)Value);
+	R_AtomicStore(&Slot->Generation, Generation);
+
+	Handle = ((R_Handle)(u32)Generation << 32) | Index;
+
+	hash_key Key = {};
+	Key.Hash = Name.Hash;
+	ConcurrentHashTableAdd(&Map->Names, Key, (void*)(uintptr_t)Handle);
+
+	R_SlotMapUnlock(Map);
+	*Out = Handle;
+	return true;
+}
+
+fn_internal R_Handle
+R_SlotMapInsert(r_slot_map* Map, r_id Name, void* Value) {
+	R_Handle Handle;
+	R_SlotMapTryInsert(Map, Name, Value, &Handle);
+	return Handle;
+}
+
+fn_internal void*
+R_SlotMapRemove(r_slot_map* Map, R_Handle Handle) {
+	u32 Index = R_HANDLE_INDEX(Handle);
+	if (Handle == R_HANDLE_INVALID || Index >= Map->Capacity) {
+		return NULL;
+	}
+
+	R_SlotMapLock(Map);
+
+	void*   Value = NULL;
+	r_slot* Slot  = &Map->Slots[Index];
+	if ((u32)Slot->Generation == R_HANDLE_GENERATION(Handle)) {
+		Value = (void*)(uintptr_t)Slot->Value;
+		R_AtomicStore(&Slot->Generation, Slot->Generation + 1);
+		R_AtomicStore(&Slot->Value, 0);
+
+		ConcurrentHashTableRemove(&Map->Names, Slot->Name);
+
+		Slot->NextFree = Map->FreeHead;
+		Map->FreeHead  = Index + 1;
+	}
+
+	R_SlotMapUnlock(Map);
+	return Value;
 }
 
 fn_internal void
@@ -22,11 +234,23 @@ R_RenderInit(r_render* Render, vulkan_base* Base, Stack_Allocator* Allocator) {
 	Render->Allocator      = Allocator;
 	Render->DescriptorPool = VK_NULL_HANDLE;
 	
-	stack_init(&Render->PerFrameAllocator, stack_push(Allocator, u8, mebibyte(12)), mebibyte(12));
-
-	HashTableInit(&Render->Textures,   Allocator, 1024, CustomXXHash);
-	HashTableInit(&Render->Buffers,    Allocator, 1024, CustomXXHash);
-	HashTableInit(&Render->Pipelines,  Allocator, 1024, CustomXXHash);
+	// The per frame allocator is hit every frame, pin it so it never faults.
+	// Over RLIMIT_MEMLOCK it is only prefaulted and a warning is logged once
+	//
+	AllocTraceMute();
+	u8* FrameMemory = stack_push(Allocator, u8, mebibyte(12));
+	AllocTraceUnmute();
+	ArenaPrefaultRange(FrameMemory, mebibyte(12), ARENA_PREFAULT_LOCK);
+	stack_init(&Render->PerFrameAllocator, FrameMemory, mebibyte(12));
+
+	R_SlotMapInit(&Render->Textures,  Allocator, R_MAX_RESOURCES);
+	R_SlotMapInit(&Render->Buffers,   Allocator, R_MAX_RESOURCES);
+	R_SlotMapInit(&Render->Pipelines, Allocator, R_MAX_RESOURCES);
+	Render->ResourceArena = ConcurrentArenaAlloc(mebibyte(64), kibibyte(4));
+	memset(Render->DeferredBuffers, 0, sizeof(Render->DeferredBuffers));
+	Render->FreeBuffers = NULL;
+	Render->DeferFrame  = 0;
+	Render->DeferLock   = 0;
 
 	Render->CurrentPipeline     = R_HANDLE_INVALID;
 	//Render->PendingBindings      = { 0 };
@@ -41,10 +265,40 @@ R_RenderInit(r_render* Render, vulkan_base* Base, Stack_Allocator* Allocator) {
     InitDescriptorPool(Render->VulkanBase, &Render->DescriptorPool, Render->VulkanBase->Device, 64 * 5, sizes, ArrayCount(sizes));
 }
 
+// PrepareFrame has waited the fence of this frame slot, whatever was destroyed
+// while this slot was the last one begun can't be used by the GPU anymore
+//
+fn_internal void
+R_FlushDeferredBuffers(r_render* Render, u32 Frame) {
+	R_SpinLock(&Render->DeferLock);
+	r_buffer_node* Node = Render->DeferredBuffers[Frame];
+	Render->DeferredBuffers[Frame] = NULL;
+	Render->DeferFrame = Frame;
+	R_SpinUnlock(&Render->DeferLock);
+
+	r_buffer_node* Last = NULL;
+	for (r_buffer_node* It = Node; It != NULL; It = It->Next) {
+		vmaDestroyBuffer(Render->VulkanBase->GPUAllocator, It->Buffer.Buffer, It->Buffer.Allocation);
+		Last = It;
+	}
+
+	if (Last != NULL) {
+		R_SpinLock(&Render->DeferLock);
+		Last->Next = Render->FreeBuffers;
+		Render->FreeBuffers = Node;
+		R_SpinUnlock(&Render->DeferLock);
+	}
+}
+
 fn_internal void R_Begin(r_render* Render) {
     vulkan_base* base = Render->VulkanBase;
 
+    // Scratch decommit delays count frames, not the pops of every draw
+    //
+    ArenaFrameBegin();
+
     bool resized = PrepareFrame(base);
+	R_FlushDeferredBuffers(Render, base->CurrentFrame);
 	Render->SetExternalResize = resized;
     if (resized) {
         // @todo How to handle this in a better way? Maybe set a customizable resizing function?
@@ -149,6 +403,19 @@ R_CreateDescriptorSetLayout(r_render* Render, u32 NSets, VkDescriptorType* Types
 	return SetLayout;
 }
 
+// The map only owns the pipeline if the insert stored it, a full map or an Id
+// that was already taken leaves it to us. Its descriptor sets go back with the pool
+//
+fn_internal R_Handle
+R_InsertPipeline(r_render* Render, const char* Id, vk_pipeline* Pipeline) {
+	R_Handle Handle;
+	if (!R_SlotMapTryInsert(&Render->Pipelines, R_IdFromString(Id), Pipeline, &Handle)) {
+		vkDestroyPipeline(Render->VulkanBase->Device, Pipeline->Pipeline, NULL);
+		vkDestroyPipelineLayout(Render->VulkanBase->Device, Pipeline->Layout, NULL);
+	}
+	return Handle;
+}
+
 fn_internal R_Handle
 R_CreatePipelineFromBuilder(
   r_render* Render, 
@@ -194,9 +461,7 @@ R_CreatePipelineFromBuilder(
     Pipeline->Descriptors[0] = DescriptorSetAllocate(&Render->DescriptorPool, Render->VulkanBase->Device, &DescriptorSetLayout[0]);
     Pipeline->Descriptors[1] = DescriptorSetAllocate(&Render->DescriptorPool, Render->VulkanBase->Device, &DescriptorSetLayout[0]);
   }
-	entry* Entry = HashTableAdd(&Render->Pipelines, Id, Pipeline, 0);
-
-	return (R_Handle)Entry->HashId;
+	return R_InsertPipeline(Render, Id, Pipeline);
 }
 
 fn_internal R_Handle 
@@ -249,9 +514,7 @@ R_CreatePipelineEx(
 	Pipeline->Descriptors[0] = DescriptorSetAllocate(&Render->DescriptorPool, Render->VulkanBase->Device, &DescriptorSetLayout[0]);
 	Pipeline->Descriptors[1] = DescriptorSetAllocate(&Render->DescriptorPool, Render->VulkanBase->Device, &DescriptorSetLayout[0]);
 
-	entry* Entry = HashTableAdd(&Render->Pipelines, Id, Pipeline, 0);
-
-	return (R_Handle)Entry->HashId;
+	return R_InsertPipeline(Render, Id, Pipeline);
 }
 
 fn_internal R_Handle 
@@ -311,9 +574,7 @@ R_CreateComputePipeline(
 	Pipeline->Descriptors[0] = DescriptorSetAllocate(&Render->DescriptorPool, Render->VulkanBase->Device, &DescriptorSetLayout[0]);
 	Pipeline->Descriptors[1] = DescriptorSetAllocate(&Render->DescriptorPool, Render->VulkanBase->Device, &DescriptorSetLayout[0]);
 
-	entry* Entry = HashTableAdd(&Render->Pipelines, Id, Pipeline, 0);
-
-	return (R_Handle)Entry->HashId;
+	return R_InsertPipeline(Render, Id, Pipeline);
 }
 
 
@@ -347,22 +608,51 @@ R_CreateBuffer(r_render* Render, const char* BufferId, u64 Size, r_buffer_type T
     // Llamar a la función de bajo nivel para crear el buffer real
     allocated_buffer newVkBuffer = CreateBuffer(base->GPUAllocator, Size, usage, memoryUsage);
 
-	allocated_buffer* NewBuffer = stack_push(Render->Allocator, allocated_buffer, 1);
-	*NewBuffer = newVkBuffer;
+	R_SpinLock(&Render->DeferLock);
+	r_buffer_node* Node = Render->FreeBuffers;
+	if (Node != NULL) {
+		Render->FreeBuffers = Node->Next;
+	}
+	R_SpinUnlock(&Render->DeferLock);
+	if (Node == NULL) {
+		Node = (r_buffer_node*)ConcurrentArenaPush(Render->ResourceArena, sizeof(r_buffer_node));
+	}
+	Node->Buffer = newVkBuffer;
+	Node->Next   = NULL;
+
+	R_Handle Handle;
+	if (!R_SlotMapTryInsert(&Render->Buffers, R_IdFromString(BufferId), &Node->Buffer, &Handle)) {
+		// Full, or BufferId already names a buffer. Nobody saw this one, it goes
+		// back right away
+		//
+		vmaDestroyBuffer(base->GPUAllocator, Node->Buffer.Buffer, Node->Buffer.Allocation);
+		R_SpinLock(&Render->DeferLock);
+		Node->Next = Render->FreeBuffers;
+		Render->FreeBuffers = Node;
+		R_SpinUnlock(&Render->DeferLock);
+	}
+	return Handle;
+}
 
-    entry* Entry = HashTableAdd(&Render->Buffers, BufferId, NewBuffer, 0);
-	R_Handle Handle = (R_Handle)Entry->HashId;
+// Frames in flight and readers that looked the buffer up before the remove can
+// still use it, the buffer waits in the list of the last frame begun
+//
+fn_internal void R_DestroyBuffer(r_render* Render, R_Handle Id) {
+	r_buffer_node* Node = (r_buffer_node*)R_SlotMapRemove(&Render->Buffers, Id);
+	if (Node != NULL) {
+		R_SpinLock(&Render->DeferLock);
+		Node->Next = Render->DeferredBuffers[Render->DeferFrame];
+		Render->DeferredBuffers[Render->DeferFrame] = Node;
+		R_SpinUnlock(&Render->DeferLock);
+	}
+}
 
-    return Handle;
+fn_internal void R_DestroyBuffer(r_render* Render, r_id Id) {
+	R_DestroyBuffer(Render, R_SlotMapFind(&Render->Buffers, Id));
 }
 
 fn_internal void R_DestroyBuffer(r_render* Render, const char* Id) {
-	entry* Entry = HashTableFindPointer(&Render->Buffers, Id, 0);
-	if (Entry != NULL) {
-		allocated_buffer* Buffer = (allocated_buffer*)Entry->Value;
-
-		vmaDestroyBuffer(Render->VulkanBase->GPUAllocator, Buffer->Buffer, Buffer->Allocation);
-	}
+	R_DestroyBuffer(Render, R_IdFromString(Id));
 }
 
 fn_internal void 
@@ -381,11 +671,10 @@ R_SetPipeline(r_render* Render, R_Handle Handle) {
 }
 
 fn_internal void 
-R_UpdateUniformBuffer(r_render* Render, const char* Id, u32 Binding, void* Data, size_t DataSize) {
+R_UpdateUniformBuffer(r_render* Render, R_Handle Id, u32 Binding, void* Data, size_t DataSize) {
 
-	entry* UboEntry = HashTableFindPointer(&Render->Buffers, Id, 0);
-	assert(UboEntry != NULL && "Invalid Id, Not Found");
-	allocated_buffer* Buffer = (allocated_buffer*)UboEntry->Value;
+	allocated_buffer* Buffer = (allocated_buffer*)R_SlotMapGet(&Render->Buffers, Id);
+	assert(Buffer != NULL && "Invalid or destroyed handle");
 	
     VkMappedMemoryRange flushRange = {};
     flushRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
@@ -401,32 +690,47 @@ R_UpdateUniformBuffer(r_render* Render, const char* Id, u32 Binding, void* Data,
 
     assert(Render->PendingBindingCount < MAX_PENDING_BINDINGS);
     pending_binding* p = &Render->PendingBindings[Render->PendingBindingCount++];
-    p->Handle       = (R_Handle)UboEntry->HashId;
+    p->Handle       = Id;
     p->BindingPoint = Binding;
     p->Type         = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	p->Range        = DataSize;
 }
 
 fn_internal void 
-R_BindTexture(r_render* Render, const char* Id, u32 Binding, VkDescriptorType Type) {
+R_UpdateUniformBuffer(r_render* Render, r_id Id, u32 Binding, void* Data, size_t DataSize) {
+	R_UpdateUniformBuffer(Render, R_SlotMapFind(&Render->Buffers, Id), Binding, Data, DataSize);
+}
+
+fn_internal void 
+R_UpdateUniformBuffer(r_render* Render, const char* Id, u32 Binding, void* Data, size_t DataSize) {
+	R_UpdateUniformBuffer(Render, R_IdFromString(Id), Binding, Data, DataSize);
+}
+
+fn_internal void 
+R_BindTexture(r_render* Render, R_Handle Id, u32 Binding, VkDescriptorType Type) {
 
-	entry* TexEntry = HashTableFindPointer(&Render->Textures, Id, 0);
-	assert(TexEntry != NULL && "Invalid Id, Not Found");
+	assert(R_SlotMapGet(&Render->Textures, Id) != NULL && "Invalid or destroyed handle");
 
 	assert(Render->PendingBindingCount < MAX_PENDING_BINDINGS);
     pending_binding* p = &Render->PendingBindings[Render->PendingBindingCount++];
-    p->Handle       = (R_Handle)TexEntry->HashId;
+    p->Handle       = Id;
     p->BindingPoint = Binding;
     p->Type         = Type;
 }
 
-fn_internal R_Handle 
-R_PushTexture(r_render* Render, const char* Id, vk_image* Image) {
-	entry* Entry = HashTableAdd(&Render->Textures, Id, Image, 0);
+fn_internal void 
+R_BindTexture(r_render* Render, r_id Id, u32 Binding, VkDescriptorType Type) {
+	R_BindTexture(Render, R_SlotMapFind(&Render->Textures, Id), Binding, Type);
+}
 
-	assert(Entry != NULL && "Could set new entry for image on the Hash table");
+fn_internal void 
+R_BindTexture(r_render* Render, const char* Id, u32 Binding, VkDescriptorType Type) {
+	R_BindTexture(Render, R_IdFromString(Id), Binding, Type);
+}
 
-	return (R_Handle)Entry->HashId;
+fn_internal R_Handle 
+R_PushTexture(r_render* Render, const char* Id, vk_image* Image) {
+	return R_SlotMapInsert(&Render->Textures, R_IdFromString(Id), Image);
 }
 
 void R_Draw(r_render* Render, u32 VertexCount, u32 InstanceCount) {
@@ -435,13 +739,14 @@ void R_Draw(r_render* Render, u32 VertexCount, u32 InstanceCount) {
     vulkan_base* base = Render->VulkanBase;
     VkCommandBuffer cmd = Render->CurrentCommandBuffer;
 
-    vk_pipeline* pipeline = (vk_pipeline*)HashTableGet(&Render->Pipelines, Render->CurrentPipeline, 0);
+    vk_pipeline* pipeline = (vk_pipeline*)R_SlotMapGet(&Render->Pipelines, Render->CurrentPipeline);
     assert(pipeline != NULL && "CurrentPipeline handle is invalid or not found in resource manager.");
 
     if (Render->PendingBindingCount > 0) {
       VkDescriptorSet set_for_this_frame = pipeline->Descriptors[Render->VulkanBase->CurrentFrame];
 
-        descriptor_writer writer = DescriptorWriterInit(Render->PendingBindingCount, &Render->PerFrameAllocator);
+        Temp Scratch = GetScratch(NULL, 0);
+        descriptor_writer writer = DescriptorWriterInit(Render->PendingBindingCount, Scratch.arena);
 
         for (u32 i = 0; i < Render->PendingBindingCount; ++i) {
             pending_binding* p = &Render->PendingBindings[i];
@@ -449,21 +754,21 @@ void R_Draw(r_render* Render, u32 VertexCount, u32 InstanceCount) {
             switch (p->Type) {
 				case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
 				{
-					allocated_buffer* buf = (allocated_buffer*)HashTableGet(&Render->Buffers, p->Handle, 0);
+					allocated_buffer* buf = (allocated_buffer*)R_SlotMapGet(&Render->Buffers, p->Handle);
 					assert(buf != NULL && "Buffer handle for pending binding not found.");
                     
 					WriteBuffer(&writer, p->BindingPoint, buf->Buffer, buf->Info.size, 0, p->Type);
 				} break;
                 case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
                 {
-                    allocated_buffer* buf = (allocated_buffer*)HashTableGet(&Render->Buffers, p->Handle, 0);
+                    allocated_buffer* buf = (allocated_buffer*)R_SlotMapGet(&Render->Buffers, p->Handle);
                     assert(buf != NULL && "Buffer handle for pending binding not found.");
                     
                     WriteBuffer(&writer, p->BindingPoint, buf->Buffer, buf->Info.size, 0, p->Type);
                 } break;
                 case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
                 {
-                    vk_image* tex = (vk_image*)HashTableGet(&Render->Textures, p->Handle, 0);
+                    vk_image* tex = (vk_image*)R_SlotMapGet(&Render->Textures, p->Handle);
                     assert(tex != NULL && "Texture handle for pending binding not found.");
 
                     WriteImage(&writer, p->BindingPoint, tex->ImageView, tex->Sampler, 
@@ -476,6 +781,7 @@ void R_Draw(r_render* Render, u32 VertexCount, u32 InstanceCount) {
         }
         
         UpdateDescriptorSet(&writer, base->Device, set_for_this_frame);
+        ReleaseScratch(Scratch);
         
         vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, 
                                 pipeline->Layout, 0, 1, &set_for_this_frame, 0, NULL);
@@ -483,7 +789,7 @@ void R_Draw(r_render* Render, u32 VertexCount, u32 InstanceCount) {
     
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->Pipeline);
 
-    allocated_buffer* vb = (allocated_buffer*)HashTableGet(&Render->Buffers, Render->CurrentVertexBuffer, 0);
+    allocated_buffer* vb = (allocated_buffer*)R_SlotMapGet(&Render->Buffers, Render->CurrentVertexBuffer);
     VkBuffer Buffers[] = {vb->Buffer};
     VkDeviceSize offsets[] = {0};
     vkCmdBindVertexBuffers(cmd, 0, 1, Buffers, offsets);
@@ -502,34 +808,35 @@ R_DrawIndexed(r_render* Render, u32 IndexCount, u32 InstanceCount) {
     vulkan_base*   base = Render->VulkanBase;
     VkCommandBuffer cmd = Render->CurrentCommandBuffer;
 
-    vk_pipeline* pipeline = (vk_pipeline*)HashTableGet(&Render->Pipelines, Render->CurrentPipeline, 0);
+    vk_pipeline* pipeline = (vk_pipeline*)R_SlotMapGet(&Render->Pipelines, Render->CurrentPipeline);
     assert(pipeline != NULL && "CurrentPipeline handle is invalid or not found.");
 	
 	VkDescriptorSet Set = pipeline->Descriptors[Render->VulkanBase->CurrentFrame];
 
     if (Render->PendingBindingCount > 0) {
-        descriptor_writer writer = DescriptorWriterInit(Render->PendingBindingCount, &Render->PerFrameAllocator);
+        Temp Scratch = GetScratch(NULL, 0);
+        descriptor_writer writer = DescriptorWriterInit(Render->PendingBindingCount, Scratch.arena);
 
         for (u32 i = 0; i < Render->PendingBindingCount; ++i) {
             pending_binding* p = &Render->PendingBindings[i];
             switch (p->Type) {
 				case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
 				{
-					allocated_buffer* buf = (allocated_buffer*)HashTableGet(&Render->Buffers, p->Handle, 0);
+					allocated_buffer* buf = (allocated_buffer*)R_SlotMapGet(&Render->Buffers, p->Handle);
 					assert(buf != NULL && "Buffer handle for pending binding not found.");
                     
 					WriteBuffer(&writer, p->BindingPoint, buf->Buffer, p->Range, 0, p->Type);
 				} break;
                 case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
                 {
-                    allocated_buffer* buf = (allocated_buffer*)HashTableGet(&Render->Buffers, p->Handle, 0);
+                    allocated_buffer* buf = (allocated_buffer*)R_SlotMapGet(&Render->Buffers, p->Handle);
                     assert(buf != NULL && "Buffer handle for pending binding not found.");
                     
                     WriteBuffer(&writer, p->BindingPoint, buf->Buffer, buf->Info.size, 0, p->Type);
                 } break;
                 case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
                 {
-                    vk_image* tex = (vk_image*)HashTableGet(&Render->Textures, p->Handle, 0);
+                    vk_image* tex = (vk_image*)R_SlotMapGet(&Render->Textures, p->Handle);
                     assert(tex != NULL && "Texture handle for pending binding not found.");
 
                     WriteImage(&writer, p->BindingPoint, tex->ImageView, tex->Sampler, 
@@ -543,18 +850,19 @@ R_DrawIndexed(r_render* Render, u32 IndexCount, u32 InstanceCount) {
         }
         
         UpdateDescriptorSet(&writer, base->Device, Set);
+        ReleaseScratch(Scratch);
     }
     
 	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->Layout, 0, 1, &Set, 0, NULL);
 
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->Pipeline);
     
-    allocated_buffer* vb = (allocated_buffer*)HashTableGet(&Render->Buffers, Render->CurrentVertexBuffer, 0);
+    allocated_buffer* vb = (allocated_buffer*)R_SlotMapGet(&Render->Buffers, Render->CurrentVertexBuffer);
 	VkBuffer Buffers[] = {vb->Buffer};
 	VkDeviceSize offsets[] = {0};
     vkCmdBindVertexBuffers(cmd, 0, 1, Buffers, offsets);
     
-    allocated_buffer* ib = (allocated_buffer*)HashTableGet(&Render->Buffers, Render->CurrentIndexBuffer, 0);
+    allocated_buffer* ib = (allocated_buffer*)R_SlotMapGet(&Render->Buffers, Render->CurrentIndexBuffer);
     vkCmdBindIndexBuffer(cmd, ib->Buffer, 0, VK_INDEX_TYPE_UINT32);
 
     vkCmdDrawIndexed(cmd, IndexCount, InstanceCount, 0, 0, 0);
@@ -564,7 +872,7 @@ R_DrawIndexed(r_render* Render, u32 IndexCount, u32 InstanceCount) {
 
 fn_internal void 
 R_SendDataToBuffer(r_render* Render, R_Handle Buffer, void* Data, u64 Size, u64 offset) {
-  allocated_buffer* vb = (allocated_buffer*)HashTableGet(&Render->Buffers, Buffer, 0);
+  allocated_buffer* vb = (allocated_buffer*)R_SlotMapGet(&Render->Buffers, Buffer);
 
   memcpy(
     (u8*)vb->Info.pMappedData + offset,
@@ -582,8 +890,8 @@ R_SendDataToBuffer(r_render* Render, R_Handle Buffer, void* Data, u64 Size, u64
 
 fn_internal void
 R_CopyStageToBuffer(r_render* Render, R_Handle StageBuffer, R_Handle Buffer, VkBufferCopy Copy) {
-	allocated_buffer* sb = (allocated_buffer*)HashTableGet(&Render->Buffers, StageBuffer, 0);
-	allocated_buffer* vb = (allocated_buffer*)HashTableGet(&Render->Buffers, Buffer, 0);
+	allocated_buffer* sb = (allocated_buffer*)R_SlotMapGet(&Render->Buffers, StageBuffer);
+	allocated_buffer* vb = (allocated_buffer*)R_SlotMapGet(&Render->Buffers, Buffer);
 
 	vkCmdCopyBuffer(
 		Render->CurrentCommandBuffer,
@@ -600,7 +908,7 @@ R_DispatchCompute(r_render* Render, R_Handle PipelineHandle, u32 GroupCountX, u3
     assert(PipelineHandle != R_HANDLE_INVALID && "Pipeline de cómputo inválido");
     vulkan_base* base = Render->VulkanBase;
     VkCommandBuffer cmd = Render->CurrentCommandBuffer;
-    vk_pipeline* pipeline = (vk_pipeline*)HashTableGet(&Render->Pipelines, PipelineHandle, 0);
+    vk_pipeline* pipeline = (vk_pipeline*)R_SlotMapGet(&Render->Pipelines, PipelineHandle);
     assert(pipeline != NULL && "Pipeline de cómputo no encontrado.");
 
     // 2. Bindear el pipeline de CÓMPUTO
@@ -610,7 +918,8 @@ R_DispatchCompute(r_render* Render, R_Handle PipelineHandle, u32 GroupCountX, u3
     VkDescriptorSet set_for_this_frame = pipeline->Descriptors[base->CurrentFrame];
 
     if (Render->PendingBindingCount > 0) {
-        descriptor_writer writer = DescriptorWriterInit(Render->PendingBindingCount, &Render->PerFrameAllocator);
+        Temp Scratch = GetScratch(NULL, 0);
+        descriptor_writer writer = DescriptorWriterInit(Render->PendingBindingCount, Scratch.arena);
 
         for (u32 i = 0; i < Render->PendingBindingCount; ++i) {
             pending_binding* p = &Render->PendingBindings[i];
@@ -618,14 +927,14 @@ R_DispatchCompute(r_render* Render, R_Handle PipelineHandle, u32 GroupCountX, u3
                 case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
                 case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
                 {
-                    allocated_buffer* buf = (allocated_buffer*)HashTableGet(&Render->Buffers, p->Handle, 0);
+                    allocated_buffer* buf = (allocated_buffer*)R_SlotMapGet(&Render->Buffers, p->Handle);
                     WriteBuffer(&writer, p->BindingPoint, buf->Buffer, p->Range, 0, p->Type);
                     break;
                 }
                 case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
                 case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE: // Importante para cómputo
                 {
-                    vk_image* tex = (vk_image*)HashTableGet(&Render->Textures, p->Handle, 0);
+                    vk_image* tex = (vk_image*)R_SlotMapGet(&Render->Textures, p->Handle);
                     // (Asegúrate de que WriteImage maneje STORAGE_IMAGE y el layout correcto)
                     WriteImage(&writer, p->BindingPoint, tex->ImageView, tex->Sampler, 
                                VK_IMAGE_LAYOUT_GENERAL, p->Type);
@@ -637,6 +946,7 @@ R_DispatchCompute(r_render* Render, R_Handle PipelineHandle, u32 GroupCountX, u3
             }
         }
         UpdateDescriptorSet(&writer, base->Device, set_for_this_frame);
+        ReleaseScratch(Scratch);
     }
     
     // 4. Bindear el descriptor set al punto de CÓMPUTO
@@ -676,7 +986,7 @@ R_AddComputeToGraphicsBarrier(r_render* Render) {
 
 fn_internal void 
 R_SendImageToSwapchain(r_render* Render, R_Handle ImageHandle) {
-	vk_image* computeImage = (vk_image*)HashTableGet(&Render->Textures, ImageHandle, 0);
+	vk_image* computeImage = (vk_image*)R_SlotMapGet(&Render->Textures, ImageHandle);
     if (computeImage == NULL) {
         return;
     }
@@ -15,13 +15,104 @@
 /**
 	* @brief An opaque handle representing a rendering resource.
 	* @details This is used to reference resources like buffers, textures, and pipelines
-	* without exposing the underlying Vulkan implementation details.
+	* without exposing the underlying Vulkan implementation details. The low 32 bits
+	* are a slot index and the high 32 bits the generation of that slot when the
+	* resource was created, so resolving is an array index and a handle to a
+	* destroyed resource resolves to NULL instead of whatever reused its slot.
 	*/
 typedef u64 R_Handle;
 
 /** @brief A special value indicating an invalid or uninitialized resource handle. */
 #define R_HANDLE_INVALID 0
 
+#define R_HANDLE_INDEX(Handle)      ((u32)(Handle))
+#define R_HANDLE_GENERATION(Handle) ((u32)((Handle) >> 32))
+
+/** @brief Slots per resource kind, handles index a fixed array so it never moves. */
+#ifndef R_MAX_RESOURCES
+#define R_MAX_RESOURCES 4096
+#endif
+
+/**
+	* @brief Hash of a resource name. Names are only looked up to get a handle, see R_ID.
+	* @details FNV-1a followed by the murmur3 finalizer so the low bits used by the
+	* hash table are well mixed. It is constexpr, so R_ID can compute it at compile time.
+	*/
+constexpr u64 R_HashString(const char* Str, u64 Len, u64 Seed) {
+	u64 Hash = 0xCBF29CE484222325ull ^ Seed;
+	for (u64 i = 0; i < Len; i += 1) {
+		Hash ^= (u8)Str[i];
+		Hash *= 0x100000001B3ull;
+	}
+	Hash ^= Hash >> 33;
+	Hash *= 0xFF51AFD7ED558CCDull;
+	Hash ^= Hash >> 33;
+	Hash *= 0xC4CEB9FE1A85EC53ull;
+	Hash ^= Hash >> 33;
+	return Hash;
+}
+
+/**
+	* @brief A resource name already hashed, a different type than R_Handle so overloads can tell them apart.
+	* @details Str is kept so the slot map can tell two names with the same hash apart,
+	* an r_id with a NULL Str matches on the hash alone.
+	*/
+typedef struct r_id {
+	u64         Hash;
+	const char* Str;
+	u64         Len;
+} r_id;
+
+template <u64 Hash>
+struct r_id_constant {
+	static constexpr r_id Value = { Hash };
+};
+
+/**
+	* @brief Compile-time id of a resource name. Only for string literals. Passing it
+	* costs one name lookup, keep the R_Handle from creation for the hot paths.
+	* @code R_BindTexture(Render, R_ID("Fonts Atlas"), 0, Type); @endcode
+	*/
+#define R_ID(Str) (r_id{ r_id_constant<R_HashString(Str, sizeof(Str) - 1, 0)>::Value.Hash, Str, sizeof(Str) - 1 })
+
+/**
+	* @brief One resource slot. Generation is odd while the slot holds a resource and
+	* goes up by one on every create and destroy.
+	*/
+typedef struct r_slot {
+	volatile u64 Generation;
+	volatile u64 Value;
+	u64          Name;         /**< Name hash, to drop it from the names on destroy. */
+	sso_string   NameText;     /**< The name itself, compared on every lookup by name. */
+	u32          NextFree;     /**< Free list link, index + 1. */
+} r_slot;
+
+/**
+	* @brief Generational slot map of one resource kind plus its name to handle table.
+	* @details Lookups by handle are lock free, creates and destroys take Lock. A
+	* reader checks the generation before and after reading the value, so it never
+	* returns a value from a slot that was destroyed or reused while it read.
+	*/
+typedef struct r_slot_map {
+	r_slot*               Slots;
+	Stack_Allocator*      Allocator; /**< Names longer than SSO_STRING_INLINE. */
+	u32                   Capacity;
+	u32                   Used;     /**< Slots ever handed out, the rest were never touched. */
+	u32                   FreeHead; /**< Index + 1, 0 when empty. */
+	volatile long         Lock;
+	concurrent_hash_table Names;    /**< Name hash to R_Handle, the slot's NameText confirms the name. */
+} r_slot_map;
+
+/**
+	* @brief Record of one buffer. The slot map hands out &Node->Buffer, Next links it
+	* into a deferred destroy list and then into the free records.
+	*/
+typedef struct r_buffer_node r_buffer_node;
+struct r_buffer_node {
+	allocated_buffer Buffer; /**< First, so the slot map value is the node too. */
+	r_buffer_node*   Next;
+};
+
 /** @brief The maximum number of resource bindings that can be queued for a single draw call. */
 #define MAX_PENDING_BINDINGS 16
 
@@ -98,9 +189,24 @@ struct r_render {
   vulkan_base* VulkanBase;        /**< A pointer to the low-level Vulkan backend context. */
   VkDescriptorPool DescriptorPool;    /**< The global descriptor pool used for allocating descriptor sets. */
 
-  hash_table  Textures;          /**< A hash table mapping R_Handles to fn_internal texture resources. */
-  hash_table  Buffers;           /**< A hash table mapping R_Handles to fn_internal buffer resources. */
-	hash_table  Pipelines;
+  /**
+	* @brief Resources by R_Handle. Lookups are lock free, so loader threads can
+	* R_PushTexture or R_CreateBuffer while the render thread draws.
+	*/
+  r_slot_map            Textures;
+  r_slot_map            Buffers;
+	r_slot_map            Pipelines;
+  ConcurrentArena*      ResourceArena; /**< Buffer records, pushed from any thread. */
+
+  /**
+	* @brief Buffers destroyed while a frame could still use them. A buffer goes in the
+	* list of the last frame begun and is freed when R_Begin has waited that frame's
+	* fence again, then its record goes to FreeBuffers for the next R_CreateBuffer.
+	*/
+  r_buffer_node*        DeferredBuffers[MAX_FRAMES_IN_FLIGHT];
+  r_buffer_node*        FreeBuffers;
+  u32                   DeferFrame;    /**< Frame slot destroys go to. */
+  volatile long         DeferLock;
 
   R_Handle         CurrentPipeline;      /**< The handle of the graphics pipeline currently bound for rendering. */
 	R_Handle         CurrentVertexBuffer;
@@ -116,6 +222,21 @@ struct r_render {
 	bool SetExternalResize;
 };
 
+// --- Resource Slots ---
+
+/** @brief Slot map of Capacity slots taken from Allocator. */
+fn_internal void     R_SlotMapInit(r_slot_map* Map, Stack_Allocator* Allocator, u32 Capacity);
+/** @brief Stores Value under Name, or returns the handle Name already has. Logs and returns R_HANDLE_INVALID when full, Value is still the caller's then. */
+fn_internal R_Handle R_SlotMapInsert(r_slot_map* Map, r_id Name, void* Value);
+/** @brief Same, true only if Value was stored. Otherwise *Out is Name's existing handle or R_HANDLE_INVALID when full or when another name has the same hash. */
+fn_internal bool     R_SlotMapTryInsert(r_slot_map* Map, r_id Name, void* Value, R_Handle* Out);
+/** @brief Lock free, NULL for a stale or invalid handle. */
+fn_internal void*    R_SlotMapGet(r_slot_map* Map, R_Handle Handle);
+/** @brief Handle of a name, R_HANDLE_INVALID if there is none. Checks the stored name, not only the hash. */
+fn_internal R_Handle R_SlotMapFind(r_slot_map* Map, r_id Name);
+/** @brief Frees the slot for reuse and returns what it held, NULL if the handle was stale. */
+fn_internal void*    R_SlotMapRemove(r_slot_map* Map, R_Handle Handle);
+
 // --- Lifecycle and Frame Management ---
 
 /**
@@ -199,16 +320,21 @@ fn_internal R_Handle R_CreateComputePipeline(
 	* @param Render A pointer to the renderer context.
 	* @param Size The total size of the buffer in bytes.
 	* @param Type The intended usage of the buffer (e.g., vertex, index, uniform).
-	* @return An `R_Handle` to the newly created buffer.
+	* @return An `R_Handle` to the newly created buffer, `R_HANDLE_INVALID` if the map is full.
+	*         If BufferId is taken the existing handle comes back and the new buffer is destroyed.
 	*/
 fn_internal R_Handle R_CreateBuffer(r_render* Render, const char* BufferId, u64 Size, r_buffer_type Type);
 
 /**
 	* @brief Destroys a previously created buffer and releases its resources.
+	* @details The handle is dead right away, the buffer itself is freed once the frames
+	* in flight that could use it are done. Callable from any thread.
 	* @param Render A pointer to the renderer context.
 	* @param Handle The handle of the buffer to destroy.
 	*/
 fn_internal void R_DestroyBuffer(r_render* Render, const char* Id);
+fn_internal void R_DestroyBuffer(r_render* Render, R_Handle Id);
+fn_internal void R_DestroyBuffer(r_render* Render, r_id Id);
 
 // --- State Binding and Drawing Commands ---
 
@@ -221,6 +347,10 @@ fn_internal void R_DestroyBuffer(r_render* Render, const char* Id);
 	* @param DataSize The size of the data to copy.
 	*/
 fn_internal void R_UpdateUniformBuffer(r_render* Render, const char* Id, u32 Binding, void* Data, size_t DataSize);
+/** @brief Same as above with the handle from R_CreateBuffer, no lookup at all. */
+fn_internal void R_UpdateUniformBuffer(r_render* Render, R_Handle Id, u32 Binding, void* Data, size_t DataSize);
+/** @brief Same as above with the id from R_ID, one name lookup and no hashing. */
+fn_internal void R_UpdateUniformBuffer(r_render* Render, r_id Id, u32 Binding, void* Data, size_t DataSize);
 
 /**
 	* @brief Binds a storage buffer (SSBO) to a shader location for read-only access.
@@ -235,6 +365,8 @@ fn_internal void R_BindStorageBuffer(r_render* Render, R_Handle BufferHandle, u3
 	* @param Render  A pointer to the renderer context.
 	* @param Id      The id of the texture to bind.
 	* @param Image   A pointer to the image texture.
+	* @return The texture's handle, `R_HANDLE_INVALID` if the map is full. The map never
+	*         destroys Image, on failure it is still the caller's.
 */
 fn_internal R_Handle R_PushTexture(r_render* Render, const char* Id, vk_image* Image);
 
@@ -245,6 +377,10 @@ fn_internal R_Handle R_PushTexture(r_render* Render, const char* Id, vk_image* I
 	* @param Binding The binding point in the shader.
 	*/
 fn_internal void R_BindTexture(r_render* Render, const char* Id, u32 Binding, VkDescriptorType Type );
+/** @brief Same as above with the handle from R_PushTexture, no lookup at all. */
+fn_internal void R_BindTexture(r_render* Render, R_Handle Id, u32 Binding, VkDescriptorType Type );
+/** @brief Same as above with the id from R_ID, one name lookup and no hashing. */
+fn_internal void R_BindTexture(r_render* Render, r_id Id, u32 Binding, VkDescriptorType Type );
 
 fn_internal void R_BindVertexBuffer(r_render* Render, R_Handle Handle);
 
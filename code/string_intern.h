@@ -0,0 +1,261 @@
+#ifndef _STRING_INTERN_H_
+#define _STRING_INTERN_H_
+
+// Every distinct string stored once and named by a small integer. Interning
+// hashes the string once and hands out its str_id, the same text always gets
+// the same id, so comparing two interned strings is comparing two u32. The
+// text stays where it was put until the pool is released: the U8_String and
+// the pointer returned for an id are valid for the pool's whole life and must
+// not be written to.
+//
+// Nothing is ever removed, a pool fed text that changes all the time (frame
+// counters, timings) grows all the time. Not thread safe.
+//
+// Ids index the entry array. The lookup table holds the id plus the top 32
+// bits of the hash in one u64, so a probe only reads an entry when those
+// match. It grows by rebuilding from the entries, which keep their hash.
+//
+
+#include "types.h"
+#include "memory.h"
+#include "strings.h"
+
+#ifndef INTERN_POOL_RESERVE
+#define INTERN_POOL_RESERVE gigabyte((U64)1)
+#endif
+
+#define INTERN_POOL_MIN_SLOTS  1024
+#define INTERN_POOL_LOAD       70
+#define INTERN_POOL_ENTRY_GROW 64 // entries per push, 64 * 24 bytes is a multiple of the arena alignment
+
+typedef u32 str_id;
+
+// The empty string, also what a lookup that found nothing returns
+//
+#define STR_ID_NONE 0
+
+typedef struct intern_entry intern_entry;
+struct intern_entry {
+    U64 Hash;
+    u8* Data;   // NUL terminated
+    u32 Len;
+};
+
+typedef struct intern_pool intern_pool;
+struct intern_pool {
+    Arena* TextArena;
+    Arena* EntryArena;
+    Arena* SlotArena;
+
+    intern_entry* Entries;  // by id, Entries[0] is the empty string
+    u32           Count;    // ids handed out, 0 included
+    u32           Capacity;
+
+    U64* Slots;             // hash top bits << 32 | id, 0 is empty
+    U64  SlotMask;
+
+    U64 (*HashFunction)(const U8* key, U64 length, U64 seed);
+};
+
+/**
+ * @brief Inits a pool, it reserves its own arenas
+ * @param HashFunction  hash for the strings, a built in one if NULL
+ */
+void   InternPoolInit(intern_pool* Pool, U64 (*HashFunction)(const U8* key, U64 length, U64 seed));
+void   InternPoolRelease(intern_pool* Pool);
+
+/**
+ * @brief Id of Str, storing a copy the first time it is seen
+ * @return str_id STR_ID_NONE for the empty string or when the pool is full
+ */
+str_id InternN(intern_pool* Pool, const char* Str, u64 Len);
+str_id Intern(intern_pool* Pool, const char* Str);
+str_id InternStr(intern_pool* Pool, U8_String* Str);
+
+/**
+ * @brief Id of Str if it was interned already, STR_ID_NONE if not
+ */
+str_id InternFind(intern_pool* Pool, const char* Str, u64 Len);
+
+fn_internal u32         InternLength(intern_pool* Pool, str_id Id)  { return Pool->Entries[Id].Len; }
+fn_internal const char* InternCString(intern_pool* Pool, str_id Id) { return (const char*)Pool->Entries[Id].Data; }
+fn_internal U64         InternHash(intern_pool* Pool, str_id Id)    { return Pool->Entries[Id].Hash; }
+
+// len is the length too, so the strings.h calls that write check against it
+// and never touch the pool's text
+//
+fn_internal U8_String InternGetString(intern_pool* Pool, str_id Id) {
+    U8_String Str = {};
+    Str.data = Pool->Entries[Id].Data;
+    Str.len  = Pool->Entries[Id].Len;
+    Str.idx  = Pool->Entries[Id].Len;
+    return Str;
+}
+
+#endif // _STRING_INTERN_H_
+
+#ifdef STRING_INTERN_IMPL
+
+// 8 bytes per round with a multiply and rotate, splitmix64's finalizer at
+// the end
+//
+static U64 InternDefaultHash(const U8* Key, U64 Len, U64 Seed) {
+    U64 Hash = Seed ^ (Len * 0x9E3779B97F4A7C15ull);
+    U64 i    = 0;
+    for( ; i + 8 <= Len; i += 8 ) {
+        U64 Word;
+        memcpy(&Word, Key + i, 8);
+        Hash ^= Word * 0x9E3779B97F4A7C15ull;
+        Hash  = ((Hash << 31) | (Hash >> 33)) * 0xBF58476D1CE4E5B9ull;
+    }
+    if( i < Len ) {
+        U64 Word = 0;
+        memcpy(&Word, Key + i, Len - i);
+        Hash ^= Word * 0x9E3779B97F4A7C15ull;
+        Hash  = ((Hash << 31) | (Hash >> 33)) * 0xBF58476D1CE4E5B9ull;
+    }
+    Hash ^= Hash >> 30;
+    Hash *= 0xBF58476D1CE4E5B9ull;
+    Hash ^= Hash >> 27;
+    Hash *= 0x94D049BB133111EBull;
+    Hash ^= Hash >> 31;
+    return Hash;
+}
+
+static U64 InternSlot(U64 Hash, str_id Id) {
+    return (Hash & 0xFFFFFFFF00000000ull) | Id;
+}
+
+static bool InternAllocSlots(intern_pool* Pool, U64 Count) {
+    ArenaClear(Pool->SlotArena);
+    U64* Slots = PushArray(Pool->SlotArena, U64, Count);
+    if( Slots == NULL ) {
+        return false;
+    }
+    memset(Slots, 0, Count * sizeof(U64));
+    Pool->Slots    = Slots;
+    Pool->SlotMask = Count - 1;
+
+    for( str_id Id = 1; Id < Pool->Count; Id += 1 ) {
+        U64 Hash = Pool->Entries[Id].Hash;
+        U64 Idx  = Hash & Pool->SlotMask;
+        while( Slots[Idx] != 0 ) {
+            Idx = (Idx + 1) & Pool->SlotMask;
+        }
+        Slots[Idx] = InternSlot(Hash, Id);
+    }
+    return true;
+}
+
+void InternPoolInit(intern_pool* Pool, U64 (*HashFunction)(const U8* key, U64 length, U64 seed)) {
+    memset(Pool, 0, sizeof(intern_pool));
+    Pool->HashFunction = HashFunction != NULL ? HashFunction : InternDefaultHash;
+    Pool->TextArena    = ArenaAlloc(INTERN_POOL_RESERVE);
+    Pool->EntryArena   = ArenaAlloc(INTERN_POOL_RESERVE);
+    Pool->SlotArena    = ArenaAlloc(INTERN_POOL_RESERVE);
+
+    // Entries are the only thing in their arena, so they grow in place
+    //
+    Pool->Entries  = PushArray(Pool->EntryArena, intern_entry, INTERN_POOL_ENTRY_GROW);
+    Pool->Capacity = INTERN_POOL_ENTRY_GROW;
+    Pool->Entries[0].Hash = 0;
+    Pool->Entries[0].Data = PushArray(Pool->TextArena, u8, 1);
+    Pool->Entries[0].Data[0] = 0;
+    Pool->Entries[0].Len  = 0;
+    Pool->Count = 1;
+
+    InternAllocSlots(Pool, INTERN_POOL_MIN_SLOTS);
+}
+
+void InternPoolRelease(intern_pool* Pool) {
+    ArenaRelease(Pool->SlotArena);
+    ArenaRelease(Pool->EntryArena);
+    ArenaRelease(Pool->TextArena);
+    memset(Pool, 0, sizeof(intern_pool));
+}
+
+// Slot holding Str, or the empty slot where it would go
+//
+static U64 InternProbe(intern_pool* Pool, const char* Str, u64 Len, U64 Hash) {
+    U64 Idx  = Hash & Pool->SlotMask;
+    U64 Top  = Hash & 0xFFFFFFFF00000000ull;
+    for( ;; ) {
+        U64 Slot = Pool->Slots[Idx];
+        if( Slot == 0 ) {
+            return Idx;
+        }
+        if( (Slot & 0xFFFFFFFF00000000ull) == Top ) {
+            intern_entry* Entry = &Pool->Entries[(str_id)Slot];
+            if( Entry->Len == Len && memcmp(Entry->Data, Str, Len) == 0 ) {
+                return Idx;
+            }
+        }
+        Idx = (Idx + 1) & Pool->SlotMask;
+    }
+}
+
+str_id InternFind(intern_pool* Pool, const char* Str, u64 Len) {
+    if( Len == 0 ) {
+        return STR_ID_NONE;
+    }
+    U64 Hash = Pool->HashFunction((const U8*)Str, Len, 0);
+    return (str_id)Pool->Slots[InternProbe(Pool, Str, Len, Hash)];
+}
+
+str_id InternN(intern_pool* Pool, const char* Str, u64 Len) {
+    if( Len == 0 || Len > 0xFFFFFFFFull ) {
+        return STR_ID_NONE;
+    }
+
+    U64 Hash = Pool->HashFunction((const U8*)Str, Len, 0);
+    U64 Idx  = InternProbe(Pool, Str, Len, Hash);
+    if( Pool->Slots[Idx] != 0 ) {
+        return (str_id)Pool->Slots[Idx];
+    }
+
+    if( Pool->Count == 0xFFFFFFFFu ) {
+        return STR_ID_NONE;
+    }
+    if( Pool->Count == Pool->Capacity ) {
+        // Entries is indexed as one array, the new block has to land right
+        // after it. A chained arena that had to open a new segment breaks
+        // that, the block is left unused and the pool reports it is full.
+        //
+        intern_entry* Grown = PushArray(Pool->EntryArena, intern_entry, INTERN_POOL_ENTRY_GROW);
+        assert(Grown == NULL || Grown == Pool->Entries + Pool->Capacity);
+        if( Grown != Pool->Entries + Pool->Capacity ) {
+            return STR_ID_NONE;
+        }
+        Pool->Capacity += INTERN_POOL_ENTRY_GROW;
+    }
+    u8* Data = PushArray(Pool->TextArena, u8, (Len + 1));
+    if( Data == NULL ) {
+        return STR_ID_NONE;
+    }
+    memcpy(Data, Str, Len);
+    Data[Len] = 0;
+
+    str_id        Id    = Pool->Count;
+    intern_entry* Entry = &Pool->Entries[Id];
+    Entry->Hash = Hash;
+    Entry->Data = Data;
+    Entry->Len  = (u32)Len;
+    Pool->Count += 1;
+
+    if( (U64)Pool->Count * 100 > (Pool->SlotMask + 1) * INTERN_POOL_LOAD ) {
+        InternAllocSlots(Pool, (Pool->SlotMask + 1) * 2);
+    } else {
+        Pool->Slots[Idx] = InternSlot(Hash, Id);
+    }
+    return Id;
+}
+
+str_id Intern(intern_pool* Pool, const char* Str) {
+    return InternN(Pool, Str, CustomStrlen(Str));
+}
+
+str_id InternStr(intern_pool* Pool, U8_String* Str) {
+    return InternN(Pool, (const char*)Str->data, Str->idx);
+}
+
+#endif // STRING_INTERN_IMPL
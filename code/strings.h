@@ -2,9 +2,29 @@
 #define _STRINGS_H_
 
 #include "types.h"
+#include "memory.h"
 #include "allocator.h"
 
 #include <string.h>
+#include <stdio.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <sys/uio.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define STRINGS_X86_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define STRINGS_TARGET_AVX2
+#define STRINGS_NO_SANITIZE __declspec(no_sanitize_address)
+#else
+#define STRINGS_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#define STRINGS_NO_SANITIZE __attribute__((no_sanitize_address))
+#endif
+#endif
 
 typedef struct U8_String U8_String;
 struct U8_String {
@@ -50,6 +70,66 @@ i64* GetAllOcurrences(U8_String* Str, char val);
 
 void SplitMultiple(U8_String* Dst, i64 Size, const U8_String* Src, char val);
 
+// Set of bytes for the "first/last of any" searches. The first
+// STRINGS_BYTE_SET_SIMD members are compared in SIMD registers, a bigger set
+// is checked against Bits one byte at a time.
+//
+#define STRINGS_BYTE_SET_SIMD 16
+
+typedef struct byte_set byte_set;
+struct byte_set {
+    u64 Bits[4];
+    u8  Bytes[STRINGS_BYTE_SET_SIMD];
+    u32 Count;
+};
+
+byte_set ByteSetMake(const char* Bytes);
+
+i64 GetFirstOcurrenceOf(U8_String* Str, const char* Set);
+i64 GetLastOcurrenceOf(U8_String* Str, const char* Set);
+
+// Byte scanning kernels under the calls above. The first call picks the widest
+// version the CPU runs (AVX2, SSE2, scalar), StringSelectKernels forces one,
+// e.g. to benchmark them against each other.
+//
+enum {
+    STRING_KERNELS_AUTO,
+    STRING_KERNELS_SCALAR,
+    STRING_KERNELS_SSE2,
+    STRING_KERNELS_AVX2,
+};
+
+typedef struct string_kernels string_kernels;
+struct string_kernels {
+    const char* Name;
+    i64 (*FindByte)       (const u8* Data, i64 Len, u8 Val);
+    i64 (*FindLastByte)   (const u8* Data, i64 Len, u8 Val);
+    i64 (*CountByte)      (const u8* Data, i64 Len, u8 Val);
+    i64 (*FindAnyByte)    (const u8* Data, i64 Len, const byte_set* Set);
+    i64 (*FindLastAnyByte)(const u8* Data, i64 Len, const byte_set* Set);
+    i64 (*Length)         (const char* Str);
+    i64 (*AsciiLength)    (const u8* Data, i64 Len);
+    i64 (*WidenAscii)     (const u8* Data, i64 Len, u32* Out);
+};
+
+/**
+ * @brief Selects the kernels every string call goes through
+ * @param Level STRING_KERNELS_*
+ * @return bool false if the CPU can't run that level, the kernels don't change
+ */
+bool StringSelectKernels(u32 Level);
+const string_kernels* StringGetKernels(void);
+
+/**
+ * @brief Index of the first/last Val in Data, -1 if there is none
+ */
+i64 StringFindByte(const u8* Data, i64 Len, u8 Val);
+i64 StringFindLastByte(const u8* Data, i64 Len, u8 Val);
+i64 StringCountByte(const u8* Data, i64 Len, u8 Val);
+i64 StringFindAnyByte(const u8* Data, i64 Len, const byte_set* Set);
+i64 StringFindLastAnyByte(const u8* Data, i64 Len, const byte_set* Set);
+i64 StringLength(const char* Str);
+
 fn_internal i64 StringGetLen(U8_String* Str) { return Str->idx; }
 fn_internal i64 StringGetCapacity(U8_String* Str) { return Str->len; }
 
@@ -58,6 +138,200 @@ fn_internal i64 CustomStreq(const char* a, const char* b);
 fn_internal i64 CustomStrcpy(char* a, const char* b);
 fn_internal i64 CustomStreqn(const char* a, const char* b, u32 n);
 
+// --------------------------------------------------------------- //
+// String builder
+
+// Text appended in chunks taken from an arena, it never reallocates nor
+// copies what it already holds. When the arena hands out the bytes right after
+// the last chunk that chunk just gets longer, so a builder with an arena of its
+// own is a single chunk. Output goes to a file with one iovec per chunk.
+//
+#define STRING_BUILDER_CHUNK_SIZE kibibyte(64)
+#define STRING_BUILDER_IOV_COUNT  64
+
+typedef struct string_chunk string_chunk;
+struct string_chunk {
+    string_chunk* Next;
+    u8*           Data;
+    i64           Used;
+    i64           Capacity;
+};
+
+typedef struct string_builder string_builder;
+struct string_builder {
+    Arena*        TextArena;
+    string_chunk* First;
+    string_chunk* Last;
+    i64           Length;
+    i64           ChunkSize;
+};
+
+/**
+ * @brief Inits an empty builder, no memory is taken until the first append
+ * @param ChunkSize bytes asked to the arena every time it runs out, 0 for STRING_BUILDER_CHUNK_SIZE
+ */
+void StringBuilderInit(string_builder* Builder, Arena* TextArena, i64 ChunkSize);
+/**
+ * @brief Empties the builder, the chunks it has are used again
+ */
+void StringBuilderClear(string_builder* Builder);
+
+/**
+ * @brief Room for Len contiguous bytes at the end of the text. Write into it
+ *        and call StringBuilderCommit with what was written
+ * @return u8* NULL if the arena is full
+ */
+u8*  StringBuilderReserve(string_builder* Builder, i64 Len);
+void StringBuilderCommit(string_builder* Builder, i64 Len);
+
+void StringBuilderAppendN(string_builder* Builder, const void* Data, i64 Len);
+void StringBuilderAppend(string_builder* Builder, const char* Str);
+void StringBuilderAppendStr(string_builder* Builder, U8_String* Str);
+void StringBuilderAppendChar(string_builder* Builder, char Char);
+// Numbers are appended with the calls in fmt_fast.h
+
+/**
+ * @brief Text from From to the end as one NUL terminated string. It only
+ *        copies when that text crosses chunks. Valid until the next append
+ */
+U8_String StringBuilderView(string_builder* Builder, i64 From);
+/**
+ * @brief Copies the whole text into Dst, which holds at least Builder->Length bytes
+ * @return i64 bytes copied
+ */
+i64 StringBuilderCopy(string_builder* Builder, u8* Dst);
+
+#ifdef __linux__
+/**
+ * @brief Writes the text to Fd with writev, STRING_BUILDER_IOV_COUNT chunks per call
+ * @return i64 bytes written, -1 on error
+ */
+i64 StringBuilderWriteFd(string_builder* Builder, int Fd);
+#endif
+
+fn_internal i64 StringBuilderLength(string_builder* Builder) { return Builder->Length; }
+
+// --------------------------------------------------------------- //
+// Small strings
+
+// A string that keeps up to SSO_STRING_INLINE bytes inside itself and only
+// goes to a Stack_Allocator for longer text. It is the size of a U8_String,
+// most labels and names never allocate and are read from the object that
+// holds them. A zeroed sso_string is the empty string.
+//
+// The last byte tells both cases apart: the length when inline,
+// SSO_STRING_HEAP when the text is elsewhere. Text elsewhere with a Capacity
+// of 0 is borrowed (SsoStringRef): it is never written, the first change
+// copies it. Text is not NUL terminated, always go with the length.
+//
+#define SSO_STRING_INLINE 23
+#define SSO_STRING_HEAP   0xFF
+
+typedef struct sso_string sso_string;
+struct sso_string {
+    union {
+        u8 Inline[SSO_STRING_INLINE + 1];
+        struct {
+            u8* Data;
+            u32 Length;
+            u32 Capacity;
+            u8  Pad[7];
+            u8  Tag;
+        } Heap;
+    };
+};
+
+/**
+ * @brief Copy of Str, inline if it fits
+ * @param a allocator for text longer than SSO_STRING_INLINE, can be NULL for short text
+ */
+sso_string SsoStringNew(const char* Str, i64 Len, Stack_Allocator* a);
+/**
+ * @brief Wraps text that outlives the string without copying it, interned text
+ *        for example. Text that fits inline is copied anyway
+ */
+sso_string SsoStringRef(const u8* Data, i64 Len);
+
+/**
+ * @brief Replaces/extends the text. Past the inline size the text moves to a
+ *        push from a twice as big, old pushes stay in the stack until it is freed.
+ *        Like the other calls here, what does not fit (no allocator, stack full,
+ *        4 GiB) is skipped
+ */
+void SsoStringCpy(sso_string* Dst, const char* Src, i64 Len, Stack_Allocator* a);
+void SsoStringAppend(sso_string* Dst, const char* Str, i64 Len, Stack_Allocator* a);
+void SsoStringAppendStr(sso_string* Dst, U8_String* Str, Stack_Allocator* a);
+
+fn_internal bool SsoStringIsInline(const sso_string* Str) { return Str->Inline[SSO_STRING_INLINE] != SSO_STRING_HEAP; }
+
+fn_internal i64 SsoStringLength(const sso_string* Str) {
+    return SsoStringIsInline(Str) ? Str->Inline[SSO_STRING_INLINE] : Str->Heap.Length;
+}
+
+fn_internal const u8* SsoStringData(const sso_string* Str) {
+    return SsoStringIsInline(Str) ? Str->Inline : Str->Heap.Data;
+}
+
+fn_internal void SsoStringClear(sso_string* Str) {
+    if( SsoStringIsInline(Str) ) {
+        Str->Inline[SSO_STRING_INLINE] = 0;
+    } else {
+        Str->Heap.Length = 0;
+    }
+}
+
+fn_internal bool SsoStringEq(const sso_string* Str, const char* Other, i64 Len) {
+    return SsoStringLength(Str) == Len && memcmp(SsoStringData(Str), Other, Len) == 0;
+}
+
+// The text as a U8_String for the strings.h calls and D_DrawText2D. len is the
+// length too so the calls that write refuse to, the view is read only and
+// valid until the string changes or moves (inline text moves with it)
+//
+fn_internal U8_String SsoStringView(const sso_string* Str) {
+    U8_String View = {};
+    View.data = (u8*)SsoStringData(Str);
+    View.len  = SsoStringLength(Str);
+    View.idx  = View.len;
+    return View;
+}
+
+// --------------------------------------------------------------- //
+// UTF-8
+
+// Runs of ASCII go through the string kernels 16/32 bytes at a time, only
+// the bytes of multi byte sequences are looked at one by one. Overlong forms,
+// surrogates and anything past U+10FFFF are invalid. When decoding, every
+// invalid sequence becomes one UTF8_REPLACEMENT covering its longest valid
+// start (at least one byte), the way browsers and Python do it.
+//
+#define UTF8_REPLACEMENT 0xFFFD
+
+/**
+ * @brief Bytes at the start of Data that are valid UTF-8, Len when all of it is
+ */
+i64 Utf8Validate(const u8* Data, i64 Len);
+
+/**
+ * @brief Decodes Data into a span of codepoints, until Len bytes or Capacity
+ *        codepoints. Call again from Used for the rest
+ * @param Used bytes of Data that were decoded, can be NULL
+ * @return i64 codepoints written
+ */
+i64 Utf8Decode(const u8* Data, i64 Len, u32* Codepoints, i64 Capacity, i64* Used);
+
+/**
+ * @brief Codepoint at *Pos, Pos goes past it. 0 at the end
+ */
+u32 Utf8Next(const u8* Data, i64 Len, i64* Pos);
+
+/**
+ * @brief Length of the ASCII run at the start of Data / same, also widening
+ *        it into Out
+ */
+i64 StringAsciiLength(const u8* Data, i64 Len);
+i64 StringWidenAscii(const u8* Data, i64 Len, u32* Out);
+
 #endif
 
 #ifdef STRINGS_IMPL
@@ -84,66 +358,62 @@ U8_String StringCreate( i64 len, Stack_Allocator* a ) {
 
 U8_String
 SplitFirst( U8_String* Str, char val ) {
-    for( i64 it = 0; it < Str->len; it += 1 ) {
-        if( Str->data[it] == val ) {
-			U8_String ret = {};
-			ret.data = Str->data;
-			ret.len  = it;
-			ret.idx  = it;
+    i64 it = StringFindByte(Str->data, Str->len, (u8)val);
+    if( it != -1 ) {
+		U8_String ret = {};
+		ret.data = Str->data;
+		ret.len  = it;
+		ret.idx  = it;
 
-            return ret;
-        }
+        return ret;
     }
     return *Str;
 }
 
 i64
 GetCountOfChar(U8_String* Str, char val) {
-    i64 cnt = 0;
-    for( i64 it = 0; it < Str->len; it += 1 ) {
-        if( Str->data[it] == val ) {
-            cnt += 1;
-        }
-    }
-    return cnt;
+    return StringCountByte(Str->data, Str->len, (u8)val);
 }
 
 i64 GetFirstOcurrence(U8_String* Str, char val) {
-    for( i64 i = 0; i < Str->idx; i += 1 ) {
-        if( Str->data[i] == val ) {
-            return i;
-        }
-    }
-    return -1;
+    return StringFindByte(Str->data, Str->idx, (u8)val);
 }
 
 i64 GetLastOcurrence(U8_String* Str, char val) {
-    for( i64 i = Str->idx - 1; i >= 0; i -= 1 ) {
-        if( Str->data[i] == val ) {
-            return i;
-        }
-    }
+    return StringFindLastByte(Str->data, Str->idx, (u8)val);
+}
 
-    return -1;
+i64 GetFirstOcurrenceOf(U8_String* Str, const char* Set) {
+    byte_set Bytes = ByteSetMake(Set);
+    return StringFindAnyByte(Str->data, Str->idx, &Bytes);
+}
+
+i64 GetLastOcurrenceOf(U8_String* Str, const char* Set) {
+    byte_set Bytes = ByteSetMake(Set);
+    return StringFindLastAnyByte(Str->data, Str->idx, &Bytes);
 }
 
 void
 SplitMultiple(U8_String* Dst, i64 Size, const U8_String* Src, char val) {
     i64 Idx = 0;
     i64 LastValFound = 0;
-    for( i64 it = 0; it < Src->len && Idx < Size; it += 1 ) {
-        if( Src->data[it] == val ) {
-			U8_String str = {};
-			str.data = Src->data + LastValFound;
-			str.len  = it - LastValFound;
-            str.idx  = it - LastValFound;
-
-			Dst[Idx] = str;
-            LastValFound = it + 1;
-            Idx += 1;
+    while( Idx < Size ) {
+        i64 it = StringFindByte(Src->data + LastValFound, Src->len - LastValFound, (u8)val);
+        if( it == -1 ) {
+            break;
         }
+        it += LastValFound;
+
+		U8_String str = {};
+		str.data = Src->data + LastValFound;
+		str.len  = it - LastValFound;
+        str.idx  = it - LastValFound;
+
+		Dst[Idx] = str;
+        LastValFound = it + 1;
+        Idx += 1;
     }
-    if( LastValFound < Src->len ) {
+    if( LastValFound < Src->len && Idx < Size ) {
 		U8_String str = {};
 		str.data = Src->data + LastValFound;
 		str.len = Src->len - LastValFound;
@@ -242,13 +512,9 @@ void StringDestroy(U8_String* s) {
 }
 
 fn_internal i64 CustomStrlen(const char* str) {
-	U64 i = 0;
-
-    if( str == NULL ) { return i; }
+    if( str == NULL ) { return 0; }
 
-    while( str[i] != '\0' ) { i += 1; };
-
-    return i;
+    return StringLength(str);
 }
 
 fn_internal i64 CustomStreq( const char* a, const char* b ) {
@@ -305,4 +571,1066 @@ fn_internal i64 CustomStreqn( const char* a, const char* b, u32 n ) {
     return 1;
 }
 
+// --------------------------------------------------------------- //
+// Byte scanning kernels
+
+byte_set ByteSetMake(const char* Bytes) {
+    byte_set Set = {};
+    for( const u8* it = (const u8*)Bytes; *it != '\0'; it += 1 ) {
+        u8 b = *it;
+        if( (Set.Bits[b >> 6] >> (b & 63)) & 1 ) {
+            continue;
+        }
+        Set.Bits[b >> 6] |= 1ull << (b & 63);
+        if( Set.Count < STRINGS_BYTE_SET_SIMD ) {
+            Set.Bytes[Set.Count] = b;
+        }
+        Set.Count += 1;
+    }
+    return Set;
+}
+
+fn_internal bool
+ByteSetHas(const byte_set* Set, u8 b) {
+    return (Set->Bits[b >> 6] >> (b & 63)) & 1;
+}
+
+static i64 StringFindByteScalar(const u8* Data, i64 Len, u8 Val) {
+    for( i64 i = 0; i < Len; i += 1 ) {
+        if( Data[i] == Val ) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static i64 StringFindLastByteScalar(const u8* Data, i64 Len, u8 Val) {
+    for( i64 i = Len - 1; i >= 0; i -= 1 ) {
+        if( Data[i] == Val ) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static i64 StringCountByteScalar(const u8* Data, i64 Len, u8 Val) {
+    i64 Count = 0;
+    for( i64 i = 0; i < Len; i += 1 ) {
+        Count += Data[i] == Val;
+    }
+    return Count;
+}
+
+static i64 StringFindAnyByteScalar(const u8* Data, i64 Len, const byte_set* Set) {
+    for( i64 i = 0; i < Len; i += 1 ) {
+        if( ByteSetHas(Set, Data[i]) ) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static i64 StringFindLastAnyByteScalar(const u8* Data, i64 Len, const byte_set* Set) {
+    for( i64 i = Len - 1; i >= 0; i -= 1 ) {
+        if( ByteSetHas(Set, Data[i]) ) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static i64 StringLengthScalar(const char* Str) {
+    i64 i = 0;
+    while( Str[i] != '\0' ) { i += 1; }
+    return i;
+}
+
+static i64 StringAsciiLengthScalar(const u8* Data, i64 Len) {
+    i64 i = 0;
+    while( i < Len && Data[i] < 0x80 ) { i += 1; }
+    return i;
+}
+
+static i64 StringWidenAsciiScalar(const u8* Data, i64 Len, u32* Out) {
+    i64 i = 0;
+    for( ; i < Len && Data[i] < 0x80; i += 1 ) {
+        Out[i] = Data[i];
+    }
+    return i;
+}
+
+#ifdef STRINGS_X86_SIMD
+
+static u32 StringLowBit(u32 Mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long Idx;
+    _BitScanForward(&Idx, Mask);
+    return Idx;
+#else
+    return (u32)__builtin_ctz(Mask);
+#endif
+}
+
+static u32 StringPopCount(u32 Mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return __popcnt(Mask);
+#else
+    return (u32)__builtin_popcount(Mask);
+#endif
+}
+
+static u32 StringHighBit(u32 Mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long Idx;
+    _BitScanReverse(&Idx, Mask);
+    return Idx;
+#else
+    return 31 - (u32)__builtin_clz(Mask);
+#endif
+}
+
+static bool StringCpuHasAVX2(void) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int Info[4];
+    __cpuid(Info, 0);
+    if( Info[0] < 7 ) { return false; }
+
+    // AVX needs the OS to save the ymm registers too
+    //
+    __cpuid(Info, 1);
+    if( (Info[2] & (1 << 27)) == 0 || (Info[2] & (1 << 28)) == 0 ) { return false; }
+    if( (_xgetbv(0) & 6) != 6 ) { return false; }
+
+    __cpuidex(Info, 7, 0);
+    return (Info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+// SSE2, 16 bytes per compare. The long loops check 64 bytes with a single
+// movemask and only look for the exact byte once something matched.
+//
+
+static i64 StringFindByteSSE2(const u8* Data, i64 Len, u8 Val) {
+    __m128i Needle = _mm_set1_epi8((char)Val);
+    i64 i = 0;
+    for( ; i + 64 <= Len; i += 64 ) {
+        __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(Data + i)),      Needle);
+        __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(Data + i + 16)), Needle);
+        __m128i c = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(Data + i + 32)), Needle);
+        __m128i d = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(Data + i + 48)), Needle);
+        if( _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d))) ) {
+            break;
+        }
+    }
+    for( ; i + 16 <= Len; i += 16 ) {
+        u32 Mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(Data + i)), Needle));
+        if( Mask ) {
+            return i + StringLowBit(Mask);
+        }
+    }
+    i64 Tail = StringFindByteScalar(Data + i, Len - i, Val);
+    return Tail == -1 ? -1 : i + Tail;
+}
+
+static i64 StringFindLastByteSSE2(const u8* Data, i64 Len, u8 Val) {
+    __m128i Needle = _mm_set1_epi8((char)Val);
+    i64 i = Len;
+    for( ; i >= 64; i -= 64 ) {
+        __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(Data + i - 64)), Needle);
+        __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(Data + i - 48)), Needle);
+        __m128i c = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(Data + i - 32)), Needle);
+        __m128i d = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(Data + i - 16)), Needle);
+        if( _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d))) ) {
+            break;
+        }
+    }
+    for( ; i >= 16; i -= 16 ) {
+        u32 Mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(Data + i - 16)), Needle));
+        if( Mask ) {
+            return i - 16 + StringHighBit(Mask);
+        }
+    }
+    return StringFindLastByteScalar(Data, i, Val);
+}
+
+// Matches are 0xFF, so subtracting them counts up in every byte lane. A lane
+// can take 255 of them before psadbw folds the lanes into 64 bit sums.
+//
+static i64 StringCountByteSSE2(const u8* Data, i64 Len, u8 Val) {
+    __m128i Needle = _mm_set1_epi8((char)Val);
+    __m128i Zero   = _mm_setzero_si128();
+    __m128i Total  = _mm_setzero_si128();
+    i64 i = 0;
+    while( i + 16 <= Len ) {
+        __m128i Lanes = _mm_setzero_si128();
+        for( u32 k = 0; k < 255 && i + 16 <= Len; k += 1, i += 16 ) {
+            Lanes = _mm_sub_epi8(Lanes, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(Data + i)), Needle));
+        }
+        Total = _mm_add_epi64(Total, _mm_sad_epu8(Lanes, Zero));
+    }
+    u64 Sums[2];
+    _mm_storeu_si128((__m128i*)Sums, Total);
+    return (i64)(Sums[0] + Sums[1]) + StringCountByteScalar(Data + i, Len - i, Val);
+}
+
+static i64 StringFindAnyByteSSE2(const u8* Data, i64 Len, const byte_set* Set) {
+    if( Set->Count > STRINGS_BYTE_SET_SIMD ) {
+        return StringFindAnyByteScalar(Data, Len, Set);
+    }
+
+    __m128i Needles[STRINGS_BYTE_SET_SIMD];
+    for( u32 k = 0; k < Set->Count; k += 1 ) {
+        Needles[k] = _mm_set1_epi8((char)Set->Bytes[k]);
+    }
+
+    i64 i = 0;
+    for( ; i + 16 <= Len && Set->Count > 0; i += 16 ) {
+        __m128i Chunk = _mm_loadu_si128((const __m128i*)(Data + i));
+        __m128i Hit   = _mm_cmpeq_epi8(Chunk, Needles[0]);
+        for( u32 k = 1; k < Set->Count; k += 1 ) {
+            Hit = _mm_or_si128(Hit, _mm_cmpeq_epi8(Chunk, Needles[k]));
+        }
+        u32 Mask = (u32)_mm_movemask_epi8(Hit);
+        if( Mask ) {
+            return i + StringLowBit(Mask);
+        }
+    }
+    i64 Tail = StringFindAnyByteScalar(Data + i, Len - i, Set);
+    return Tail == -1 ? -1 : i + Tail;
+}
+
+static i64 StringFindLastAnyByteSSE2(const u8* Data, i64 Len, const byte_set* Set) {
+    if( Set->Count > STRINGS_BYTE_SET_SIMD ) {
+        return StringFindLastAnyByteScalar(Data, Len, Set);
+    }
+
+    __m128i Needles[STRINGS_BYTE_SET_SIMD];
+    for( u32 k = 0; k < Set->Count; k += 1 ) {
+        Needles[k] = _mm_set1_epi8((char)Set->Bytes[k]);
+    }
+
+    i64 i = Len;
+    for( ; i >= 16 && Set->Count > 0; i -= 16 ) {
+        __m128i Chunk = _mm_loadu_si128((const __m128i*)(Data + i - 16));
+        __m128i Hit   = _mm_cmpeq_epi8(Chunk, Needles[0]);
+        for( u32 k = 1; k < Set->Count; k += 1 ) {
+            Hit = _mm_or_si128(Hit, _mm_cmpeq_epi8(Chunk, Needles[k]));
+        }
+        u32 Mask = (u32)_mm_movemask_epi8(Hit);
+        if( Mask ) {
+            return i - 16 + StringHighBit(Mask);
+        }
+    }
+    return StringFindLastAnyByteScalar(Data, i, Set);
+}
+
+// The length isn't known up front, so loads are aligned: an aligned load never
+// crosses into the next page, even when it reads past the terminator or
+// before Str. Those bytes are masked off, but the sanitizers can't know that.
+//
+STRINGS_NO_SANITIZE static i64 StringLengthSSE2(const char* Str) {
+    __m128i Zero    = _mm_setzero_si128();
+    uintptr_t Skip  = (uintptr_t)Str & 15;
+    const u8* Block = (const u8*)Str - Skip;
+
+    u32 Mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*)Block), Zero)) >> Skip;
+    if( Mask ) {
+        return StringLowBit(Mask);
+    }
+    for( ;; ) {
+        Block += 16;
+        Mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*)Block), Zero));
+        if( Mask ) {
+            return (Block - (const u8*)Str) + StringLowBit(Mask);
+        }
+    }
+}
+
+// A byte is ASCII when its top bit is clear, which is what movemask reads
+//
+static i64 StringAsciiLengthSSE2(const u8* Data, i64 Len) {
+    i64 i = 0;
+    for( ; i + 64 <= Len; i += 64 ) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(Data + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(Data + i + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(Data + i + 32));
+        __m128i d = _mm_loadu_si128((const __m128i*)(Data + i + 48));
+        if( _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d))) ) {
+            break;
+        }
+    }
+    for( ; i + 16 <= Len; i += 16 ) {
+        u32 Mask = (u32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(Data + i)));
+        if( Mask ) {
+            return i + StringLowBit(Mask);
+        }
+    }
+    if( i == Len || Len < 16 ) {
+        return i == Len ? Len : StringAsciiLengthScalar(Data, Len);
+    }
+    // Bytes before i are ASCII, they add no bits
+    //
+    u32 Mask = (u32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(Data + Len - 16)));
+    return Mask ? Len - 16 + StringLowBit(Mask) : Len;
+}
+
+static i64 StringWidenAsciiSSE2(const u8* Data, i64 Len, u32* Out) {
+    __m128i Zero = _mm_setzero_si128();
+    i64 i = 0;
+    for( ; i + 16 <= Len; i += 16 ) {
+        __m128i Bytes = _mm_loadu_si128((const __m128i*)(Data + i));
+        if( _mm_movemask_epi8(Bytes) ) {
+            break;
+        }
+        __m128i Lo = _mm_unpacklo_epi8(Bytes, Zero);
+        __m128i Hi = _mm_unpackhi_epi8(Bytes, Zero);
+        _mm_storeu_si128((__m128i*)(Out + i),      _mm_unpacklo_epi16(Lo, Zero));
+        _mm_storeu_si128((__m128i*)(Out + i + 4),  _mm_unpackhi_epi16(Lo, Zero));
+        _mm_storeu_si128((__m128i*)(Out + i + 8),  _mm_unpacklo_epi16(Hi, Zero));
+        _mm_storeu_si128((__m128i*)(Out + i + 12), _mm_unpackhi_epi16(Hi, Zero));
+    }
+    return i + StringWidenAsciiScalar(Data + i, Len - i, Out + i);
+}
+
+// AVX2, same kernels 32 bytes per compare. The tails don't call the SSE2
+// ones: legacy SSE code right after 256 bit code pays for the state change on
+// every call, which is most of the time on short strings. Instead the last 32
+// bytes are loaded again overlapping what was already checked.
+//
+
+STRINGS_TARGET_AVX2 static i64 StringFindByteAVX2(const u8* Data, i64 Len, u8 Val) {
+    __m256i Needle = _mm256_set1_epi8((char)Val);
+    i64 i = 0;
+    for( ; i + 128 <= Len; i += 128 ) {
+        __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(Data + i)),      Needle);
+        __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(Data + i + 32)), Needle);
+        __m256i c = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(Data + i + 64)), Needle);
+        __m256i d = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(Data + i + 96)), Needle);
+        if( _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d))) ) {
+            break;
+        }
+    }
+    for( ; i + 32 <= Len; i += 32 ) {
+        u32 Mask = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(Data + i)), Needle));
+        if( Mask ) {
+            return i + StringLowBit(Mask);
+        }
+    }
+    if( i == Len || Len < 32 ) {
+        return i == Len ? -1 : StringFindByteScalar(Data, Len, Val);
+    }
+    u32 Mask = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(Data + Len - 32)), Needle));
+    return Mask ? Len - 32 + StringLowBit(Mask) : -1;
+}
+
+STRINGS_TARGET_AVX2 static i64 StringFindLastByteAVX2(const u8* Data, i64 Len, u8 Val) {
+    __m256i Needle = _mm256_set1_epi8((char)Val);
+    i64 i = Len;
+    for( ; i >= 128; i -= 128 ) {
+        __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(Data + i - 128)), Needle);
+        __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(Data + i - 96)),  Needle);
+        __m256i c = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(Data + i - 64)),  Needle);
+        __m256i d = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(Data + i - 32)),  Needle);
+        if( _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d))) ) {
+            break;
+        }
+    }
+    for( ; i >= 32; i -= 32 ) {
+        u32 Mask = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(Data + i - 32)), Needle));
+        if( Mask ) {
+            return i - 32 + StringHighBit(Mask);
+        }
+    }
+    if( i == 0 || Len < 32 ) {
+        return i == 0 ? -1 : StringFindLastByteScalar(Data, Len, Val);
+    }
+    u32 Mask = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)Data), Needle));
+    return Mask ? (i64)StringHighBit(Mask) : -1;
+}
+
+STRINGS_TARGET_AVX2 static i64 StringCountByteAVX2(const u8* Data, i64 Len, u8 Val) {
+    __m256i Needle = _mm256_set1_epi8((char)Val);
+    __m256i Zero   = _mm256_setzero_si256();
+    __m256i Total  = _mm256_setzero_si256();
+    i64 i = 0;
+    while( i + 32 <= Len ) {
+        __m256i Lanes = _mm256_setzero_si256();
+        for( u32 k = 0; k < 255 && i + 32 <= Len; k += 1, i += 32 ) {
+            Lanes = _mm256_sub_epi8(Lanes, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(Data + i)), Needle));
+        }
+        Total = _mm256_add_epi64(Total, _mm256_sad_epu8(Lanes, Zero));
+    }
+    u64 Sums[4];
+    _mm256_storeu_si256((__m256i*)Sums, Total);
+    i64 Count = (i64)(Sums[0] + Sums[1] + Sums[2] + Sums[3]);
+
+    if( i == Len || Len < 32 ) {
+        return i == Len ? Count : StringCountByteScalar(Data, Len, Val);
+    }
+    // Only the top Len - i bits are bytes not counted yet
+    //
+    u32 Mask = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(Data + Len - 32)), Needle));
+    return Count + StringPopCount(Mask >> (32 - (Len - i)));
+}
+
+STRINGS_TARGET_AVX2 static i64 StringFindAnyByteAVX2(const u8* Data, i64 Len, const byte_set* Set) {
+    if( Set->Count > STRINGS_BYTE_SET_SIMD ) {
+        return StringFindAnyByteScalar(Data, Len, Set);
+    }
+
+    __m256i Needles[STRINGS_BYTE_SET_SIMD];
+    for( u32 k = 0; k < Set->Count; k += 1 ) {
+        Needles[k] = _mm256_set1_epi8((char)Set->Bytes[k]);
+    }
+
+    i64 i = 0;
+    for( ; i + 32 <= Len && Set->Count > 0; i += 32 ) {
+        __m256i Chunk = _mm256_loadu_si256((const __m256i*)(Data + i));
+        __m256i Hit   = _mm256_cmpeq_epi8(Chunk, Needles[0]);
+        for( u32 k = 1; k < Set->Count; k += 1 ) {
+            Hit = _mm256_or_si256(Hit, _mm256_cmpeq_epi8(Chunk, Needles[k]));
+        }
+        u32 Mask = (u32)_mm256_movemask_epi8(Hit);
+        if( Mask ) {
+            return i + StringLowBit(Mask);
+        }
+    }
+    if( i == Len || Len < 32 || Set->Count == 0 ) {
+        return i == Len ? -1 : StringFindAnyByteScalar(Data, Len, Set);
+    }
+    __m256i Chunk = _mm256_loadu_si256((const __m256i*)(Data + Len - 32));
+    __m256i Hit   = _mm256_cmpeq_epi8(Chunk, Needles[0]);
+    for( u32 k = 1; k < Set->Count; k += 1 ) {
+        Hit = _mm256_or_si256(Hit, _mm256_cmpeq_epi8(Chunk, Needles[k]));
+    }
+    u32 Mask = (u32)_mm256_movemask_epi8(Hit);
+    return Mask ? Len - 32 + StringLowBit(Mask) : -1;
+}
+
+STRINGS_TARGET_AVX2 static i64 StringFindLastAnyByteAVX2(const u8* Data, i64 Len, const byte_set* Set) {
+    if( Set->Count > STRINGS_BYTE_SET_SIMD ) {
+        return StringFindLastAnyByteScalar(Data, Len, Set);
+    }
+
+    __m256i Needles[STRINGS_BYTE_SET_SIMD];
+    for( u32 k = 0; k < Set->Count; k += 1 ) {
+        Needles[k] = _mm256_set1_epi8((char)Set->Bytes[k]);
+    }
+
+    i64 i = Len;
+    for( ; i >= 32 && Set->Count > 0; i -= 32 ) {
+        __m256i Chunk = _mm256_loadu_si256((const __m256i*)(Data + i - 32));
+        __m256i Hit   = _mm256_cmpeq_epi8(Chunk, Needles[0]);
+        for( u32 k = 1; k < Set->Count; k += 1 ) {
+            Hit = _mm256_or_si256(Hit, _mm256_cmpeq_epi8(Chunk, Needles[k]));
+        }
+        u32 Mask = (u32)_mm256_movemask_epi8(Hit);
+        if( Mask ) {
+            return i - 32 + StringHighBit(Mask);
+        }
+    }
+    if( i == 0 || Len < 32 || Set->Count == 0 ) {
+        return i == 0 ? -1 : StringFindLastAnyByteScalar(Data, Len, Set);
+    }
+    __m256i Chunk = _mm256_loadu_si256((const __m256i*)Data);
+    __m256i Hit   = _mm256_cmpeq_epi8(Chunk, Needles[0]);
+    for( u32 k = 1; k < Set->Count; k += 1 ) {
+        Hit = _mm256_or_si256(Hit, _mm256_cmpeq_epi8(Chunk, Needles[k]));
+    }
+    u32 Mask = (u32)_mm256_movemask_epi8(Hit);
+    return Mask ? (i64)StringHighBit(Mask) : -1;
+}
+
+STRINGS_NO_SANITIZE STRINGS_TARGET_AVX2 static i64 StringLengthAVX2(const char* Str) {
+    __m256i Zero    = _mm256_setzero_si256();
+    uintptr_t Skip  = (uintptr_t)Str & 31;
+    const u8* Block = (const u8*)Str - Skip;
+
+    u32 Mask = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256((const __m256i*)Block), Zero)) >> Skip;
+    if( Mask ) {
+        return StringLowBit(Mask);
+    }
+    for( ;; ) {
+        Block += 32;
+        Mask = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256((const __m256i*)Block), Zero));
+        if( Mask ) {
+            return (Block - (const u8*)Str) + StringLowBit(Mask);
+        }
+    }
+}
+
+STRINGS_TARGET_AVX2 static i64 StringAsciiLengthAVX2(const u8* Data, i64 Len) {
+    i64 i = 0;
+    for( ; i + 128 <= Len; i += 128 ) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(Data + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(Data + i + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(Data + i + 64));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(Data + i + 96));
+        if( _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d))) ) {
+            break;
+        }
+    }
+    for( ; i + 32 <= Len; i += 32 ) {
+        u32 Mask = (u32)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*)(Data + i)));
+        if( Mask ) {
+            return i + StringLowBit(Mask);
+        }
+    }
+    if( i == Len || Len < 32 ) {
+        return i == Len ? Len : StringAsciiLengthScalar(Data, Len);
+    }
+    u32 Mask = (u32)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*)(Data + Len - 32)));
+    return Mask ? Len - 32 + StringLowBit(Mask) : Len;
+}
+
+// Labels are often shorter than 32 bytes, so the tail still widens 16 and 8
+// at a time (128 bit VEX code, no state change)
+//
+STRINGS_TARGET_AVX2 static i64 StringWidenAsciiAVX2(const u8* Data, i64 Len, u32* Out) {
+    i64 i = 0;
+    for( ; i + 32 <= Len; i += 32 ) {
+        __m256i Bytes = _mm256_loadu_si256((const __m256i*)(Data + i));
+        if( _mm256_movemask_epi8(Bytes) ) {
+            break;
+        }
+        __m128i Lo = _mm256_castsi256_si128(Bytes);
+        __m128i Hi = _mm256_extracti128_si256(Bytes, 1);
+        _mm256_storeu_si256((__m256i*)(Out + i),      _mm256_cvtepu8_epi32(Lo));
+        _mm256_storeu_si256((__m256i*)(Out + i + 8),  _mm256_cvtepu8_epi32(_mm_srli_si128(Lo, 8)));
+        _mm256_storeu_si256((__m256i*)(Out + i + 16), _mm256_cvtepu8_epi32(Hi));
+        _mm256_storeu_si256((__m256i*)(Out + i + 24), _mm256_cvtepu8_epi32(_mm_srli_si128(Hi, 8)));
+    }
+    if( i + 16 <= Len ) {
+        __m128i Bytes = _mm_loadu_si128((const __m128i*)(Data + i));
+        if( !_mm_movemask_epi8(Bytes) ) {
+            _mm256_storeu_si256((__m256i*)(Out + i),     _mm256_cvtepu8_epi32(Bytes));
+            _mm256_storeu_si256((__m256i*)(Out + i + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(Bytes, 8)));
+            i += 16;
+        }
+    }
+    if( i + 8 <= Len ) {
+        __m128i Bytes = _mm_loadl_epi64((const __m128i*)(Data + i));
+        if( !_mm_movemask_epi8(Bytes) ) {
+            _mm256_storeu_si256((__m256i*)(Out + i), _mm256_cvtepu8_epi32(Bytes));
+            i += 8;
+        }
+    }
+    return i + StringWidenAsciiScalar(Data + i, Len - i, Out + i);
+}
+
+#endif // STRINGS_X86_SIMD
+
+global const string_kernels StringKernelsScalar = {
+    "scalar",
+    StringFindByteScalar, StringFindLastByteScalar, StringCountByteScalar,
+    StringFindAnyByteScalar, StringFindLastAnyByteScalar, StringLengthScalar,
+    StringAsciiLengthScalar, StringWidenAsciiScalar
+};
+
+#ifdef STRINGS_X86_SIMD
+global const string_kernels StringKernelsSSE2 = {
+    "sse2",
+    StringFindByteSSE2, StringFindLastByteSSE2, StringCountByteSSE2,
+    StringFindAnyByteSSE2, StringFindLastAnyByteSSE2, StringLengthSSE2,
+    StringAsciiLengthSSE2, StringWidenAsciiSSE2
+};
+
+global const string_kernels StringKernelsAVX2 = {
+    "avx2",
+    StringFindByteAVX2, StringFindLastByteAVX2, StringCountByteAVX2,
+    StringFindAnyByteAVX2, StringFindLastAnyByteAVX2, StringLengthAVX2,
+    StringAsciiLengthAVX2, StringWidenAsciiAVX2
+};
+#endif
+
+// Until something selects, every pointer is a stub that selects and forwards.
+// Threads racing on the first call all store the same pointers, and a reader
+// sees either a stub or the final kernel, both fine to call.
+//
+static i64 StringFindByteResolve(const u8* Data, i64 Len, u8 Val);
+static i64 StringFindLastByteResolve(const u8* Data, i64 Len, u8 Val);
+static i64 StringCountByteResolve(const u8* Data, i64 Len, u8 Val);
+static i64 StringFindAnyByteResolve(const u8* Data, i64 Len, const byte_set* Set);
+static i64 StringFindLastAnyByteResolve(const u8* Data, i64 Len, const byte_set* Set);
+static i64 StringLengthResolve(const char* Str);
+static i64 StringAsciiLengthResolve(const u8* Data, i64 Len);
+static i64 StringWidenAsciiResolve(const u8* Data, i64 Len, u32* Out);
+
+global string_kernels StringKernels = {
+    "unresolved",
+    StringFindByteResolve, StringFindLastByteResolve, StringCountByteResolve,
+    StringFindAnyByteResolve, StringFindLastAnyByteResolve, StringLengthResolve,
+    StringAsciiLengthResolve, StringWidenAsciiResolve
+};
+
+bool StringSelectKernels(u32 Level) {
+#ifdef STRINGS_X86_SIMD
+    bool HasAVX2 = StringCpuHasAVX2();
+    if( Level == STRING_KERNELS_AUTO ) {
+        Level = HasAVX2 ? STRING_KERNELS_AVX2 : STRING_KERNELS_SSE2;
+    }
+    switch( Level ) {
+        case STRING_KERNELS_SCALAR: StringKernels = StringKernelsScalar; return true;
+        case STRING_KERNELS_SSE2:   StringKernels = StringKernelsSSE2;   return true;
+        case STRING_KERNELS_AVX2: {
+            if( !HasAVX2 ) { return false; }
+            StringKernels = StringKernelsAVX2;
+            return true;
+        }
+    }
+#else
+    if( Level == STRING_KERNELS_AUTO || Level == STRING_KERNELS_SCALAR ) {
+        StringKernels = StringKernelsScalar;
+        return true;
+    }
+#endif
+    return false;
+}
+
+const string_kernels* StringGetKernels(void) {
+    if( StringKernels.FindByte == StringFindByteResolve ) {
+        StringSelectKernels(STRING_KERNELS_AUTO);
+    }
+    return &StringKernels;
+}
+
+static i64 StringFindByteResolve(const u8* Data, i64 Len, u8 Val) {
+    return StringGetKernels()->FindByte(Data, Len, Val);
+}
+
+static i64 StringFindLastByteResolve(const u8* Data, i64 Len, u8 Val) {
+    return StringGetKernels()->FindLastByte(Data, Len, Val);
+}
+
+static i64 StringCountByteResolve(const u8* Data, i64 Len, u8 Val) {
+    return StringGetKernels()->CountByte(Data, Len, Val);
+}
+
+static i64 StringFindAnyByteResolve(const u8* Data, i64 Len, const byte_set* Set) {
+    return StringGetKernels()->FindAnyByte(Data, Len, Set);
+}
+
+static i64 StringFindLastAnyByteResolve(const u8* Data, i64 Len, const byte_set* Set) {
+    return StringGetKernels()->FindLastAnyByte(Data, Len, Set);
+}
+
+static i64 StringLengthResolve(const char* Str) {
+    return StringGetKernels()->Length(Str);
+}
+
+static i64 StringAsciiLengthResolve(const u8* Data, i64 Len) {
+    return StringGetKernels()->AsciiLength(Data, Len);
+}
+
+static i64 StringWidenAsciiResolve(const u8* Data, i64 Len, u32* Out) {
+    return StringGetKernels()->WidenAscii(Data, Len, Out);
+}
+
+i64 StringFindByte(const u8* Data, i64 Len, u8 Val)                     { return StringKernels.FindByte(Data, Len, Val); }
+i64 StringFindLastByte(const u8* Data, i64 Len, u8 Val)                 { return StringKernels.FindLastByte(Data, Len, Val); }
+i64 StringCountByte(const u8* Data, i64 Len, u8 Val)                    { return StringKernels.CountByte(Data, Len, Val); }
+i64 StringFindAnyByte(const u8* Data, i64 Len, const byte_set* Set)     { return StringKernels.FindAnyByte(Data, Len, Set); }
+i64 StringFindLastAnyByte(const u8* Data, i64 Len, const byte_set* Set) { return StringKernels.FindLastAnyByte(Data, Len, Set); }
+i64 StringLength(const char* Str)                                       { return StringKernels.Length(Str); }
+i64 StringAsciiLength(const u8* Data, i64 Len)                          { return StringKernels.AsciiLength(Data, Len); }
+i64 StringWidenAscii(const u8* Data, i64 Len, u32* Out)                 { return StringKernels.WidenAscii(Data, Len, Out); }
+
+// --------------------------------------------------------------- //
+// UTF-8
+
+// One sequence at Data[0]. The second byte's range depends on the lead, that
+// is what rules out overlongs (E0, F0), surrogates (ED) and > U+10FFFF (F4)
+//
+static i64 Utf8DecodeSequence(const u8* Data, i64 Len, u32* Codepoint, bool* Valid) {
+    u8  Lead = Data[0];
+    u8  Lo   = 0x80;
+    u8  Hi   = 0xBF;
+    i64 Need = 0;
+    u32 Cp   = 0;
+    if( Lead < 0x80 ) {
+        *Codepoint = Lead;
+        *Valid     = true;
+        return 1;
+    } else if( Lead >= 0xC2 && Lead <= 0xDF ) {
+        Need = 1;
+        Cp   = Lead & 0x1F;
+    } else if( Lead >= 0xE0 && Lead <= 0xEF ) {
+        Need = 2;
+        Cp   = Lead & 0x0F;
+        if( Lead == 0xE0 ) { Lo = 0xA0; }
+        if( Lead == 0xED ) { Hi = 0x9F; }
+    } else if( Lead >= 0xF0 && Lead <= 0xF4 ) {
+        Need = 3;
+        Cp   = Lead & 0x07;
+        if( Lead == 0xF0 ) { Lo = 0x90; }
+        if( Lead == 0xF4 ) { Hi = 0x8F; }
+    } else {
+        *Codepoint = UTF8_REPLACEMENT;
+        *Valid     = false;
+        return 1;
+    }
+
+    i64 i = 1;
+    for( ; i <= Need; i += 1 ) {
+        if( i >= Len || Data[i] < Lo || Data[i] > Hi ) {
+            *Codepoint = UTF8_REPLACEMENT;
+            *Valid     = false;
+            return i;
+        }
+        Cp = (Cp << 6) | (Data[i] & 0x3F);
+        Lo = 0x80;
+        Hi = 0xBF;
+    }
+    *Codepoint = Cp;
+    *Valid     = true;
+    return i;
+}
+
+i64 Utf8Validate(const u8* Data, i64 Len) {
+    i64 i = 0;
+    while( i < Len ) {
+        if( Data[i] < 0x80 ) {
+            i += StringKernels.AsciiLength(Data + i, Len - i);
+            continue;
+        }
+        u32  Codepoint;
+        bool Valid;
+        i64  Size = Utf8DecodeSequence(Data + i, Len - i, &Codepoint, &Valid);
+        if( !Valid ) {
+            return i;
+        }
+        i += Size;
+    }
+    return Len;
+}
+
+i64 Utf8Decode(const u8* Data, i64 Len, u32* Codepoints, i64 Capacity, i64* Used) {
+    i64 i     = 0;
+    i64 Count = 0;
+    while( i < Len && Count < Capacity ) {
+        if( Data[i] < 0x80 ) {
+            i64 Run = Len - i < Capacity - Count ? Len - i : Capacity - Count;
+            Run     = StringKernels.WidenAscii(Data + i, Run, Codepoints + Count);
+            i      += Run;
+            Count  += Run;
+            continue;
+        }
+        bool Valid;
+        i     += Utf8DecodeSequence(Data + i, Len - i, &Codepoints[Count], &Valid);
+        Count += 1;
+    }
+    if( Used != NULL ) {
+        *Used = i;
+    }
+    return Count;
+}
+
+u32 Utf8Next(const u8* Data, i64 Len, i64* Pos) {
+    if( *Pos >= Len ) {
+        return 0;
+    }
+    u32  Codepoint;
+    bool Valid;
+    *Pos += Utf8DecodeSequence(Data + *Pos, Len - *Pos, &Codepoint, &Valid);
+    return Codepoint;
+}
+
+// --------------------------------------------------------------- //
+// String builder
+
+void StringBuilderInit(string_builder* Builder, Arena* TextArena, i64 ChunkSize) {
+    memset(Builder, 0, sizeof(string_builder));
+    Builder->TextArena = TextArena;
+    // Multiple of 16 as the arena aligns pushes to 16, otherwise the next
+    // chunk could never follow the last one
+    //
+    Builder->ChunkSize = ((ChunkSize > 0 ? ChunkSize : STRING_BUILDER_CHUNK_SIZE) + 15) & ~(i64)15;
+    if( Builder->ChunkSize < 64 ) {
+        Builder->ChunkSize = 64;
+    }
+}
+
+void StringBuilderClear(string_builder* Builder) {
+    for( string_chunk* Chunk = Builder->First; Chunk != NULL; Chunk = Chunk->Next ) {
+        Chunk->Used = 0;
+    }
+    Builder->Last   = Builder->First;
+    Builder->Length = 0;
+}
+
+u8* StringBuilderReserve(string_builder* Builder, i64 Len) {
+    string_chunk* Last = Builder->Last;
+    if( Last != NULL && Last->Capacity - Last->Used >= Len ) {
+        return Last->Data + Last->Used;
+    }
+
+    // Chunks left over from a clear
+    //
+    while( Last != NULL && Last->Next != NULL ) {
+        Last = Last->Next;
+        if( Last->Capacity >= Len ) {
+            Builder->Last = Last;
+            return Last->Data;
+        }
+    }
+
+    // The header sits at the start of the block, so a block that follows the
+    // last chunk can be taken whole, header room included
+    //
+    i64 Header = (sizeof(string_chunk) + 15) & ~(i64)15;
+    i64 Size   = Len + Header > Builder->ChunkSize ? (Len + Header + 15) & ~(i64)15 : Builder->ChunkSize;
+    u8* Block  = (u8*)ArenaPush(Builder->TextArena, Size);
+    if( Block == NULL ) {
+        return NULL;
+    }
+
+    Last = Builder->Last;
+    if( Last != NULL && Last->Next == NULL && Last->Data + Last->Capacity == Block ) {
+        Last->Capacity += Size;
+        return Last->Data + Last->Used;
+    }
+
+    string_chunk* Chunk = (string_chunk*)Block;
+    Chunk->Data     = Block + Header;
+    Chunk->Used     = 0;
+    Chunk->Capacity = Size - Header;
+    Chunk->Next     = NULL;
+
+    // A new chunk goes at the end of the list, after any empty one that was
+    // too small
+    //
+    string_chunk* Tail = Builder->Last;
+    while( Tail != NULL && Tail->Next != NULL ) {
+        Tail = Tail->Next;
+    }
+    if( Tail == NULL ) {
+        Builder->First = Chunk;
+    } else {
+        Tail->Next = Chunk;
+    }
+    Builder->Last = Chunk;
+    return Chunk->Data;
+}
+
+void StringBuilderCommit(string_builder* Builder, i64 Len) {
+    Builder->Last->Used += Len;
+    Builder->Length     += Len;
+}
+
+void StringBuilderAppendN(string_builder* Builder, const void* Data, i64 Len) {
+    if( Len <= 0 ) {
+        return;
+    }
+    u8* Dst = StringBuilderReserve(Builder, Len);
+    if( Dst == NULL ) {
+        // Arena is full, skip as StringAppend does
+        return;
+    }
+    memcpy(Dst, Data, Len);
+    StringBuilderCommit(Builder, Len);
+}
+
+void StringBuilderAppend(string_builder* Builder, const char* Str) {
+    StringBuilderAppendN(Builder, Str, CustomStrlen(Str));
+}
+
+void StringBuilderAppendStr(string_builder* Builder, U8_String* Str) {
+    StringBuilderAppendN(Builder, Str->data, Str->idx);
+}
+
+void StringBuilderAppendChar(string_builder* Builder, char Char) {
+    string_chunk* Last = Builder->Last;
+    if( Last != NULL && Last->Used < Last->Capacity ) {
+        Last->Data[Last->Used++] = (u8)Char;
+        Builder->Length += 1;
+        return;
+    }
+    StringBuilderAppendN(Builder, &Char, 1);
+}
+
+U8_String StringBuilderView(string_builder* Builder, i64 From) {
+    U8_String View = {};
+    From = From < 0 ? 0 : (From > Builder->Length ? Builder->Length : From);
+
+    i64 Len  = Builder->Length - From;
+    string_chunk* Last = Builder->Last;
+    if( Last != NULL && From >= Builder->Length - Last->Used && Last->Used < Last->Capacity ) {
+        View.data = Last->Data + (From - (Builder->Length - Last->Used));
+    } else {
+        // Crosses chunks (or the last one is full): copy it past the end of the
+        // text, where the next append will write over it
+        //
+        u8* Dst = StringBuilderReserve(Builder, Len + 1);
+        if( Dst == NULL ) {
+            return View;
+        }
+        i64 Offset = 0;
+        for( string_chunk* Chunk = Builder->First; Chunk != NULL && Offset < Builder->Length; Chunk = Chunk->Next ) {
+            i64 Start = From > Offset ? From - Offset : 0;
+            if( Start < Chunk->Used ) {
+                memcpy(Dst + (Offset + Start - From), Chunk->Data + Start, Chunk->Used - Start);
+            }
+            Offset += Chunk->Used;
+        }
+        View.data = Dst;
+    }
+
+    View.data[Len] = 0;
+    View.len = Len + 1;
+    View.idx = Len;
+    return View;
+}
+
+i64 StringBuilderCopy(string_builder* Builder, u8* Dst) {
+    i64 Offset = 0;
+    for( string_chunk* Chunk = Builder->First; Chunk != NULL; Chunk = Chunk->Next ) {
+        memcpy(Dst + Offset, Chunk->Data, Chunk->Used);
+        Offset += Chunk->Used;
+    }
+    return Offset;
+}
+
+#ifdef __linux__
+i64 StringBuilderWriteFd(string_builder* Builder, int Fd) {
+    struct iovec Vectors[STRING_BUILDER_IOV_COUNT];
+
+    i64 Written = 0;
+    string_chunk* Chunk  = Builder->First;
+    i64           Offset = 0;
+    while( Chunk != NULL ) {
+        int Count = 0;
+        i64 Skip  = Offset;
+        for( string_chunk* It = Chunk; It != NULL && Count < STRING_BUILDER_IOV_COUNT; It = It->Next ) {
+            if( It->Used > Skip ) {
+                Vectors[Count].iov_base = It->Data + Skip;
+                Vectors[Count].iov_len  = It->Used - Skip;
+                Count += 1;
+            }
+            Skip = 0;
+        }
+        if( Count == 0 ) {
+            break;
+        }
+
+        ssize_t Result = writev(Fd, Vectors, Count);
+        if( Result < 0 && errno == EINTR ) {
+            continue;
+        }
+        if( Result <= 0 ) {
+            return -1;
+        }
+        Written += Result;
+
+        // A short write stops anywhere, carry on from there
+        //
+        while( Chunk != NULL && Result >= Chunk->Used - Offset ) {
+            Result -= Chunk->Used - Offset;
+            Chunk   = Chunk->Next;
+            Offset  = 0;
+        }
+        Offset += Result;
+    }
+    return Written;
+}
+#endif
+
+
+// --------------------------------------------------------------- //
+// Small strings
+
+sso_string SsoStringNew(const char* Str, i64 Len, Stack_Allocator* a) {
+    sso_string Result = {};
+    SsoStringCpy(&Result, Str, Len, a);
+    return Result;
+}
+
+sso_string SsoStringRef(const u8* Data, i64 Len) {
+    sso_string Result = {};
+    if( Len <= SSO_STRING_INLINE ) {
+        SsoStringCpy(&Result, (const char*)Data, Len, NULL);
+    } else if( Len <= 0xFFFFFFFFll ) {
+        Result.Heap.Data   = (u8*)Data;
+        Result.Heap.Length = (u32)Len;
+        Result.Heap.Tag    = SSO_STRING_HEAP;
+    }
+    return Result;
+}
+
+// Room for Len bytes keeping the first Keep, false if there is none
+//
+static bool SsoStringReserve(sso_string* Str, i64 Len, i64 Keep, Stack_Allocator* a) {
+    if( SsoStringIsInline(Str) ) {
+        if( Len <= SSO_STRING_INLINE ) {
+            return true;
+        }
+    } else if( Len <= Str->Heap.Capacity ) {
+        return true;
+    }
+    if( a == NULL || Len > 0xFFFFFFFFll ) {
+        return false;
+    }
+
+    i64 Capacity = SsoStringIsInline(Str) ? SSO_STRING_INLINE : Str->Heap.Capacity;
+    Capacity = Capacity * 2 > Len ? Capacity * 2 : Len;
+    if( Capacity > 0xFFFFFFFFll ) {
+        Capacity = 0xFFFFFFFFll;
+    }
+    u8* Data = (u8*)stack_alloc_non_zeroed(a, Capacity, DEFAULT_ALIGNMENT);
+    if( Data == NULL ) {
+        return false;
+    }
+    memcpy(Data, SsoStringData(Str), Keep);
+
+    Str->Heap.Data     = Data;
+    Str->Heap.Length   = (u32)Keep;
+    Str->Heap.Capacity = (u32)Capacity;
+    Str->Heap.Tag      = SSO_STRING_HEAP;
+    return true;
+}
+
+static void SsoStringSetLength(sso_string* Str, i64 Len) {
+    if( SsoStringIsInline(Str) ) {
+        Str->Inline[SSO_STRING_INLINE] = (u8)Len;
+    } else {
+        Str->Heap.Length = (u32)Len;
+    }
+}
+
+void SsoStringCpy(sso_string* Dst, const char* Src, i64 Len, Stack_Allocator* a) {
+    // Short text goes back inline, unless there is a buffer of our own to
+    // reuse. Src can be Dst's own text, hence the memmove
+    //
+    if( Len <= SSO_STRING_INLINE && (SsoStringIsInline(Dst) || Dst->Heap.Capacity == 0) ) {
+        memmove(Dst->Inline, Src, Len);
+        Dst->Inline[SSO_STRING_INLINE] = (u8)Len;
+        return;
+    }
+    if( !SsoStringReserve(Dst, Len, 0, a) ) {
+        return;
+    }
+    memmove((u8*)SsoStringData(Dst), Src, Len);
+    SsoStringSetLength(Dst, Len);
+}
+
+void SsoStringAppend(sso_string* Dst, const char* Str, i64 Len, Stack_Allocator* a) {
+    i64 Old = SsoStringLength(Dst);
+    if( Len <= 0 ) {
+        return;
+    }
+    // Borrowed text has no room, so this is also where it gets copied
+    //
+    if( !SsoStringReserve(Dst, Old + Len, Old, a) ) {
+        return;
+    }
+    memcpy((u8*)SsoStringData(Dst) + Old, Str, Len);
+    SsoStringSetLength(Dst, Old + Len);
+}
+
+void SsoStringAppendStr(sso_string* Dst, U8_String* Str, Stack_Allocator* a) {
+    SsoStringAppend(Dst, (const char*)Str->data, Str->idx, a);
+}
+
 #endif
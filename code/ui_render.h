@@ -173,8 +173,12 @@ fn_internal ucf_gui UIRender_Start(vulkan_base* VkBase) {
     //
     Arena *main_arena = VkBase->Arena;
 
+    // Traced builds record what the stacks hand out, not the buffers behind them
+    //
+    AllocTraceMute();
     u8 *Buffer = PushArray(main_arena, u8, gigabyte(1));
     u8 *TempBuffer = PushArray(main_arena, u8, gigabyte(1));
+    AllocTraceUnmute();
     stack_init(&GUI.Allocator, Buffer, gigabyte(1));
     stack_init(&GUI.TempAllocator, TempBuffer, gigabyte(1));
 
@@ -420,9 +424,9 @@ fn_internal void UIRender_Frame(ucf_gui* GUI) {
 	vulkan_base* VkBase = Render->VulkanBase;
 	draw_bucket_instance* DrawInstance = &GUI->DrawInstance;
 
-	vk_image* ComputeImage = (vk_image*)HashTableGet(&Render->Textures, GUI->ComputeTextureHandle, 0);
-	vk_image* FontTexture  = (vk_image*)HashTableGet(&Render->Textures, GUI->FontTextureHandle, 0);
-	vk_image* IconTexture  = (vk_image*)HashTableGet(&Render->Textures, GUI->IconsTextureHandle, 0);
+	vk_image* ComputeImage = (vk_image*)R_SlotMapGet(&Render->Textures, GUI->ComputeTextureHandle);
+	vk_image* FontTexture  = (vk_image*)R_SlotMapGet(&Render->Textures, GUI->FontTextureHandle);
+	vk_image* IconTexture  = (vk_image*)R_SlotMapGet(&Render->Textures, GUI->IconsTextureHandle);
 
 	u32 window_width  = Render->VulkanBase->Window.Width;
 	u32 window_height = Render->VulkanBase->Window.Height;
@@ -494,7 +498,7 @@ fn_internal void UIRender_Frame(ucf_gui* GUI) {
 			VK_IMAGE_LAYOUT_UNDEFINED,
 			VK_IMAGE_LAYOUT_GENERAL
 		);
-		R_BindTexture(Render, "Compute Texture", 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+		R_BindTexture(Render, GUI->ComputeTextureHandle, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
 		R_DispatchCompute(Render, GUI->ComputePipelineHandle, ceilf(window_width / 32), ceilf(window_height / 32), 1);
 	}
 
@@ -506,9 +510,9 @@ fn_internal void UIRender_Frame(ucf_gui* GUI) {
 
 	R_BeginRenderPass(Render);
 	{
-		R_BindTexture(Render, "Fonts Atlas", 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-		R_BindTexture(Render, "Icon Atlas", 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-		R_UpdateUniformBuffer(Render, "Uniform Buffer", 1, &GUI->UniformData, sizeof(ui_uniform));
+		R_BindTexture(Render, GUI->FontTextureHandle, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+		R_BindTexture(Render, GUI->IconsTextureHandle, 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+		R_UpdateUniformBuffer(Render, GUI->UBuffer, 1, &GUI->UniformData, sizeof(ui_uniform));
 		R_BindVertexBuffer(Render, GUI->VBuffer[Render->VulkanBase->CurrentFrame]);
 		R_BindIndexBuffer(Render, GUI->IBuffer[Render->VulkanBase->CurrentFrame]);
 		R_SetPipeline(Render, GUI->PipelineHandle);
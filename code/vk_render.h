@@ -744,6 +744,17 @@ fn_internal VkDescriptorSet DescriptorSetAllocate(VkDescriptorPool* Pool, VkDevi
 	*/
 fn_internal descriptor_writer DescriptorWriterInit(u32 capacity, Stack_Allocator* Allocator);
 
+/** \brief Initializes a descriptor writer on an arena
+	*
+	*  Same as above but takes its buffers from an arena, meant for the
+	*  per-thread scratch arenas returned by GetScratch.
+	*
+	*  \param capacity Maximum number of descriptors to support
+	*  \param Scratch Arena the writer buffers are pushed onto
+	*  \return Initialized descriptor_writer structure
+	*/
+fn_internal descriptor_writer DescriptorWriterInit(u32 capacity, Arena* Scratch);
+
 /** \brief Clears a descriptor writer
 	*
 	*  Resets the descriptor writer to an empty state, removing all pending writes.
@@ -1197,9 +1208,14 @@ fn_internal vulkan_base
 	VulkanInit() {
     vulkan_base Base = {};
 
-    Base.Arena = ArenaAllocDefault();
+    // The draw buckets and the UI object store end up in this arena, back it
+    // with huge pages so streaming through them doesn't thrash the TLB
+    //
+    Base.Arena = ArenaAllocEx(DEFAULT_RESERVE, ARENA_FLAG_HUGE_HINT);
+    AllocTraceMute();
     u8* data     = PushArray(Base.Arena, u8, mebibyte(256));
     u8* TempData = PushArray(Base.Arena, u8, mebibyte(256));
+    AllocTraceUnmute();
     stack_init(&Base.Allocator, data, mebibyte(256));
     stack_init(&Base.TempAllocator, TempData, mebibyte(256));
     VkDebugUtilsMessengerCreateInfoEXT DebugCreateInfo = {};
@@ -2307,6 +2323,22 @@ fn_internal descriptor_writer
     return Writer;
 }
 
+fn_internal descriptor_writer
+	DescriptorWriterInit(u32 capacity, Arena* Scratch) {
+    descriptor_writer Writer = {};
+
+    Writer.Allocator = NULL;
+    Writer.ImageInfosBuffer  = PushArray(Scratch, VkDescriptorImageInfo, capacity);
+    Writer.BufferInfosBuffer = PushArray(Scratch, VkDescriptorBufferInfo, capacity);
+    Writer.WritesBuffer      = PushArray(Scratch, VkWriteDescriptorSet, capacity);
+
+    Writer.ImageInfos  = QueueInit(Writer.ImageInfosBuffer,  0, capacity, sizeof(VkDescriptorImageInfo));
+    Writer.BufferInfos = QueueInit(Writer.BufferInfosBuffer, 0, capacity, sizeof(VkDescriptorBufferInfo));
+    Writer.Writes      = VectorNew(Writer.WritesBuffer, 0, capacity, VkWriteDescriptorSet);
+
+    return Writer;
+}
+
 fn_internal void
 	DescriptorWriterClear(descriptor_writer* dw) {
     VectorClear(&dw->Writes);